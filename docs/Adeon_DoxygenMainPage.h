@@ -30,3 +30,10 @@
  * parameters via SMS in case that the SMS has been sent by authorized user (from authorized phone number) 
  * with sufficient user rights.
  */
+
+/**
+ * @example BufferSizing.ino
+ *
+ * This example demonstrates sizing of Adeon and GSM buffers at compile time
+ * and prints RAM footprint of each configuration.
+ */
@@ -2,6 +2,7 @@
  * @brief This example demonstrates advanced processing of the incoming SMS message in the 
  * Adeon format. The target is to set the values of defined parameters via SMS in case that
  * the SMS has been sent by authorized user (from authorized phone number).
+ * Relay can be closed for a time, e.g. by "RELAY = 1 for 5;", it opens again after 5 seconds.
  * 
  *  Copyright (c) 2019 JSC electronics
  *
@@ -41,9 +42,8 @@
     #define LED_OFF         LOW   
 #endif
 
-#define T_PERIOD            1000
-
 Adeon adeon = Adeon();
+TimerWheel timerWheel; // timed edits of parameters
 /*GSM Class serial setup
 SoftwareSerial default setting for Arduino AVR ATmega328p boards – RX 10, TX 11, BAUD 9600
 SoftwareSerial default setting for ESP8266 boards – RX 14, TX 12, BAUD 9600
@@ -51,17 +51,14 @@ HardwareSerial default setting for Arduino AVR ATmega2560 boards – Serial2, BA
 HardwareSerial default setting for ESP32 boards – Serial2, RX 16, TX 17, BAUD 9600
 */
 GSM gsm = GSM();
-
-uint16_t counter = 0;
-uint32_t tFlag = 0;
-uint32_t tNow = 0;
+ModemHealth health; // latency of AT commands, modem is reset when it stops answering
+volatile bool resetGsm = false;
 
 char pnHost[LIST_ITEM_LENGTH];
 char pnUser[LIST_ITEM_LENGTH];
 char pnAdmin[LIST_ITEM_LENGTH];
 
 char parRelay[LIST_ITEM_LENGTH];
-char parClose[LIST_ITEM_LENGTH];
 char parAccess[LIST_ITEM_LENGTH];
 
 char* msgBuf; 
@@ -71,10 +68,10 @@ void setStrings();
 void numOfItems();
 void callbackRel(uint16_t val);
 void accessManagement(uint16_t val);
-void closingHandler();
 void userInit();
 void paramInit();
 void processMsg();
+void onHealth(HealthState state, void* pContext);
 
 void setStrings(){
   //ADD YOUR NUMBER IN HERE
@@ -83,7 +80,6 @@ void setStrings(){
     strcpy(pnHost, "420333333333");
 
     strcpy(parRelay, "RELAY");
-    strcpy(parClose, "CLOSE");
     strcpy(parAccess, "ACCESS");
 }
 
@@ -129,25 +125,6 @@ void accessManagement(uint16_t val){
     }
 }
 
-void closingHandler(){
-    tNow = millis();
-    if(tNow - tFlag > T_PERIOD){
-        if(adeon.getParamValue(parRelay) == 1){
-            if(adeon.getParamValue(parClose) > counter){
-                counter++;
-            }
-            else{
-                adeon.editParamValue(parRelay, 0);
-                adeon.printParams();
-            }
-        }
-        else{
-            counter = 0;
-        }
-        tFlag = millis();   
-    }
-}
-
 void userInit(){
     //add users with ADMIN, USER or HOST rights
     adeon.addUser(pnAdmin, ADEON_ADMIN);
@@ -159,7 +136,6 @@ void userInit(){
 void paramInit(){
     //add parameters
     adeon.addParamWithCallback(callbackRel, parRelay, 0);
-    adeon.addParam(parClose, 5);
     adeon.addParamWithCallback(accessManagement, parAccess, 0);
     adeon.printParams();
 }
@@ -184,6 +160,13 @@ void processMsg(){
     }
 }
 
+void onHealth(HealthState state, void* pContext){
+    //called inside GSM, the modem is reset in loop()
+    if(state == HealthState::UNRESPONSIVE){
+        resetGsm = true;
+    }
+}
+
 void setup() {
     // Setup the Serial port. See http://arduino.cc/en/Serial/IfSerial
     Serial.begin(DEFAULT_BAUD_RATE);
@@ -194,13 +177,19 @@ void setup() {
     digitalWrite(LED, LED_OFF);
     digitalWrite(RELAY, HIGH);
 
-    gsm.begin();
+    // Modem may still be configured from before the reset of the board, so only its state
+    // is queried. begin() gives up after a few tries, so it is repeated until GSM is ready.
+    while(gsm.begin(true) != GSM::BeginStatus::OK){
+        delay(1000);
+    }
 
     setStrings();
     userInit();
     paramInit();
-    numOfItems();    
-    tFlag = millis();
+    numOfItems();
+    adeon.setTimerWheel(&timerWheel);
+    health.setHealthHandler(onHealth);
+    gsm.setHealthMonitor(&health);
 }
 
 void loop() {
@@ -210,5 +199,10 @@ void loop() {
         msgBuf = gsm.getMsg();
         processMsg();
     }
-    closingHandler();
+    adeon.tick(); //timed edits, e.g. opening of the relay
+    if(resetGsm && gsm.begin() == GSM::BeginStatus::OK){
+        Serial.println(F("GSM RESET"));
+        resetGsm = false;
+        health.reset();
+    }
 }
@@ -0,0 +1,75 @@
+/**
+ * @brief This example demonstrates sizing of Adeon and GSM buffers at compile time.
+ * The same sketch can be tuned for boards with 2 KB of RAM (ATmega328P) as well as for
+ * gateways which need long concatenated commands (ESP32). RAM footprint of each
+ * configuration is printed to the serial terminal.
+ * 
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+
+// Default configuration, identical to Adeon and GSM
+using DefaultAdeon = BasicAdeon<>;
+using DefaultGSM = BasicGSM<>;
+
+// Small configuration – short messages, few parameters (ATmega328P)
+using SmallAdeon = BasicAdeon<64, 12, SHORT_HASH_LENGTH, 8>;
+using SmallGSM = BasicGSM<96, 72, 14>;
+
+// Large configuration – long concatenated commands (ESP32 gateway)
+using LargeAdeon = BasicAdeon<600, 24, SHORT_HASH_LENGTH, LIST_CAPACITY>;
+using LargeGSM = BasicGSM<1024, 607, 20>;
+
+SmallAdeon adeon;
+
+void printSize(const __FlashStringHelper* name, size_t size);
+
+void printSize(const __FlashStringHelper* name, size_t size){
+    Serial.print(name);
+    Serial.print(F(": "));
+    Serial.print(size);
+    Serial.println(F(" B"));
+}
+
+void setup() {
+    // Setup the Serial port. See http://arduino.cc/en/Serial/IfSerial
+    Serial.begin(115200);
+    while (!Serial) { ; // wait for serial port to connect. Needed for Leonardo only
+    }
+
+    Serial.println(F("*** DEFAULT ***"));
+    printSize(F("Adeon"), sizeof(DefaultAdeon));
+    printSize(F("GSM"), sizeof(DefaultGSM));
+
+    Serial.println(F("*** SMALL ***"));
+    printSize(F("Adeon"), sizeof(SmallAdeon));
+    printSize(F("GSM"), sizeof(SmallGSM));
+
+    Serial.println(F("*** LARGE ***"));
+    printSize(F("Adeon"), sizeof(LargeAdeon));
+    printSize(F("GSM"), sizeof(LargeGSM));
+    Serial.println();
+
+    // Configured instance is used the same way as Adeon
+    adeon.addUser("420123456789", ADEON_ADMIN);
+    adeon.addParam("RELAY", 0);
+    adeon.printParams();
+}
+
+void loop() {
+}
@@ -47,6 +47,14 @@ HardwareSerial default setting for Arduino AVR ATmega2560 boards – Serial2, BA
 HardwareSerial default setting for ESP32 boards – Serial2, RX 16, TX 17, BAUD 9600
 */
 GSM gsm = GSM();
+//drops messages of senders which exceed 3 SMS at once and 1 SMS per minute
+RateLimiter rateLimiter;
+//rejects message repeated by the same sender within one minute
+DuplicateFilter duplicateFilter;
+//messages of the library wait here, so SMS processing does not wait for slow Serial
+LogBuffer logBuffer;
+
+Adeon::ParamHandle ledParam;
 
 char* msgBuf; 
 char* pnBuf; 
@@ -68,7 +76,8 @@ void numOfItems(){
 }
 
 void ledControl(){
-    (adeon.getParamValue("LED") == 0) ? digitalWrite(LED, LED_OFF) : digitalWrite(LED, LED_ON);
+    //handle is resolved once in paramInit, so no name search is done in every loop
+    (adeon.getParamValue(ledParam) == 0) ? digitalWrite(LED, LED_OFF) : digitalWrite(LED, LED_ON);
 }
 
 void callbackRel(uint16_t val){
@@ -90,6 +99,7 @@ void userInit(){
 void paramInit(){
     //add parameters
     adeon.addParam("LED", 0);
+    ledParam = adeon.handle("LED");
     adeon.addParamWithCallback(callbackRel, "RELAY", 0);
     adeon.setParamAccess("RELAY", ADEON_USER);
     adeon.printParams();
@@ -103,7 +113,7 @@ void processMsg(){
             Serial.println(F("PHONE NUMBER IS AUTHORIZED"));
             Serial.println(msgBuf);
             //parameters are parsed and their values are saved into list
-            adeon.parseBuf(msgBuf, adeon.getUserRightsLevel(pnBuf));
+            adeon.parseBuf(msgBuf, adeon.getUserRightsLevel(pnBuf), pnBuf);
             adeon.printParams();
         }
         else {
@@ -119,6 +129,7 @@ void setup() {
     // Setup the Serial port. See http://arduino.cc/en/Serial/IfSerial
     Serial.begin(DEFAULT_BAUD_RATE);
     delay(200);
+    AdeonLog::setSink(&logBuffer);
 
     pinMode(LED, OUTPUT);
     pinMode(RELAY, OUTPUT);
@@ -126,9 +137,11 @@ void setup() {
     digitalWrite(RELAY, HIGH);
         
     gsm.begin();
+    gsm.setRateLimiter(&rateLimiter);
 
     userInit();
     paramInit();
+    adeon.setDuplicateFilter(&duplicateFilter);
     numOfItems();    
 }
 
@@ -140,4 +153,6 @@ void loop() {
         processMsg();
     }
     ledControl();
+    //finished lines are written only while Serial has free space
+    logBuffer.pump(Serial);
 }
@@ -0,0 +1,154 @@
+/**
+ *  @file       AuditOverhead.cpp
+ *  Project     AdeonGSM
+ *  @brief      Cost of audit log on the path of parseBuf()
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Message from a user edits EDITS of PARAMS parameters, one of them without access.
+ * parseBuf() is timed without audit log, with AuditLog (16 records, it wraps many times)
+ * and with BasicAuditLog<256>. Time of append() alone is reported as well.
+ * Then the log is dumped as CSV and binary, binary dump is restored into another log
+ * and compared. Memory of the Adeon heap must not change when the log is set.
+ * Exit code is non-zero if a record is missing or differs after restore.
+ *
+ * Usage: AuditOverhead [repeats]
+ * Default: 20000 repeats.
+ */
+
+#include <AdeonGSM.h>
+#include <chrono>
+#include <string>
+#include "../common/SimModem.h"
+
+constexpr static auto PARAMS = 20;
+constexpr static auto EDITS = 8;
+static const char* sender = "+420603000001";
+
+/**
+ * @brief Stream kept in memory, e.g. in place of a file.
+ */
+class MemoryStream : public Stream {
+    public:
+        size_t write(uint8_t c) override {
+            _data.push_back((char)c);
+            return 1;
+        }
+        int available() override {
+            return (int)(_data.size() - _pos);
+        }
+        int read() override {
+            return (_pos < _data.size()) ? (uint8_t)_data[_pos++] : -1;
+        }
+        int peek() override {
+            return (_pos < _data.size()) ? (uint8_t)_data[_pos] : -1;
+        }
+        size_t size(){
+            return _data.size();
+        }
+
+    private:
+        std::string _data;
+        size_t _pos = 0;
+};
+
+static double measure(AdeonBase& adeon, const char* msg, unsigned long repeats){
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats; i++){
+        adeon.parseBuf(msg, ADEON_USER, sender);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+static bool isSame(AuditLogBase& first, AuditLogBase& second){
+    AuditRecord a, b;
+    if(first.getCount() != second.getCount()){
+        return false;
+    }
+    for(uint16_t i = 0; first.getRecord(i, &a) && second.getRecord(i, &b); i++){
+        if(a.senderKey != b.senderKey || a.time != b.time || a.param != b.param || a.oldVal != b.oldVal
+           || a.newVal != b.newVal || a.result != b.result){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    unsigned long repeats = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    if(repeats == 0){
+        fprintf(stderr, "repeats must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+
+    Adeon adeon;
+    adeon.addUser(sender, ADEON_USER);
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.addParam(name, 0);
+        adeon.setParamAccess(name, (i == 0) ? ADEON_ADMIN : ADEON_USER);
+    }
+    char payload[MSG_BUFFER_LENGTH];
+    char item[24];
+    payload[0] = '\0';
+    for(uint8_t i = 0; i < EDITS; i++){
+        snprintf(item, sizeof(item), "relay%02u = %u;", i * 2, i + 1);
+        strcat(payload, item);
+    }
+    char msg[MSG_BUFFER_LENGTH + 1];
+    makeAdeonMsg(msg, sizeof(msg), payload);
+
+    size_t heapBefore = adeon.memoryStats().bytesInUse;
+    double plainTime = measure(adeon, msg, repeats);
+    AuditLog smallLog;
+    adeon.setAuditLog(&smallLog);
+    double smallTime = measure(adeon, msg, repeats);
+    BasicAuditLog<256> largeLog;
+    adeon.setAuditLog(&largeLog);
+    double largeTime = measure(adeon, msg, repeats);
+    bool failed = adeon.memoryStats().bytesInUse != heapBefore;
+    failed |= largeLog.getStats().appended != repeats * EDITS || largeLog.getCount() != 256;
+
+    BasicAuditLog<256> scratch;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats * EDITS; i++){
+        scratch.append(i, (uint8_t)i, 0, 1, AuditResult::APPLIED);
+    }
+    double appendTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+                        / (repeats * EDITS);
+
+    MemoryStream csv;
+    MemoryStream binary;
+    largeLog.dumpCsv(csv);
+    largeLog.dumpBinary(binary);
+    BasicAuditLog<256> restored;
+    failed |= restored.restore(binary) != largeLog.getCount() || !isSame(largeLog, restored);
+
+    printf("%u edits per message, one denied\n", EDITS);
+    printf("%-22s %10s\n", "audit log", "ns/msg");
+    printf("%-22s %10.0f\n", "none", plainTime);
+    printf("%-22s %10.0f\n", "AuditLog (16)", smallTime);
+    printf("%-22s %10.0f\n", "BasicAuditLog<256>", largeTime);
+    printf("append() alone: %.1f ns\n", appendTime);
+    printf("dump of %u records: CSV %zu B, binary %zu B, restored %s\n", largeLog.getCount(), csv.size(),
+           binary.size(), failed ? "FAILED" : "equal");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+/**
+ *  @file       BaudUpgrade.cpp
+ *  Project     AdeonGSM
+ *  @brief      Baud rate negotiation by AT+IPR
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * GSM::begin() with setTargetBaud(115200) against the simulated modem which models
+ * link speed, on virtual clock. Reported are duration of begin(), negotiated rate and
+ * mean time to read and delete SMS delivered one after another:
+ *  - fixed:       no negotiation, 9600 baud
+ *  - upgrade:     modem accepts 115200
+ *  - modem max:   modem refuses rates above 57600
+ *  - rx limit:    host receives correctly only up to 38400 (SoftwareSerial like)
+ *  - board reset: modem kept 115200, board starts at 9600
+ *
+ * Usage: BaudUpgrade [messages]
+ * Default: 10 messages. Exit code is non-zero if a link is lost or rate is not as expected.
+ */
+
+#include <utility/SIMlib.h>
+#include "../common/SimModem.h"
+
+static const char* sender = "420598632485";
+
+static bool setSimBaud(long baud, void* pContext){
+    ((SimModem*)pContext)->setHostBaud(baud);
+    return true;
+}
+
+static bool run(const char* scenario, long modemBaud, long maxBaud, long receiveLimit,
+                long targetBaud, long expectedBaud, uint8_t messages){
+    SimModem modem;
+    modem.modelLink(modemBaud, maxBaud);
+    modem.setHostBaud(DEFAULT_BAUD_RATE);
+    modem.setReceiveLimit(receiveLimit);
+    GSM gsm(&modem);
+    gsm.setBaudHandler(setSimBaud, &modem);
+    gsm.setTargetBaud(targetBaud);
+
+    unsigned long start = millis();
+    bool ready = gsm.begin() == GSM::BeginStatus::OK;
+    unsigned long beginTime = millis() - start;
+
+    char msg[MSG_LENGTH];
+    makeAdeonMsg(msg, sizeof(msg), "Relay = 1; Heater = 21; Pump = 0; Valve = 3; Mode = 2; Alarm = 1; Led = 7;");
+    start = millis();
+    uint8_t received = 0;
+    for(uint8_t i = 0; ready && i < messages; i++){
+        modem.deliverSms(sender, msg);
+        unsigned long sent = millis();
+        while(!gsm.isNewMsgAvailable() && millis() - sent < 5000){
+            delay(COMMAND_POLL_TIME);
+            gsm.checkGsmOutput();
+        }
+        if(gsm.isNewMsgAvailable()){
+            gsm.getMsg();
+            received++;
+        }
+        while(gsm.isBusy() || modem.getStoredSms() != 0){
+            delay(COMMAND_POLL_TIME);
+            gsm.checkGsmOutput();
+        }
+    }
+    unsigned long smsTime = received ? (millis() - start) / received : 0;
+
+    bool ok = ready && received == messages && gsm.getBaud() == expectedBaud && modem.getBaud() == expectedBaud;
+    printf("%-12s %8lu %8ld %5u/%-5u %10lu   %s\n", scenario, beginTime, gsm.getBaud(),
+           received, messages, smsTime, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv){
+    unsigned long messages = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 10;
+    if(messages == 0 || messages > SIM_MODEM_SLOTS){
+        fprintf(stderr, "messages must be 1 to %d\n", SIM_MODEM_SLOTS);
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    printf("%-12s %8s %8s %11s %10s\n", "scenario", "begin ms", "baud", "received", "ms per SMS");
+    bool ok = true;
+    ok &= run("fixed", 9600, 115200, 0, 0, 9600, messages);
+    ok &= run("upgrade", 9600, 115200, 0, 115200, 115200, messages);
+    ok &= run("modem max", 9600, 57600, 0, 115200, 57600, messages);
+    ok &= run("rx limit", 9600, 115200, 38400, 115200, 38400, messages);
+    ok &= run("board reset", 115200, 115200, 0, 115200, 115200, messages);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/**
+ *  @file       BeginTime.cpp
+ *  Project     AdeonGSM
+ *  @brief      Cold and warm start time of GSM::begin()
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Time of GSM::begin() on virtual clock with the simulated modem:
+ *  - configured: modem kept running, only MCU has been restarted
+ *  - power-on:   modem boots for 3 s, then starts with radio off and PDU mode
+ *  - offline:    modem never answers, begin() has to give up
+ * Each is started cold (all settings sent) and warm (state queried first).
+ *
+ * Usage: BeginTime
+ * Exit code is non-zero if begin() fails with an answering modem.
+ */
+
+#include <utility/SIMlib.h>
+#include "../common/SimModem.h"
+
+constexpr static unsigned long BOOT_TIME = 3000; //ms
+constexpr static unsigned long NEVER = 0x40000000UL; //ms
+
+static const char* statusName(GSM::BeginStatus status){
+    switch(status){
+    case GSM::BeginStatus::OK:
+        return "ok";
+    case GSM::BeginStatus::OFFLINE:
+        return "offline";
+    case GSM::BeginStatus::CONFIG_FAILED:
+        return "config failed";
+    default:
+        return "text mode failed";
+    }
+}
+
+static bool run(const char* scenario, unsigned long bootTime, bool warmStart){
+    SimModem modem;
+    if(bootTime != 0){
+        modem.powerOn(bootTime);
+    }
+    GSM gsm(&modem);
+    unsigned long start = millis();
+    GSM::BeginStatus status = gsm.begin(warmStart);
+    printf("%-11s %-5s %8lu %9lu   %s\n", scenario, warmStart ? "warm" : "cold",
+           millis() - start, (unsigned long)modem.getCommandCount(), statusName(status));
+    return status == GSM::BeginStatus::OK;
+}
+
+int main(){
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    printf("%-11s %-5s %8s %9s   %s\n", "modem", "start", "time ms", "commands", "status");
+    bool ok = true;
+    ok &= run("configured", 0, false);
+    ok &= run("configured", 0, true);
+    ok &= run("power-on", BOOT_TIME, false);
+    ok &= run("power-on", BOOT_TIME, true);
+    run("offline", NEVER, false);
+    return ok ? 0 : 1;
+}
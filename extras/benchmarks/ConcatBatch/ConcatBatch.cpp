@@ -0,0 +1,236 @@
+/**
+ *  @file       ConcatBatch.cpp
+ *  Project     AdeonGSM
+ *  @brief      Parameter batch in one concatenated SMS
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Batch of PARAMS parameter edits delivered on virtual clock:
+ *  - separate: batch split into SMS of one Adeon message each, every SMS has its own hash
+ *  - concat:   whole batch in one Adeon message sent as concatenated SMS and reassembled
+ *              by Concat, hash is computed while parts are coming
+ *
+ * Reports virtual time from delivery to the last applied value, AT commands and SMS count.
+ * Then compares CPU time of parseBuf() of the long message given as string (hashed at once)
+ * and of reassembly plus parseBuf(concat), and shows cost of MD5 of the whole text. The last run loses one part in the network,
+ * incomplete message has to time out and the next batch has to be applied.
+ * Exit code is non-zero if a value is not applied or the lost part is not detected.
+ *
+ * Usage: ConcatBatch [repeats]
+ * Default: 20000 repeats of the CPU comparison.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include <chrono>
+#include "../common/SimModem.h"
+
+constexpr static auto PARAMS = 30;
+constexpr static auto BATCH_LENGTH = CONCAT_LENGTH;
+constexpr static auto SEPARATE_PAYLOAD = MSG_BUFFER_LENGTH - SHORT_HASH_LENGTH - 2;
+constexpr static unsigned long RUN_LIMIT = 120000; //ms
+
+static const char* sender = "420598632485";
+
+struct Result {
+    unsigned long duration = 0;
+    uint32_t commands = 0;
+    uint8_t sms = 0;
+    bool applied = false;
+    ConcatStats stats;
+};
+
+static void addParams(AdeonBase& adeon){
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.addParam(name, 0);
+    }
+}
+
+static bool isApplied(AdeonBase& adeon, uint8_t round){
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        if(adeon.getParamValue(name) != (uint16_t)((round + i) % 10)){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Payloads of the batch, one if it is not split.
+ */
+static uint8_t makePayloads(char payloads[][BATCH_LENGTH], uint8_t round, size_t maxLength){
+    uint8_t count = 0;
+    payloads[0][0] = '\0';
+    char item[24];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(item, sizeof(item), "relay%02u = %u;", i, (round + i) % 10);
+        if(strlen(payloads[count]) + strlen(item) > maxLength){
+            payloads[++count][0] = '\0';
+        }
+        strcat(payloads[count], item);
+    }
+    return count + 1;
+}
+
+static Result run(bool concatenated, uint8_t lostPart){
+    Result result;
+    SimModem modem;
+    BasicGSM<400> gsm(&modem);
+    Concat concat;
+    BasicAdeon<BATCH_LENGTH> adeon;
+    if(concatenated){
+        gsm.setConcat(&concat);
+        concat.setClock(millis);
+    }
+    gsm.begin();
+    addParams(adeon);
+
+    static char payloads[PARAMS][BATCH_LENGTH];
+    char msg[BATCH_LENGTH + 8];
+    uint8_t rounds = (lostPart != 0) ? 2 : 1;
+    unsigned long start = millis();
+    uint32_t commands = modem.getCommandCount();
+    for(uint8_t round = 1; round <= rounds; round++){
+        uint8_t count = makePayloads(payloads, round, concatenated ? BATCH_LENGTH : SEPARATE_PAYLOAD);
+        for(uint8_t i = 0; i < count; i++){
+            makeAdeonMsg(msg, sizeof(msg), payloads[i]);
+            if(concatenated){
+                result.sms += modem.deliverConcatSms(sender, msg, result.sms, (round == 1) ? lostPart : 0);
+            }
+            else{
+                result.sms += modem.deliverSms(sender, msg) ? 1 : 0;
+            }
+        }
+        unsigned long roundStart = millis();
+        //incomplete batch is waited for until the assembler drops it
+        unsigned long limit = (round < rounds) ? CONCAT_TIMEOUT + 1000 : RUN_LIMIT;
+        while(millis() - roundStart < limit && !(round == rounds && isApplied(adeon, round))){
+            delay(COMMAND_POLL_TIME);
+            gsm.checkGsmOutput();
+            if(gsm.isNewMsgAvailable()){
+                char* pMsg = gsm.getMsg();
+                if(concatenated){
+                    adeon.parseBuf(concat, ADEON_ADMIN, gsm.getPhoneNum());
+                }
+                else{
+                    adeon.parseBuf(pMsg, ADEON_ADMIN, gsm.getPhoneNum());
+                }
+            }
+        }
+        result.applied = isApplied(adeon, round);
+        if(round < rounds && result.applied){
+            break; // lost part was not noticed
+        }
+    }
+    result.duration = millis() - start;
+    result.commands = modem.getCommandCount() - commands;
+    result.stats = concat.getStats();
+    return result;
+}
+
+/**
+ * @brief Split Adeon message into parts of SIM_MODEM_PART_SEPTETS characters.
+ */
+static uint8_t splitMsg(const char* pMsg, char parts[][SIM_MODEM_PART_SEPTETS + 1]){
+    uint8_t count = 0;
+    for(size_t offset = 0; offset < strlen(pMsg); offset += SIM_MODEM_PART_SEPTETS){
+        snprintf(parts[count++], SIM_MODEM_PART_SEPTETS + 1, "%s", &pMsg[offset]);
+    }
+    return count;
+}
+
+int main(int argc, char** argv){
+    unsigned long repeats = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    if(repeats == 0){
+        fprintf(stderr, "repeats must be at least 1\n");
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+    bool failed = false;
+
+    printf("%-10s %8s %12s %8s %10s %9s %8s\n", "mode", "SMS", "duration ms", "AT cmds", "completed", "timed out", "applied");
+    static const char* names[] = {"separate", "concat", "concat*"};
+    for(uint8_t m = 0; m < 3; m++){
+        Result r = run(m > 0, (m == 2) ? 2 : 0);
+        printf("%-10s %8u %12lu %8lu %10lu %9lu %8s\n", names[m], r.sms, r.duration, (unsigned long)r.commands,
+               (unsigned long)r.stats.completed, (unsigned long)r.stats.timedOut, r.applied ? "yes" : "no");
+        failed |= !r.applied || (m == 2 && r.stats.timedOut != 1);
+    }
+    printf("* part 2 of the first batch is lost, it times out after %d ms\n\n", CONCAT_TIMEOUT);
+
+    //CPU time of the long message
+    static char payloads[PARAMS][BATCH_LENGTH];
+    char msg[BATCH_LENGTH + 8];
+    makePayloads(payloads, 1, BATCH_LENGTH);
+    makeAdeonMsg(msg, sizeof(msg), payloads[0]);
+    char parts[CONCAT_MAX_PARTS][SIM_MODEM_PART_SEPTETS + 1];
+    uint8_t count = splitMsg(msg, parts);
+
+    BasicAdeon<BATCH_LENGTH> adeon;
+    addParams(adeon);
+    Concat concat;
+    HostClock::useVirtual(false);
+
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats; i++){
+        adeon.parseBuf(msg, ADEON_ADMIN);
+    }
+    double whole = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeats;
+    failed |= !isApplied(adeon, 1);
+    adeon.editParamValue("relay00", 10);
+
+    double assemble = 0;
+    double parse = 0;
+    for(unsigned long i = 0; i < repeats; i++){
+        auto partsStart = std::chrono::steady_clock::now();
+        for(uint8_t p = 0; p < count; p++){
+            concat.add(sender, i & 0xFF, p + 1, count, parts[p]);
+        }
+        auto parseStart = std::chrono::steady_clock::now();
+        adeon.parseBuf(concat, ADEON_ADMIN);
+        auto parseEnd = std::chrono::steady_clock::now();
+        assemble += std::chrono::duration<double, std::nano>(parseStart - partsStart).count();
+        parse += std::chrono::duration<double, std::nano>(parseEnd - parseStart).count();
+    }
+    failed |= !isApplied(adeon, 1);
+
+    //hashing which parseBuf(concat) leaves out
+    MD5_CTX context;
+    unsigned char digest[16];
+    const char* pText = strchr(msg, ':') + 2;
+    start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats; i++){
+        MD5::MD5Init(&context);
+        MD5::MD5Update(&context, pText, strlen(pText));
+        MD5::MD5Final(digest, &context);
+    }
+    double hash = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+    printf("message of %u characters in %u parts\n", (unsigned)strlen(msg), count);
+    printf("parseBuf(string)          %8.0f ns\n", whole);
+    printf("add() of parts            %8.0f ns\n", assemble / repeats);
+    printf("parseBuf(concat)          %8.0f ns\n", parse / repeats);
+    printf("MD5 of whole text         %8.0f ns\n", hash);
+    return failed ? 1 : 0;
+}
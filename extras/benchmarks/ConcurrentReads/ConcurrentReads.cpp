@@ -0,0 +1,131 @@
+/**
+ *  @file       ConcurrentReads.cpp
+ *  Project     AdeonGSM
+ *  @brief      Stress test of lock-free parameter reads
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * One thread applies SMS which always set Alpha and Beta to the same value,
+ * another one edits Gamma and adds and deletes a temporary parameter.
+ * Reader threads read Alpha and Beta by readParams() and count torn reads
+ * (values from different messages). Separate getParamValue() calls are counted
+ * as well, they are expected to see different messages sometimes. Readers also read
+ * the temporary parameter while it is deleted.
+ * Library is built with ADEON_CONCURRENT, see Makefile.
+ *
+ * Usage: ConcurrentReads [seconds] [readers]
+ * Default: 2 seconds, 3 readers. Exit code is non-zero if a torn read is found.
+ */
+
+#include <AdeonGSM.h>
+#include "../common/SimModem.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+constexpr static auto MSG_VARIANTS = 64;
+
+static Adeon adeon;
+static std::atomic<bool> running(true);
+static std::atomic<uint64_t> reads(0);
+static std::atomic<uint64_t> torn(0);
+static std::atomic<uint64_t> separateMismatch(0);
+static std::atomic<uint64_t> applied(0);
+
+static void smsWriter(){
+    static char msgs[MSG_VARIANTS][MSG_BUFFER_LENGTH];
+    for(uint16_t i = 0; i < MSG_VARIANTS; i++){
+        char payload[48];
+        snprintf(payload, sizeof(payload), "Alpha = %u;Beta = %u;", i + 1, i + 1);
+        makeAdeonMsg(msgs[i], sizeof(msgs[i]), payload);
+    }
+    uint32_t n = 0;
+    while(running){
+        adeon.parseBuf(msgs[n++ % MSG_VARIANTS], ADEON_ADMIN);
+        applied++;
+    }
+}
+
+static void editWriter(){
+    Adeon::ParamHandle gamma = adeon.handle("Gamma");
+    uint16_t n = 0;
+    while(running){
+        adeon.editParamValue(gamma, n++);
+        if((n & 0xFF) == 0){
+            adeon.addParam("Tmp", n);
+            adeon.deleteParam("Tmp");
+        }
+    }
+}
+
+static void reader(){
+    Adeon::ParamHandle handles[2] = {adeon.handle("Alpha"), adeon.handle("Beta")};
+    uint16_t values[2];
+    while(running){
+        adeon.readParams(handles, values, 2);
+        if(values[0] != values[1]){
+            torn++;
+        }
+        if(adeon.getParamValue(handles[0]) != adeon.getParamValue(handles[1])){
+            separateMismatch++;
+        }
+        if((reads++ & 0xFF) == 0){
+            Adeon::ParamHandle tmp = adeon.handle("Tmp");
+            adeon.getParamValue(tmp);
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    unsigned long seconds = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 2;
+    unsigned long numOfReaders = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 3;
+
+    Serial.mute(true);
+    adeon.addParam("Alpha", 0);
+    adeon.addParam("Beta", 0);
+    adeon.addParam("Gamma", 0);
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(smsWriter);
+    threads.emplace_back(editWriter);
+    for(unsigned long i = 0; i < numOfReaders; i++){
+        threads.emplace_back(reader);
+    }
+    delay(seconds * 1000);
+    running = false;
+    for(std::thread& t : threads){
+        t.join();
+    }
+    adeon.deleteList();
+
+    #ifdef ADEON_CONCURRENT
+    printf("concurrent mode: on\n");
+    #else
+    printf("concurrent mode: off\n");
+    #endif
+    printf("messages applied: %llu\n", (unsigned long long)applied.load());
+    printf("snapshot reads:   %llu, torn: %llu\n", (unsigned long long)reads.load(), (unsigned long long)torn.load());
+    printf("separate reads seeing two messages: %llu (expected)\n", (unsigned long long)separateMismatch.load());
+    #ifdef ADEON_CONCURRENT
+    return torn == 0 ? 0 : 1;
+    #else
+    return 1;
+    #endif
+}
@@ -0,0 +1,152 @@
+/**
+ *  @file       GroupAccess.cpp
+ *  Project     AdeonGSM
+ *  @brief      Cost and correctness of group access checks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * USERS users and PARAMS parameters named like "relay00". Parameter i belongs
+ * to group i % GROUPS, every fifth parameter also to the shared group.
+ * User u is member of group u % GROUPS and users with even u also of the shared group.
+ *
+ * Each user sends packed message editing all parameters, applied edits are compared
+ * with the AND of masks. Then parseBuf() is timed per edit:
+ *  - levels:  parameters are not restricted to groups (ADEON_GROUP_ALL)
+ *  - groups:  masks above, sender of the shared group
+ *  - lookup:  groups, sender is the last one of USERS users
+ * Exit code is non-zero if an edit is applied or rejected against the masks.
+ *
+ * Usage: GroupAccess [repeats]
+ * Default: 20000 repeats.
+ */
+
+#include <AdeonGSM.h>
+#include <chrono>
+#include "../common/SimModem.h"
+
+constexpr static auto USERS = 16;
+constexpr static auto PARAMS = 40;
+constexpr static auto GROUPS = 4;
+constexpr static uint16_t SHARED_GROUP = 1 << GROUPS;
+constexpr static auto PAYLOAD_LENGTH = MSG_BUFFER_LENGTH - SHORT_HASH_LENGTH - 2;
+
+static uint16_t paramGroups(uint8_t index){
+    return (1 << (index % GROUPS)) | ((index % 5 == 0) ? SHARED_GROUP : 0);
+}
+
+static uint16_t userGroups(uint8_t user){
+    return (1 << (user % GROUPS)) | ((user % 2 == 0) ? SHARED_GROUP : 0);
+}
+
+static void userPhone(char* pOut, uint8_t user){
+    snprintf(pOut, LIST_ITEM_LENGTH, "+4206030000%02u", user);
+}
+
+static void makePacked(char* pOut, uint16_t val){
+    PackedWriter writer(pOut, PAYLOAD_LENGTH + 1);
+    for(uint8_t i = 0; i < PARAMS; i++){
+        writer.add(i, val);
+    }
+    writer.get();
+}
+
+static void setAll(AdeonBase& adeon, uint16_t val){
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.editParamValue(name, val);
+    }
+}
+
+static bool isMatching(AdeonBase& adeon, uint8_t user){
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        bool expected = (paramGroups(i) & userGroups(user)) != 0;
+        if((adeon.getParamValue(name) == 1) != expected){
+            return false;
+        }
+    }
+    return true;
+}
+
+static double measure(AdeonBase& adeon, const char* msg, const char* phone, unsigned long repeats){
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats; i++){
+        adeon.parseBuf(msg, ADEON_USER, phone);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+           / repeats / PARAMS;
+}
+
+int main(int argc, char** argv){
+    unsigned long repeats = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    if(repeats == 0){
+        fprintf(stderr, "repeats must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+
+    Adeon adeon;
+    char name[LIST_ITEM_LENGTH];
+    char phone[LIST_ITEM_LENGTH];
+    for(uint8_t u = 0; u < USERS; u++){
+        userPhone(phone, u);
+        adeon.addUser(phone, ADEON_USER);
+    }
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.addParam(name, 0);
+        adeon.setParamAccess(name, ADEON_USER);
+    }
+
+    char payload[PAYLOAD_LENGTH + 1];
+    char msg[MSG_BUFFER_LENGTH + 1];
+    makePacked(payload, 1);
+    makeAdeonMsg(msg, sizeof(msg), payload);
+
+    userPhone(phone, 0);
+    double levelsTime = measure(adeon, msg, phone, repeats);
+
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.setParamGroups(name, paramGroups(i));
+    }
+    uint8_t matching = 0;
+    for(uint8_t u = 0; u < USERS; u++){
+        userPhone(phone, u);
+        adeon.setUserGroups(phone, userGroups(u));
+        setAll(adeon, 0);
+        adeon.parseBuf(msg, ADEON_USER, phone);
+        matching += isMatching(adeon, u) ? 1 : 0;
+    }
+
+    userPhone(phone, 0);
+    double groupsTime = measure(adeon, msg, phone, repeats);
+    userPhone(phone, USERS - 1);
+    double lookupTime = measure(adeon, msg, phone, repeats);
+
+    printf("users %u, parameters %u, groups %u + shared\n", USERS, PARAMS, GROUPS);
+    printf("senders matching masks: %u/%u\n", matching, USERS);
+    printf("%-8s %8s\n", "access", "ns/edit");
+    printf("%-8s %8.0f\n", "levels", levelsTime);
+    printf("%-8s %8.0f\n", "groups", groupsTime);
+    printf("%-8s %8.0f\n", "lookup", lookupTime);
+    return (matching == USERS) ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/**
+ *  @file       GsmPoolScaling.cpp
+ *  Project     AdeonGSM
+ *  @brief      Throughput of many modems served by GsmPool
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Every simulated modem always has one SMS waiting, next one is delivered as soon
+ * as the previous is applied to the shared Adeon. Throughput is compared for:
+ *  - serial:  checkGsmOutput() of every GSM in turn (blocking, virtual clock)
+ *  - pool:    GsmPool::poll() in one loop (non-blocking, virtual clock)
+ *  - threads: GsmPool::start() with worker threads (real clock)
+ * Finally a running pool is destroyed without stop(), its destructor must join the workers.
+ * Exit code is non-zero if a pool without modems starts.
+ *
+ * Usage: GsmPoolScaling [virtual seconds] [real seconds]
+ * Default: 600 virtual seconds, 2 real seconds per configuration.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include <utility/gsmpool.h>
+#include "../common/SimModem.h"
+
+#include <mutex>
+
+constexpr static auto MAX_MODEMS = 16;
+constexpr static auto NUM_WORKERS = 4;
+
+static const char* sender = "420598632485";
+
+/**
+ * @brief Simulated modem which can be fed from another thread.
+ */
+class LockedModem : public Stream {
+    public:
+        bool deliverSms(const char* pSender, const char* pBody){
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.deliverSms(pSender, pBody);
+        }
+        uint8_t getStoredSms(){
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.getStoredSms();
+        }
+        int available() override {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.available();
+        }
+        int read() override {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.read();
+        }
+        int peek() override {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.peek();
+        }
+        size_t write(uint8_t c) override {
+            std::lock_guard<std::mutex> guard(_lock);
+            return _modem.write(c);
+        }
+        using Print::write;
+
+    private:
+        SimModem _modem;
+        std::mutex _lock;
+};
+
+enum class Mode { SERIAL, POOL, THREADS };
+
+struct Bench {
+    LockedModem modems[MAX_MODEMS];
+    GSM* gsm[MAX_MODEMS];
+    Adeon adeon;
+    BasicGsmPool<MAX_MODEMS> pool;
+    std::atomic<uint32_t> applied[MAX_MODEMS];
+    uint32_t delivered[MAX_MODEMS];
+};
+
+static void countApplied(uint8_t modem, const char* pPhoneNum, const char* pMsg, void* pContext){
+    (void)pPhoneNum;
+    (void)pMsg;
+    ((Bench*)pContext)->applied[modem]++;
+}
+
+/**
+ * @brief Deliver next SMS to every modem whose previous SMS is applied.
+ */
+static void feed(Bench& bench, uint8_t numOfModems){
+    for(uint8_t i = 0; i < numOfModems; i++){
+        if(bench.applied[i] == bench.delivered[i]){
+            char payload[32];
+            char msg[MSG_BUFFER_LENGTH];
+            snprintf(payload, sizeof(payload), "Relay%u = %u;", i, (unsigned)(bench.delivered[i] % 1000));
+            makeAdeonMsg(msg, sizeof(msg), payload);
+            bench.modems[i].deliverSms(sender, msg);
+            bench.delivered[i]++;
+        }
+    }
+}
+
+static double run(Mode mode, uint8_t numOfModems, unsigned long seconds){
+    Bench* pBench = new Bench();
+    Bench& bench = *pBench;
+    HostClock::useVirtual(mode != Mode::THREADS);
+
+    bench.adeon.addUser(sender, ADEON_ADMIN);
+    bench.pool.setMsgHandler(countApplied, pBench);
+    for(uint8_t i = 0; i < numOfModems; i++){
+        char name[LIST_ITEM_LENGTH];
+        snprintf(name, sizeof(name), "Relay%u", i);
+        bench.adeon.addParam(name, 0);
+        bench.gsm[i] = new GSM(&bench.modems[i]);
+        bench.pool.add(bench.gsm[i], &bench.adeon);
+        bench.applied[i] = 0;
+        bench.delivered[i] = 0;
+    }
+
+    unsigned long start = millis();
+    unsigned long duration = seconds * 1000UL;
+    if(mode == Mode::THREADS){
+        bench.pool.start(NUM_WORKERS);
+        while(millis() - start < duration){
+            feed(bench, numOfModems);
+            delay(1);
+        }
+        bench.pool.stop();
+    }
+    else{
+        while(millis() - start < duration){
+            feed(bench, numOfModems);
+            if(mode == Mode::SERIAL){
+                for(uint8_t i = 0; i < numOfModems; i++){
+                    bench.gsm[i]->checkGsmOutput();
+                    if(bench.gsm[i]->isNewMsgAvailable()){
+                        bench.adeon.parseBuf(bench.gsm[i]->getMsg(), ADEON_ADMIN, sender);
+                        bench.applied[i]++;
+                    }
+                }
+                delay(COMMAND_POLL_TIME);
+            }
+            else{
+                bench.pool.poll();
+                delay(COMMAND_POLL_TIME);
+            }
+        }
+    }
+
+    uint32_t total = 0;
+    for(uint8_t i = 0; i < numOfModems; i++){
+        total += bench.applied[i];
+    }
+    double elapsed = (millis() - start) / 1000.0;
+    // GSM objects are not destroyed, the library has no teardown of its heap objects
+    delete pBench;
+    return total / elapsed;
+}
+
+/**
+ * @brief Destroy pool whose workers are running.
+ * @return Number of SMS applied before the pool is destroyed.
+ */
+static uint32_t destroyRunning(){
+    Bench* pBench = new Bench();
+    Bench& bench = *pBench;
+    HostClock::useVirtual(false);
+
+    bench.adeon.addUser(sender, ADEON_ADMIN);
+    bench.pool.setMsgHandler(countApplied, pBench);
+    for(uint8_t i = 0; i < NUM_WORKERS; i++){
+        char name[LIST_ITEM_LENGTH];
+        snprintf(name, sizeof(name), "Relay%u", i);
+        bench.adeon.addParam(name, 0);
+        bench.gsm[i] = new GSM(&bench.modems[i]);
+        bench.pool.add(bench.gsm[i], &bench.adeon);
+        bench.applied[i] = 0;
+        bench.delivered[i] = 0;
+    }
+    bench.pool.start(NUM_WORKERS);
+    unsigned long start = millis();
+    while(millis() - start < 1000){
+        feed(bench, NUM_WORKERS);
+        delay(1);
+    }
+    uint32_t total = 0;
+    for(uint8_t i = 0; i < NUM_WORKERS; i++){
+        total += bench.applied[i];
+    }
+    delete pBench;
+    return total;
+}
+
+int main(int argc, char** argv){
+    unsigned long virtualSeconds = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 600;
+    unsigned long realSeconds = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 2;
+    const uint8_t counts[] = {1, 4, 16};
+
+    Serial.mute(true);
+    printf("%7s %12s %12s %12s   (SMS per second)\n", "modems", "serial", "pool", "threads");
+    for(uint8_t n : counts){
+        double serial = run(Mode::SERIAL, n, virtualSeconds);
+        double pool = run(Mode::POOL, n, virtualSeconds);
+        double threads = run(Mode::THREADS, n, realSeconds);
+        printf("%7u %12.2f %12.2f %12.2f\n", n, serial, pool, threads);
+    }
+    printf("running pool destroyed after %lu SMS\n", (unsigned long)destroyRunning());
+    GsmPool empty;
+    bool emptyStarted = empty.start(NUM_WORKERS);
+    printf("pool without modems %s\n", emptyStarted ? "STARTED" : "refused");
+    return emptyStarted ? 1 : 0;
+}
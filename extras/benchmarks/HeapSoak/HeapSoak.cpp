@@ -0,0 +1,206 @@
+/**
+ *  @file       HeapSoak.cpp
+ *  Project     AdeonGSM
+ *  @brief      Long-uptime heap fragmentation soak benchmark
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Pushes simulated SMS, user edits and parameter renames through GSM and Adeon
+ * while all library allocations are served by a small first-fit arena.
+ * Largest free block, fragmentation ratio and allocation failures are reported
+ * over time, so allocation-free rewrites can be compared against this baseline.
+ *
+ * Usage: HeapSoak [iterations] [heap bytes ...]
+ * Default: 1000000 iterations on 2048 and 8192 byte heaps.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include "../common/SimModem.h"
+#include "../common/FirstFitArena.h"
+
+constexpr static auto NUM_PARAMS = 6;
+constexpr static auto NUM_USERS = 4;
+constexpr static auto REPORTS = 10;
+
+static const char* sender = "420598632485";
+
+static uint32_t rngState = 2463534242UL;
+
+static uint32_t rnd(uint32_t range){
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % range;
+}
+
+static void randomName(char* pOut, uint8_t maxLen, char first){
+    uint8_t len = 1 + rnd(maxLen);
+    pOut[0] = first;
+    for(uint8_t i = 1; i < len; i++){
+        pOut[i] = 'a' + rnd(26);
+    }
+    pOut[len] = '\0';
+}
+
+static void randomPhone(char* pOut){
+    uint8_t len = 9 + rnd(6);
+    for(uint8_t i = 0; i < len; i++){
+        pOut[i] = '0' + rnd(10);
+    }
+    pOut[len] = '\0';
+}
+
+static unsigned long startTime = 0;
+
+static void report(unsigned long iteration, FirstFitArena& arena, Adeon& adeon, GSM& gsm){
+    MemoryStats adeonStats = adeon.memoryStats();
+    MemoryStats gsmStats = gsm.memoryStats();
+    printf("%10lu %8.1f %6zu %6zu %6zu %6zu %7.3f %8u\n",
+           iteration, (millis() - startTime) / 3600000.0, adeonStats.bytesInUse, gsmStats.bytesInUse,
+           arena.getFreeBytes(), arena.getLargestFreeBlock(), arena.getFragmentation(),
+           arena.getFailCount());
+}
+
+static void soak(unsigned long iterations, size_t heapSize){
+    FirstFitArena arena(heapSize);
+    FirstFitArena::install(&arena);
+    rngState = 2463534242UL;
+    startTime = millis();
+
+    SimModem modem;
+    GSM gsm(&modem);
+    Adeon adeon;
+
+    char params[NUM_PARAMS][LIST_ITEM_LENGTH];
+    char users[NUM_USERS][LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < NUM_PARAMS; i++){
+        randomName(params[i], LIST_ITEM_LENGTH - 1, 'P');
+        adeon.addParam(params[i], 0);
+    }
+    adeon.addUser(sender, ADEON_ADMIN);
+    for(uint8_t i = 0; i < NUM_USERS; i++){
+        randomPhone(users[i]);
+        adeon.addUser(users[i], ADEON_USER);
+    }
+
+    printf("\n*** HEAP %zu B (arena header %zu B per block) ***\n", heapSize, FirstFitArena::HEADER);
+    printf("%10s %8s %6s %6s %6s %6s %7s %8s\n",
+           "iteration", "uptime_h", "adeon", "gsm", "free", "largest", "frag", "failures");
+
+    unsigned long reportEvery = (iterations >= REPORTS) ? iterations / REPORTS : 1;
+    unsigned long failurePoint = 0;
+    unsigned long applied = 0;
+    char payload[MSG_BUFFER_LENGTH];
+    char msg[MSG_BUFFER_LENGTH + SHORT_HASH_LENGTH + 2];
+
+    for(unsigned long i = 1; i <= iterations; i++){
+        // incoming SMS with random subset of parameters
+        size_t len = 0;
+        payload[0] = '\0';
+        uint8_t count = 1 + rnd(NUM_PARAMS);
+        for(uint8_t p = 0; p < count; p++){
+            char entry[LIST_ITEM_LENGTH + 12];
+            snprintf(entry, sizeof(entry), "%s = %u;", params[rnd(NUM_PARAMS)], (unsigned)rnd(1000));
+            if(len + strlen(entry) + SHORT_HASH_LENGTH + 2 >= MSG_LENGTH){
+                break;
+            }
+            strcpy(&payload[len], entry);
+            len += strlen(entry);
+        }
+        makeAdeonMsg(msg, sizeof(msg), payload);
+        modem.deliverSms(sender, msg);
+
+        for(uint8_t poll = 0; poll < 4 && !gsm.isNewMsgAvailable(); poll++){
+            delay(PERIODIC_READ_TIME);
+            gsm.checkGsmOutput();
+        }
+        if(gsm.isNewMsgAvailable()){
+            char* pn = gsm.getPhoneNum();
+            char* body = gsm.getMsg();
+            if(adeon.isUserInAdeon(pn)){
+                adeon.parseBuf(body, adeon.getUserRightsLevel(pn));
+                applied++;
+            }
+        }
+
+        // user edits
+        if(rnd(8) == 0){
+            uint8_t u = rnd(NUM_USERS);
+            char phone[LIST_ITEM_LENGTH];
+            randomPhone(phone);
+            if(adeon.editUserPhone(users[u], phone) != nullptr){
+                strcpy(users[u], phone);
+            }
+        }
+
+        // parameter renames
+        if(rnd(11) == 0){
+            uint8_t p = rnd(NUM_PARAMS);
+            char name[LIST_ITEM_LENGTH];
+            randomName(name, LIST_ITEM_LENGTH - 1, 'R');
+            if(!adeon.isParamInAdeon(name) && adeon.editParamName(params[p], name) != nullptr){
+                strcpy(params[p], name);
+            }
+        }
+
+        // short living parameter
+        if(rnd(13) == 0){
+            adeon.addParam("Tmp", 1);
+            adeon.deleteParam("Tmp");
+        }
+
+        if(failurePoint == 0 && arena.getFailCount() > 0){
+            failurePoint = i;
+            printf("first allocation failure at iteration %lu\n", i);
+        }
+        if(i % reportEvery == 0){
+            report(i, arena, adeon, gsm);
+        }
+    }
+
+    printf("applied messages: %lu, modem commands: %u, failure point: ", applied, modem.getCommandCount());
+    if(failurePoint != 0){
+        printf("%lu\n", failurePoint);
+    }
+    else{
+        printf("none\n");
+    }
+
+    adeon.deleteList();
+    FirstFitArena::install(nullptr);
+}
+
+int main(int argc, char** argv){
+    unsigned long iterations = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 1000000UL;
+
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    if(argc > 2){
+        for(int i = 2; i < argc; i++){
+            soak(iterations, strtoul(argv[i], nullptr, 10));
+        }
+    }
+    else{
+        soak(iterations, 2048);
+        soak(iterations, 8192);
+    }
+    return 0;
+}
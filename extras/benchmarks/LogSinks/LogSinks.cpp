@@ -0,0 +1,164 @@
+/**
+ *  @file       LogSinks.cpp
+ *  Project     AdeonGSM
+ *  @brief      Time spent by the message path in logging with different sinks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Bursts of BURST messages arrive on virtual clock, each one logs the lines of GSM
+ * (read, sent, deleted) and "Message is invalid" from parseBuf(). Console is a model
+ * of hardware serial at 9600 baud with a 64-byte transmit buffer, writing blocks
+ * while the buffer is full. Sinks: none, the console directly, and LogBuffer of
+ * 128 and 512 bytes drained by pump() in the loop between messages.
+ * Reported are milliseconds the message path waits for the console and lines lost.
+ * Exit code is non-zero if a buffered sink blocks the path, or the large buffer
+ * loses a line or changes text written to the console.
+ *
+ * Usage: LogSinks [bursts]
+ * Default: 200 bursts.
+ */
+
+#include <AdeonGSM.h>
+#include <string>
+
+constexpr static auto BURST = 8;
+constexpr static auto MSG_GAP = 20;     //ms between messages of a burst
+constexpr static auto BURST_GAP = 3000; //ms between bursts
+constexpr static auto BYTE_US = 1042;   //us per byte at 9600 baud
+constexpr static auto TX_BUFFER = 64;
+static const char* sender = "+420603000001";
+
+/**
+ * @brief Serial console which sends one byte per BYTE_US of virtual time.
+ */
+class SlowSerial : public Print {
+    public:
+        size_t write(uint8_t c) override {
+            while(queued() >= TX_BUFFER){
+                HostClock::advance(1);
+                blockedMs++;
+            }
+            unsigned long now = micros();
+            _busyUntil = ((_busyUntil > now) ? _busyUntil : now) + BYTE_US;
+            text.push_back((char)c);
+            return 1;
+        }
+        int availableForWrite() override {
+            return TX_BUFFER - queued();
+        }
+
+        std::string text;
+        unsigned long blockedMs = 0;
+
+    private:
+        int queued(){
+            unsigned long now = micros();
+            return (_busyUntil > now) ? (int)((_busyUntil - now + BYTE_US - 1) / BYTE_US) : 0;
+        }
+
+        unsigned long _busyUntil = 0;
+};
+
+struct Result {
+    unsigned long pathMs = 0; // virtual time of message path
+    unsigned long worstMs = 0;
+    unsigned long blockedMs = 0;
+    uint32_t dropped = 0;
+    std::string text;
+};
+
+static Result run(Adeon& adeon, const char* msg, Print* pSink, LogBufferBase* pBuffer, SlowSerial& console,
+                  unsigned long bursts){
+    Result result;
+    AdeonLog::setSink(pSink);
+    for(unsigned long b = 0; b < bursts; b++){
+        for(uint8_t m = 0; m < BURST; m++){
+            unsigned long start = millis();
+            ADEON_LOG_INFO(F("SMS READ"));
+            adeon.parseBuf(msg, ADEON_USER, sender);
+            ADEON_LOG_INFO(F("SMS SENT"));
+            ADEON_LOG_INFO(F("MSG DELETED"));
+            unsigned long elapsed = millis() - start;
+            result.pathMs += elapsed;
+            result.worstMs = (elapsed > result.worstMs) ? elapsed : result.worstMs;
+            for(unsigned long t = 0; t < MSG_GAP; t++){
+                if(pBuffer != nullptr){
+                    pBuffer->pump(console);
+                }
+                HostClock::advance(1);
+            }
+        }
+        for(unsigned long t = 0; t < BURST_GAP; t++){
+            if(pBuffer != nullptr){
+                pBuffer->pump(console);
+            }
+            HostClock::advance(1);
+        }
+    }
+    AdeonLog::setSink(nullptr);
+    result.blockedMs = console.blockedMs;
+    result.text = console.text;
+    if(pBuffer != nullptr){
+        result.dropped = pBuffer->getStats().dropped;
+    }
+    return result;
+}
+
+static void report(const char* name, const Result& result, unsigned long messages){
+    printf("%-20s %10.2f %10lu %10lu %10lu\n", name, (double)result.pathMs / messages, result.worstMs,
+           result.blockedMs, (unsigned long)result.dropped);
+}
+
+int main(int argc, char** argv){
+    unsigned long bursts = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 200;
+    if(bursts == 0){
+        fprintf(stderr, "bursts must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+    HostClock::useVirtual(true);
+
+    Adeon adeon;
+    adeon.addUser(sender, ADEON_USER);
+    adeon.addParam("relay", 0);
+    const char* msg = "ABCDEF#relay = 1;"; // wrong hash, logged as invalid
+    unsigned long messages = bursts * BURST;
+
+    SlowSerial silentConsole;
+    Result none = run(adeon, msg, nullptr, nullptr, silentConsole, bursts);
+    SlowSerial directConsole;
+    Result direct = run(adeon, msg, &directConsole, nullptr, directConsole, bursts);
+    SlowSerial smallConsole;
+    LogBuffer smallBuffer;
+    Result small = run(adeon, msg, &smallBuffer, &smallBuffer, smallConsole, bursts);
+    SlowSerial largeConsole;
+    BasicLogBuffer<512> largeBuffer;
+    Result large = run(adeon, msg, &largeBuffer, &largeBuffer, largeConsole, bursts);
+
+    printf("%u messages per burst, %u ms apart, console 9600 baud\n", BURST, MSG_GAP);
+    printf("%-20s %10s %10s %10s %10s\n", "sink", "ms/msg", "worst ms", "blocked ms", "dropped");
+    report("none", none, messages);
+    report("Serial", direct, messages);
+    report("LogBuffer (128)", small, messages);
+    report("BasicLogBuffer<512>", large, messages);
+
+    bool failed = small.pathMs != 0 || large.pathMs != 0 || large.dropped != 0 || large.text != direct.text;
+    printf("buffered output %s\n", failed ? "FAILED" : "matches");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+/**
+ *  @file       MetricsDump.cpp
+ *  Project     AdeonGSM
+ *  @brief      Metrics registry under mixed SMS traffic
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Each round delivers five SMS to the simulated modem on virtual clock: an admin edit
+ * of two parameters, a message with wrong hash, a user edit of an admin parameter,
+ * plain text without semicolon and text without hash. GSM and Adeon count them in
+ * AdeonMetrics, the counters are compared with the expected ones.
+ * Then the Prometheus dump and the compact summary are printed with their size,
+ * and time of one AdeonMetrics::add() is measured.
+ * Finally the modem stores SMS from index 10 and 100, the edit must be applied and the SMS deleted.
+ * Exit code is non-zero if a counter differs, the summary does not fit into one SMS
+ * or an SMS with a large index is lost.
+ *
+ * Usage: MetricsDump [rounds]
+ * Default: 20 rounds.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include <chrono>
+#include <string>
+#include "../common/SimModem.h"
+
+constexpr static auto SMS_PER_ROUND = 5;
+constexpr static unsigned long SMS_LIMIT = 10000; //ms
+static const char* admin = "420598632485";
+static const char* user = "420598632486";
+
+/**
+ * @brief Output collected in a string.
+ */
+class StringOutput : public Print {
+    public:
+        size_t write(uint8_t c) override {
+            text.push_back((char)c);
+            return 1;
+        }
+        using Print::write;
+
+        std::string text;
+};
+
+/**
+ * @brief Deliver SMS and process it like a sketch until it is deleted from the modem.
+ */
+static void receive(SimModem& modem, GSM& gsm, Adeon& adeon, const char* sender, const char* body){
+    modem.deliverSms(sender, body);
+    unsigned long start = millis();
+    while(millis() - start < SMS_LIMIT && (modem.getStoredSms() != 0 || gsm.isBusy())){
+        delay(COMMAND_POLL_TIME);
+        gsm.checkGsmOutput();
+        if(gsm.isNewMsgAvailable()){
+            char* pMsg = gsm.getMsg();
+            adeon.parseBuf(pMsg, adeon.getUserRightsLevel(gsm.getPhoneNum()), gsm.getPhoneNum());
+        }
+    }
+}
+
+/**
+ * @brief Deliver edit into slot with index of the modem and process it.
+ * @return true if the edit is applied and the SMS is deleted.
+ */
+static bool receiveAtIndex(SimModem& modem, GSM& gsm, Adeon& adeon, uint16_t index, uint16_t value){
+    char payload[32];
+    char msg[MSG_BUFFER_LENGTH + 1];
+    snprintf(payload, sizeof(payload), "level = %u;", value);
+    makeAdeonMsg(msg, sizeof(msg), payload);
+    modem.setFirstIndex(index);
+    modem.deliverSms(admin, msg);
+    //index over 10 deletes the whole stack down to 1
+    unsigned long start = millis();
+    while(millis() - start < 6 * SMS_LIMIT && (modem.getStoredSms() != 0 || gsm.isBusy())){
+        delay(COMMAND_POLL_TIME);
+        gsm.checkGsmOutput();
+        if(gsm.isNewMsgAvailable()){
+            char* pMsg = gsm.getMsg();
+            adeon.parseBuf(pMsg, adeon.getUserRightsLevel(gsm.getPhoneNum()), gsm.getPhoneNum());
+        }
+    }
+    bool ok = adeon.getParamValue("level") == value && modem.getStoredSms() == 0;
+    printf("SMS at index %u: %s\n", index, ok ? "applied" : "LOST");
+    return ok;
+}
+
+static bool check(const char* name, Metric metric, uint32_t expected){
+    uint32_t val = AdeonMetrics::get(metric);
+    printf("%-16s %10lu %10lu\n", name, (unsigned long)val, (unsigned long)expected);
+    return val == expected;
+}
+
+int main(int argc, char** argv){
+    unsigned long rounds = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20;
+    if(rounds == 0){
+        fprintf(stderr, "rounds must be at least 1\n");
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    SimModem modem;
+    GSM gsm(&modem);
+    gsm.begin();
+    Adeon adeon;
+    adeon.addUser(admin, ADEON_ADMIN);
+    adeon.addUser(user, ADEON_USER);
+    adeon.addParam("relay", 0);
+    adeon.addParam("level", 0);
+    adeon.setParamAccess("relay", ADEON_USER);
+    AdeonMetrics::reset();
+
+    char edit[MSG_BUFFER_LENGTH + 1];
+    char wrongHash[MSG_BUFFER_LENGTH + 1];
+    char denied[MSG_BUFFER_LENGTH + 1];
+    bool failed = false;
+    for(unsigned long round = 1; round <= rounds; round++){
+        char payload[48];
+        snprintf(payload, sizeof(payload), "relay = %lu;level = %lu;", round % 2, round);
+        makeAdeonMsg(edit, sizeof(edit), payload);
+        makeAdeonMsg(wrongHash, sizeof(wrongHash), payload);
+        wrongHash[0] = (wrongHash[0] == '0') ? '1' : '0';
+        snprintf(payload, sizeof(payload), "level = %lu;", round + 1000);
+        makeAdeonMsg(denied, sizeof(denied), payload);
+
+        receive(modem, gsm, adeon, admin, edit);
+        receive(modem, gsm, adeon, admin, wrongHash);
+        receive(modem, gsm, adeon, user, denied);
+        receive(modem, gsm, adeon, user, "hello");
+        receive(modem, gsm, adeon, user, "hello;");
+        failed |= adeon.getParamValue("level") != round;
+    }
+
+    printf("%lu rounds of %u SMS\n", rounds, SMS_PER_ROUND);
+    printf("%-16s %10s %10s\n", "metric", "value", "expected");
+    failed |= !check("sms received", Metric::SMS_RECEIVED, rounds * SMS_PER_ROUND);
+    failed |= !check("hash failures", Metric::HASH_FAILURES, rounds);
+    failed |= !check("unauthorized", Metric::UNAUTHORIZED, rounds);
+    failed |= !check("parse errors", Metric::PARSE_ERRORS, rounds * 2);
+    failed |= !check("params applied", Metric::PARAMS_APPLIED, rounds * 2);
+    failed |= !check("cmd timeouts", Metric::CMD_TIMEOUTS, 0);
+    failed |= !check("sms deleted", Metric::SMS_DELETED, rounds * SMS_PER_ROUND);
+    failed |= !check("queue depth", Metric::QUEUE_DEPTH, 0);
+
+    StringOutput prometheus;
+    AdeonMetrics::dumpMetrics(prometheus);
+    char summary[SMS_TEXT_LENGTH + 1];
+    uint8_t length = AdeonMetrics::getSummary(summary, sizeof(summary));
+    failed |= length >= SMS_TEXT_LENGTH || prometheus.text.find('\r') != std::string::npos;
+    printf("\n%s", prometheus.text.c_str());
+    printf("\nPrometheus dump %zu B, summary %u B: %s\n", prometheus.text.size(), length, summary);
+
+    failed |= !receiveAtIndex(modem, gsm, adeon, 10, 5010);
+    failed |= !receiveAtIndex(modem, gsm, adeon, 100, 5100);
+
+    HostClock::useVirtual(false);
+    constexpr unsigned long adds = 10000000;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < adds; i++){
+        AdeonMetrics::add((Metric)(i & 3));
+    }
+    double addTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / adds;
+    printf("add(): %.2f ns\n", addTime);
+    printf("metrics %s\n", failed ? "FAILED" : "match");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/**
+ *  @file       ModemHealth.cpp
+ *  Project     AdeonGSM
+ *  @brief      Detection of a modem which stops answering
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Each cycle runs a sketch loop on virtual clock with ModemHealth attached to GSM:
+ * SMS edits are applied while the modem answers, then the modem loses power and stays
+ * silent for BOOT_TIME. Idle probes time out until the monitor reports UNRESPONSIVE,
+ * its handler sets a flag and the loop resets the modem by begin() and reset().
+ * An SMS delivered after the reset must be applied again.
+ * Time from the power loss until detection and until recovery is reported per cycle,
+ * followed by latency histograms of command types and the Prometheus dump.
+ * Exit code is non-zero if a state is not reached, an SMS is not applied or latency
+ * equal to a bucket limit is not counted in that bucket (le bound of Prometheus).
+ *
+ * Usage: ModemHealth [cycles]
+ * Default: 3 cycles.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include <string>
+#include "../common/SimModem.h"
+
+constexpr static auto SMS_PER_CYCLE = 4;
+constexpr static unsigned long PROBE_TIME = 5000;  //ms
+constexpr static unsigned long BOOT_TIME = 20000;  //ms
+constexpr static unsigned long STEP_LIMIT = 120000; //ms
+static const char* admin = "420598632485";
+
+/**
+ * @brief Output collected in a string.
+ */
+class StringOutput : public Print {
+    public:
+        size_t write(uint8_t c) override {
+            text.push_back((char)c);
+            return 1;
+        }
+        using Print::write;
+
+        std::string text;
+};
+
+struct Sketch {
+    SimModem modem;
+    GSM gsm{&modem};
+    Adeon adeon;
+    ModemHealth health;
+    bool resetNeeded = false;
+    uint8_t unresponsiveCount = 0;
+    unsigned long detectedAt = 0;
+    uint8_t recoveries = 0;
+    uint8_t handlerCalls = 0;
+};
+
+/**
+ * @brief Health handler of the sketch, the modem is reset in loop().
+ */
+static void onHealth(HealthState state, void* pContext){
+    Sketch* pSketch = (Sketch*)pContext;
+    pSketch->handlerCalls++;
+    if(state == HealthState::UNRESPONSIVE){
+        pSketch->unresponsiveCount++;
+        pSketch->detectedAt = millis();
+        pSketch->resetNeeded = true;
+    }
+}
+
+/**
+ * @brief One pass of loop() of the sketch.
+ */
+static void loopOnce(Sketch& s){
+    delay(COMMAND_POLL_TIME);
+    s.gsm.checkGsmOutput();
+    if(s.gsm.isNewMsgAvailable()){
+        char* pMsg = s.gsm.getMsg();
+        s.adeon.parseBuf(pMsg, s.adeon.getUserRightsLevel(s.gsm.getPhoneNum()), s.gsm.getPhoneNum());
+    }
+    //begin() is repeated by the next passes while the modem boots
+    if(s.resetNeeded && s.gsm.begin() == GSM::BeginStatus::OK){
+        s.resetNeeded = false;
+        s.health.reset();
+        s.recoveries++;
+    }
+}
+
+/**
+ * @brief Deliver SMS edit and run loop until the value is applied.
+ * @return true if the value is applied in time.
+ */
+static bool receive(Sketch& s, unsigned long value){
+    char payload[32];
+    char msg[MSG_BUFFER_LENGTH + 1];
+    snprintf(payload, sizeof(payload), "level = %lu;", value);
+    makeAdeonMsg(msg, sizeof(msg), payload);
+    s.modem.deliverSms(admin, msg);
+    unsigned long start = millis();
+    while(millis() - start < STEP_LIMIT && s.adeon.getParamValue("level") != value){
+        loopOnce(s);
+    }
+    return s.adeon.getParamValue("level") == value;
+}
+
+/**
+ * @brief Run loop until the condition holds.
+ * @return Time in ms, STEP_LIMIT if the condition does not hold in time.
+ */
+template <typename Cond>
+static unsigned long runUntil(Sketch& s, Cond cond){
+    unsigned long start = millis();
+    while(millis() - start < STEP_LIMIT && !cond()){
+        loopOnce(s);
+    }
+    return millis() - start;
+}
+
+int main(int argc, char** argv){
+    unsigned long cycles = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 3;
+    if(cycles == 0){
+        fprintf(stderr, "cycles must be at least 1\n");
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    Sketch s;
+    s.gsm.begin();
+    s.adeon.addUser(admin, ADEON_ADMIN);
+    s.adeon.addParam("level", 0);
+    s.health.setHealthHandler(onHealth, &s);
+    s.gsm.setHealthMonitor(&s.health, PROBE_TIME);
+
+    bool failed = false;
+    unsigned long value = 0;
+    printf("probe %lu ms, boot %lu ms, unresponsive after %d timeouts\n",
+           PROBE_TIME, BOOT_TIME, HEALTH_UNRESPONSIVE_AFTER);
+    printf("%-6s %10s %12s %12s %8s\n", "cycle", "sms", "detect ms", "recover ms", "applied");
+    for(unsigned long cycle = 1; cycle <= cycles; cycle++){
+        uint8_t applied = 0;
+        for(uint8_t i = 0; i < SMS_PER_CYCLE; i++){
+            applied += receive(s, ++value);
+        }
+        failed |= s.health.getState() != HealthState::OK;
+
+        uint8_t detected = s.unresponsiveCount;
+        uint8_t recovered = s.recoveries;
+        unsigned long powerLoss = millis();
+        s.modem.powerOn(BOOT_TIME);
+        unsigned long recoverTime = runUntil(s, [&]{ return s.recoveries != recovered; });
+        unsigned long detectTime = s.detectedAt - powerLoss;
+        failed |= s.unresponsiveCount == detected || recoverTime >= STEP_LIMIT
+                  || s.health.getState() != HealthState::OK;
+
+        applied += receive(s, ++value);
+        failed |= applied != SMS_PER_CYCLE + 1;
+        printf("%-6lu %10d %12lu %12lu %8u\n", cycle, SMS_PER_CYCLE + 1, detectTime, recoverTime, applied);
+    }
+
+    printf("\n%-6s %8s %8s %8s %8s  buckets <=250 <=500 <=1000 <=2000 ...\n", "type", "count", "avg ms", "failed", "timeout");
+    for(uint8_t t = 0; t < AT_TYPE_COUNT; t++){
+        CommandStats stats = s.health.getStats((AtType)t);
+        unsigned long count = 0;
+        for(uint8_t i = 0; i < HEALTH_BUCKETS; i++){
+            count += stats.buckets[i];
+        }
+        printf("%-6s %8lu %8lu %8u %8u ", (const char*)ModemHealth::typeName((AtType)t), count,
+               count ? (unsigned long)stats.totalMs / count : 0, stats.failures, stats.timeouts);
+        for(uint8_t i = 0; i < HEALTH_BUCKETS; i++){
+            printf(" %u", stats.buckets[i]);
+        }
+        printf("\n");
+    }
+    failed |= s.health.getStats(AtType::AT).timeouts < cycles * HEALTH_UNRESPONSIVE_AFTER;
+    failed |= s.handlerCalls < cycles;
+
+    ModemHealth bounds;
+    bounds.record(AtType::AT, ModemHealth::getBucketLimit(0), CommandResult::OK);
+    failed |= bounds.getStats(AtType::AT).buckets[0] != 1;
+
+    StringOutput prometheus;
+    s.health.dumpMetrics(prometheus);
+    printf("\n%s", prometheus.text.c_str());
+    printf("health %s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
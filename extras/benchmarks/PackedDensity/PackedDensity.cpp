@@ -0,0 +1,138 @@
+/**
+ *  @file       PackedDensity.cpp
+ *  Project     AdeonGSM
+ *  @brief      Density and parse time of packed messages
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Parameter edits which fit into one SMS (MSG_BUFFER_LENGTH characters with hash)
+ * in text format "name = value;" and in packed format "#1...;" of PackedWriter.
+ * PARAMS parameters named like "relay00", edits of every parameter in order, values:
+ *  - switch: 0 or 1
+ *  - level:  0 to 1000
+ *  - raw:    0 to 65535
+ *
+ * Then parseBuf() of a full message is timed for both formats, including hash check,
+ * and divided by number of edits in the message.
+ * Exit code is non-zero if a value is not applied.
+ *
+ * Usage: PackedDensity [repeats]
+ * Default: 20000 repeats.
+ */
+
+#include <AdeonGSM.h>
+#include <chrono>
+#include "../common/SimModem.h"
+
+constexpr static auto PARAMS = 60;
+constexpr static auto PAYLOAD_LENGTH = MSG_BUFFER_LENGTH - SHORT_HASH_LENGTH - 2;
+
+struct Range {
+    const char* name;
+    uint16_t maxVal;
+};
+
+static uint16_t valueOf(uint8_t index, uint16_t maxVal){
+    return (uint16_t)((index * 7919UL + 13) % ((unsigned long)maxVal + 1));
+}
+
+static uint8_t makeText(char* pOut, uint16_t maxVal){
+    uint8_t count = 0;
+    pOut[0] = '\0';
+    char item[24];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(item, sizeof(item), "relay%02u = %u;", i, valueOf(i, maxVal));
+        if(strlen(pOut) + strlen(item) > PAYLOAD_LENGTH){
+            break;
+        }
+        strcat(pOut, item);
+        count++;
+    }
+    return count;
+}
+
+static uint8_t makePacked(char* pOut, uint16_t maxVal){
+    PackedWriter writer(pOut, PAYLOAD_LENGTH + 1);
+    for(uint8_t i = 0; i < PARAMS && writer.add(i, valueOf(i, maxVal)); i++){
+    }
+    writer.get();
+    return writer.getCount();
+}
+
+static bool isApplied(AdeonBase& adeon, uint8_t count, uint16_t maxVal){
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < count; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        if(adeon.getParamValue(name) != valueOf(i, maxVal)){
+            return false;
+        }
+    }
+    return true;
+}
+
+static double measure(AdeonBase& adeon, const char* msg, unsigned long repeats){
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < repeats; i++){
+        adeon.parseBuf(msg, ADEON_ADMIN);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main(int argc, char** argv){
+    unsigned long repeats = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    if(repeats == 0){
+        fprintf(stderr, "repeats must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+
+    Adeon adeon;
+    char name[LIST_ITEM_LENGTH];
+    for(uint8_t i = 0; i < PARAMS; i++){
+        snprintf(name, sizeof(name), "relay%02u", i);
+        adeon.addParam(name, 0);
+    }
+
+    static const Range ranges[] = {{"switch", 1}, {"level", 1000}, {"raw", 65535}};
+    bool failed = false;
+    char payload[PAYLOAD_LENGTH + 1];
+    char msg[MSG_BUFFER_LENGTH + 1];
+
+    printf("%-8s %11s %13s %8s %15s %17s\n", "values", "text edits", "packed edits", "density",
+           "text ns/edit", "packed ns/edit");
+    for(const Range& range : ranges){
+        uint8_t textCount = makeText(payload, range.maxVal);
+        makeAdeonMsg(msg, sizeof(msg), payload);
+        double textTime = measure(adeon, msg, repeats) / textCount;
+        failed |= !isApplied(adeon, textCount, range.maxVal);
+
+        for(uint8_t i = 0; i < PARAMS; i++){
+            snprintf(name, sizeof(name), "relay%02u", i);
+            adeon.editParamValue(name, 0);
+        }
+        uint8_t packedCount = makePacked(payload, range.maxVal);
+        makeAdeonMsg(msg, sizeof(msg), payload);
+        double packedTime = measure(adeon, msg, repeats) / packedCount;
+        failed |= !isApplied(adeon, packedCount, range.maxVal);
+
+        printf("%-8s %11u %13u %7.1fx %15.0f %17.0f\n", range.name, textCount, packedCount,
+               (double)packedCount / textCount, textTime, packedTime);
+    }
+    return failed ? 1 : 0;
+}
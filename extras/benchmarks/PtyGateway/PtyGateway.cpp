@@ -0,0 +1,102 @@
+/**
+ *  @file       PtyGateway.cpp
+ *  Project     AdeonGSM
+ *  @brief      End-to-end gateway run over a pseudo-terminal
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs GSM and Adeon on Linux through PosixSerial. Slave side of a pseudo-terminal
+ * is opened by its device path like a USB modem, master side is bridged by a thread
+ * to the simulated modem. Real clock is used, so driver delays are included
+ * in the reported latency.
+ *
+ * Usage: PtyGateway [messages]
+ * Default: 5 messages. Exit code is non-zero if any message is lost.
+ */
+
+#include <AdeonGSM.h>
+#include <utility/SIMlib.h>
+#include "../common/PtyModem.h"
+
+static const char* sender = "420598632485";
+
+int main(int argc, char** argv){
+    unsigned long messages = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 5;
+
+    PtyModem modem;
+    if(!modem.open()){
+        perror("openpty");
+        return 1;
+    }
+
+    PosixSerial port;
+    if(!port.begin(modem.getDevice(), 115200)){
+        perror(modem.getDevice());
+        return 1;
+    }
+    printf("modem at %s\n", modem.getDevice());
+
+    Serial.mute(true);
+    GSM gsm(&port);
+    Adeon adeon;
+    adeon.addUser(sender, ADEON_ADMIN);
+    adeon.addParam("Relay", 0);
+
+    unsigned long start = millis();
+    gsm.begin();
+    printf("begin: %lu ms\n", millis() - start);
+
+    unsigned long applied = 0;
+    unsigned long totalLatency = 0;
+    unsigned long maxLatency = 0;
+    for(unsigned long i = 1; i <= messages; i++){
+        char payload[32];
+        char msg[MSG_BUFFER_LENGTH];
+        uint16_t value = i % 1000;
+        snprintf(payload, sizeof(payload), "Relay = %u;", value);
+        makeAdeonMsg(msg, sizeof(msg), payload);
+        modem.deliverSms(sender, msg);
+        start = millis();
+        while(!gsm.isNewMsgAvailable() && millis() - start < 3000){
+            gsm.checkGsmOutput();
+            port.waitForData(10);
+        }
+        if(gsm.isNewMsgAvailable()){
+            char* pn = gsm.getPhoneNum();
+            char* body = gsm.getMsg();
+            adeon.parseBuf(body, adeon.getUserRightsLevel(pn), pn);
+        }
+        unsigned long latency = millis() - start;
+        if(adeon.getParamValue("Relay") == value){
+            applied++;
+            totalLatency += latency;
+            if(latency > maxLatency){
+                maxLatency = latency;
+            }
+        }
+    }
+
+    adeon.deleteList();
+    port.end();
+    uint8_t stored = modem.getStoredSms();
+    modem.close();
+    printf("applied %lu/%lu messages, mean latency %lu ms, max %lu ms, left in modem %u\n",
+           applied, messages, applied ? totalLatency / applied : 0, maxLatency, stored);
+    return (applied == messages && stored == 0) ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/**
+ *  @file       ReaderLatency.cpp
+ *  Project     AdeonGSM
+ *  @brief      Wake-to-process latency of background serial reading
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Wake-to-process latency of incoming SMS on Linux. Simulated modem is reached through
+ * a pseudo-terminal and PosixSerial, real clock is used.
+ *
+ * polling: loop calls GSM::poll() every COMMAND_POLL_TIME, bytes are read
+ *          RX_SETTLE_TIME after they are found.
+ * reader:  SerialReader thread sleeps in epoll, loop sleeps in waitForData()
+ *          and GSM reads in immediate mode.
+ *
+ * Wake latency is time from +CMTI written by the modem to AT+CMGR started by GSM,
+ * process latency is time to the message being available. Loop wakeups are counted
+ * over one idle second.
+ *
+ * Usage: ReaderLatency [messages]
+ * Default: 20 messages per mode. Exit code is non-zero if any message is lost.
+ */
+
+#include <utility/SIMlib.h>
+#include <utility/serialreader.h>
+#include "../common/PtyModem.h"
+
+#include <algorithm>
+
+static const char* sender = "420598632485";
+
+struct Result {
+    unsigned long received = 0;
+    unsigned long wake[256];
+    unsigned long process[256];
+    unsigned long idleWakeups = 0;
+};
+
+/**
+ * @brief One iteration of the application loop.
+ * @return number of wakeups of the loop (always 1).
+ */
+static unsigned long step(GSM& gsm, SerialReader* pReader){
+    if(pReader != nullptr){
+        pReader->waitForData(gsm.isBusy() ? COMMAND_POLL_TIME : 1000);
+    }
+    else{
+        delay(COMMAND_POLL_TIME);
+    }
+    gsm.poll();
+    return 1;
+}
+
+static bool run(bool useReader, unsigned long messages, Result& result){
+    PtyModem modem;
+    PosixSerial port;
+    if(!modem.open() || !port.begin(modem.getDevice(), 115200)){
+        perror("pty");
+        return false;
+    }
+    SerialReader reader(&port);
+    GSM gsm(useReader ? static_cast<Stream*>(&reader) : static_cast<Stream*>(&port));
+    SerialReader* pReader = nullptr;
+    if(useReader){
+        reader.start();
+        gsm.setImmediateRead(true);
+        pReader = &reader;
+    }
+    gsm.begin();
+
+    unsigned long start = millis();
+    while(millis() - start < 1000){
+        result.idleWakeups += step(gsm, pReader);
+    }
+
+    char msg[MSG_LENGTH];
+    makeAdeonMsg(msg, sizeof(msg), "Relay = 1;");
+    for(unsigned long i = 0; i < messages; i++){
+        //random phase against the poll interval
+        delay(rand() % COMMAND_POLL_TIME);
+        unsigned long sent = micros();
+        modem.deliverSms(sender, msg);
+        unsigned long woken = 0;
+        while(!gsm.isNewMsgAvailable() && micros() - sent < 3000000UL){
+            step(gsm, pReader);
+            if(woken == 0 && gsm.isBusy()){
+                woken = micros();
+            }
+        }
+        if(gsm.isNewMsgAvailable()){
+            result.wake[result.received] = (woken - sent) / 1000;
+            result.process[result.received] = (micros() - sent) / 1000;
+            result.received++;
+            gsm.getMsg();
+        }
+        //let GSM delete the message
+        while(gsm.isBusy()){
+            step(gsm, pReader);
+        }
+    }
+
+    reader.stop();
+    port.end();
+    modem.close();
+    return true;
+}
+
+static void report(const char* name, Result& result, unsigned long messages){
+    unsigned long n = result.received;
+    std::sort(result.wake, result.wake + n);
+    std::sort(result.process, result.process + n);
+    unsigned long wakeSum = 0;
+    unsigned long processSum = 0;
+    for(unsigned long i = 0; i < n; i++){
+        wakeSum += result.wake[i];
+        processSum += result.process[i];
+    }
+    printf("%-8s %4lu/%-4lu %9lu %9lu %9lu %9lu %12lu\n", name, n, messages,
+           n ? wakeSum / n : 0, n ? result.wake[n - 1] : 0,
+           n ? processSum / n : 0, n ? result.process[n - 1] : 0,
+           result.idleWakeups);
+}
+
+int main(int argc, char** argv){
+    unsigned long messages = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20;
+    if(messages == 0 || messages > 256){
+        fprintf(stderr, "messages must be 1 to 256\n");
+        return 1;
+    }
+    Serial.mute(true);
+
+    Result polling;
+    Result threaded;
+    if(!run(false, messages, polling) || !run(true, messages, threaded)){
+        return 1;
+    }
+
+    printf("%-8s %9s %9s %9s %9s %9s %12s\n", "mode", "received", "wake ms", "max",
+           "process", "max", "idle wakes/s");
+    report("polling", polling, messages);
+    report("reader", threaded, messages);
+    return (polling.received == messages && threaded.received == messages) ? 0 : 1;
+}
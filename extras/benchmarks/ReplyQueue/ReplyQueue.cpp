@@ -0,0 +1,161 @@
+/**
+ *  @file       ReplyQueue.cpp
+ *  Project     AdeonGSM
+ *  @brief      Replies sent through the SMS queue
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Every burst interval one sender sends BURST_SIZE commands BURST_GAP apart and each
+ * command is answered by a reply SMS. Modes:
+ *  - blocking: reply is sent before the loop goes on, like a sketch waiting for AT+CMGS
+ *  - queue:    reply is queued, checkGsmOutput() sends it step by step
+ *  - coalesce: as queue, replies to the same sender within 1 s make one SMS
+ *
+ * Reports the longest loop iteration, delay of incoming commands, number of SMS sent
+ * and counters of the queue. One run lets the modem refuse sends to show retries,
+ * the last two queue replies to a modem with echo, the second with "OK" in the text.
+ * Exit code is non-zero if a command or a reply is lost, a reply is sent more than once
+ * or taken as sent before the modem confirms it.
+ *
+ * Usage: ReplyQueue [bursts]
+ * Default: 100 bursts.
+ */
+
+#include <utility/SIMlib.h>
+#include "../common/SimModem.h"
+
+constexpr static auto BURST_SIZE = 3;
+constexpr static unsigned long BURST_GAP = 300; //ms
+constexpr static unsigned long BURST_INTERVAL = 20000; //ms
+constexpr static unsigned long COALESCE_WINDOW = 1000; //ms
+
+static const char* sender = "420598632485";
+
+enum class Mode : uint8_t {
+    BLOCKING,
+    QUEUE,
+    COALESCE
+};
+
+struct Result {
+    unsigned long commands = 0;
+    unsigned long maxStall = 0;
+    unsigned long maxCmdDelay = 0;
+    uint32_t smsSent = 0;
+    bool early = false; // queue counted a reply the modem has not confirmed yet
+    SmsQueueStats stats;
+};
+
+static Result run(Mode mode, unsigned long bursts, uint8_t failingSends, bool echo, const char* replyFormat){
+    Result result;
+    SimModem modem;
+    GSM gsm(&modem);
+    BasicSmsQueue<4> queue;
+    gsm.begin();
+    gsm.setSmsQueue(&queue);
+    queue.setCoalesceWindow(mode == Mode::COALESCE ? COALESCE_WINDOW : 0);
+    modem.failSends(failingSends);
+    modem.setEcho(echo);
+
+    char msg[MSG_LENGTH];
+    makeAdeonMsg(msg, sizeof(msg), "Relay = 1;");
+    char recipient[SMS_PHONE_LENGTH];
+    char reply[24];
+
+    unsigned long start = millis();
+    unsigned long end = start + bursts * BURST_INTERVAL;
+    unsigned long nextSms = start;
+    unsigned long delivered[BURST_SIZE * 2] = {};
+    uint8_t head = 0;
+    uint8_t tail = 0;
+    uint8_t inBurst = 0;
+    while((long)(millis() - end) < 0 || gsm.isBusy() || queue.getDepth() > 0 || modem.available()){
+        delay(COMMAND_POLL_TIME);
+        if((long)(millis() - nextSms) >= 0 && (long)(nextSms - end) < 0){
+            modem.deliverSms(sender, msg);
+            delivered[tail] = nextSms;
+            tail = (tail + 1) % (BURST_SIZE * 2);
+            if(++inBurst == BURST_SIZE){
+                inBurst = 0;
+                nextSms += BURST_INTERVAL - (BURST_SIZE - 1) * BURST_GAP;
+            }
+            else{
+                nextSms += BURST_GAP;
+            }
+        }
+
+        unsigned long loopStart = millis();
+        gsm.checkGsmOutput();
+        if(gsm.isNewMsgAvailable()){
+            gsm.getMsg();
+            unsigned long cmdDelay = millis() - delivered[head];
+            head = (head + 1) % (BURST_SIZE * 2);
+            if(cmdDelay > result.maxCmdDelay){
+                result.maxCmdDelay = cmdDelay;
+            }
+            result.commands++;
+
+            snprintf(recipient, sizeof(recipient), "+%s", gsm.getPhoneNum());
+            snprintf(reply, sizeof(reply), replyFormat, result.commands);
+            gsm.sendSms(recipient, reply);
+            if(mode == Mode::BLOCKING){
+                while(queue.getDepth() > 0){
+                    delay(COMMAND_POLL_TIME);
+                    gsm.checkGsmOutput();
+                }
+            }
+        }
+        result.early |= queue.getStats().sent > modem.getSentSms();
+        unsigned long stall = millis() - loopStart;
+        if(stall > result.maxStall){
+            result.maxStall = stall;
+        }
+    }
+    result.smsSent = modem.getSentSms();
+    result.stats = queue.getStats();
+    return result;
+}
+
+int main(int argc, char** argv){
+    unsigned long bursts = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 100;
+    if(bursts == 0){
+        fprintf(stderr, "bursts must be at least 1\n");
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    static const char* names[] = {"blocking", "queue", "coalesce", "coalesce*", "echo", "echo OK"};
+    static const Mode modes[] = {Mode::BLOCKING, Mode::QUEUE, Mode::COALESCE, Mode::COALESCE, Mode::QUEUE, Mode::QUEUE};
+    bool lost = false;
+
+    printf("%-10s %8s %12s %12s %6s %9s %6s %7s %15s\n", "mode", "commands", "max stall ms", "max delay ms",
+           "SMS", "coalesced", "failed", "dropped", "max latency ms");
+    for(uint8_t m = 0; m < 6; m++){
+        Result r = run(modes[m], bursts, (m == 3) ? 2 : 0, m >= 4, (m == 5) ? "Relay=1 OK #%lu" : "Relay=1 #%lu");
+        printf("%-10s %8lu %12lu %12lu %6lu %9lu %6lu %7lu %15lu\n", names[m], r.commands, r.maxStall,
+               r.maxCmdDelay, (unsigned long)r.smsSent, (unsigned long)r.stats.coalesced,
+               (unsigned long)r.stats.failed, (unsigned long)r.stats.dropped, r.stats.maxLatency);
+        lost |= r.commands != bursts * BURST_SIZE || r.stats.queued != r.commands
+                || r.stats.sent != r.smsSent || r.stats.failed != 0 || r.stats.dropped != 0
+                || r.early || (modes[m] != Mode::COALESCE && r.smsSent != r.commands);
+    }
+    printf("* modem refuses the first 2 sends, they are retried after %d ms\n", SMS_RETRY_TIME);
+    return lost ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/**
+ *  @file       StatusReply.cpp
+ *  Project     AdeonGSM
+ *  @brief      Cost of status query with cached reply
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * "status?" answered by Adeon with a parameter table of 8, 20 and 40 parameters:
+ *  - cached:  nothing changes between polls, reply is taken from the cache
+ *  - changed: one parameter is edited before each poll, reply is rendered again
+ *
+ * Time is the whole parseBuf() including hash check, render time is the difference.
+ * A message without query between two polls must not spoil the cached status.
+ * Exit code is non-zero if a cached reply differs from a freshly rendered one.
+ *
+ * Usage: StatusReply [polls]
+ * Default: 200000 polls.
+ */
+
+#include <AdeonGSM.h>
+#include <chrono>
+#include <string>
+#include "../common/SimModem.h"
+
+static double measure(AdeonBase& adeon, const char* msg, unsigned long polls, bool change){
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < polls; i++){
+        if(change){
+            adeon.editParamValue("p00", i % 100);
+        }
+        adeon.parseBuf(msg, ADEON_ADMIN);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / polls;
+}
+
+int main(int argc, char** argv){
+    unsigned long polls = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 200000;
+    if(polls == 0){
+        fprintf(stderr, "polls must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+
+    char msg[MSG_BUFFER_LENGTH];
+    makeAdeonMsg(msg, sizeof(msg), "status?");
+    char payload[MSG_BUFFER_LENGTH];
+    bool mismatch = false;
+
+    static const uint8_t sizes[] = {8, 20, 40};
+    printf("%7s %10s %12s %12s %10s\n", "params", "reply len", "cached ns", "changed ns", "render ns");
+    for(uint8_t s = 0; s < 3; s++){
+        Adeon adeon;
+        char name[LIST_ITEM_LENGTH];
+        for(uint8_t i = 0; i < sizes[s]; i++){
+            snprintf(name, sizeof(name), "p%02u", i);
+            adeon.addParam(name, 100 + i);
+        }
+        adeon.parseBuf(msg, ADEON_ADMIN);
+        std::string cached = adeon.getReply();
+        double cachedNs = measure(adeon, msg, polls, false);
+        double changedNs = measure(adeon, msg, polls, true);
+
+        //cache must give the same text as rendering after a change
+        adeon.editParamValue("p00", 100);
+        adeon.parseBuf(msg, ADEON_ADMIN);
+        mismatch |= cached != adeon.getReply();
+        snprintf(payload, sizeof(payload), "%s", adeon.getReply());
+
+        //valid message which changes nothing keeps the cache usable
+        char noQuery[MSG_BUFFER_LENGTH];
+        makeAdeonMsg(noQuery, sizeof(noQuery), "nosuch = 5;");
+        adeon.parseBuf(noQuery, ADEON_ADMIN);
+        mismatch |= adeon.getReply() != nullptr;
+        adeon.parseBuf(msg, ADEON_ADMIN);
+        mismatch |= adeon.getReply() == nullptr || cached != adeon.getReply();
+
+        printf("%7u %10zu %12.0f %12.0f %10.0f\n", sizes[s], strlen(payload), cachedNs, changedNs,
+               changedNs - cachedNs);
+    }
+    printf("cached status %s\n", mismatch ? "MISMATCH" : "match");
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/**
+ *  @file       TicklessWakeups.cpp
+ *  Project     AdeonGSM
+ *  @brief      Loop wakeups with tickless deadlines
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Wakeups of the sketch loop per hour of virtual time, idle and under load:
+ *  - fixed:    poll() every COMMAND_POLL_TIME
+ *  - deadline: sleep until GSM::nextDeadline() with default idle check
+ *  - serial:   sleep until nextDeadline() or serial activity, idle check once a minute
+ *
+ * Under load one SMS is delivered every load interval. Exit code is non-zero
+ * if any message is lost.
+ *
+ * Usage: TicklessWakeups [hours] [load interval s]
+ * Default: 1 hour, one SMS per 10 seconds.
+ */
+
+#include <utility/SIMlib.h>
+#include "../common/SimModem.h"
+
+constexpr static unsigned long SERIAL_IDLE_CHECK = 60000; //ms
+
+static const char* sender = "420598632485";
+
+enum class Mode : uint8_t {
+    FIXED,
+    DEADLINE,
+    SERIAL_WAKE
+};
+
+struct Result {
+    unsigned long wakeups = 0;
+    unsigned long sent = 0;
+    unsigned long received = 0;
+    unsigned long maxLatency = 0;
+};
+
+/**
+ * @brief Run the sketch loop for given virtual time.
+ * @param smsInterval is time between messages in ms (0 for idle).
+ */
+static Result run(Mode mode, unsigned long duration, unsigned long smsInterval){
+    Result result;
+    SimModem modem;
+    GSM gsm(&modem);
+    gsm.begin();
+    if(mode == Mode::SERIAL_WAKE){
+        gsm.setIdleCheckTime(SERIAL_IDLE_CHECK);
+    }
+
+    char msg[MSG_LENGTH];
+    makeAdeonMsg(msg, sizeof(msg), "Relay = 1;");
+
+    unsigned long start = millis();
+    unsigned long nextSms = start + smsInterval;
+    unsigned long lastSent = 0;
+    while(millis() - start < duration){
+        unsigned long now = millis();
+        unsigned long wake;
+        if(mode == Mode::FIXED){
+            wake = now + COMMAND_POLL_TIME;
+        }
+        else{
+            wake = gsm.nextDeadline();
+            if((long)(wake - now) < 0){
+                wake = now;
+            }
+            //SMS arrival is serial activity
+            if(mode == Mode::SERIAL_WAKE && smsInterval != 0 && (long)(nextSms - wake) < 0){
+                wake = nextSms;
+            }
+        }
+        HostClock::advance(wake - now);
+
+        if(smsInterval != 0 && (long)(millis() - nextSms) >= 0){
+            modem.deliverSms(sender, msg);
+            lastSent = nextSms;
+            nextSms += smsInterval;
+            result.sent++;
+        }
+        gsm.poll();
+        result.wakeups++;
+
+        if(gsm.isNewMsgAvailable()){
+            gsm.getMsg();
+            result.received++;
+            unsigned long latency = millis() - lastSent;
+            if(latency > result.maxLatency){
+                result.maxLatency = latency;
+            }
+        }
+    }
+    //messages delivered just before the end
+    while(gsm.isBusy() || modem.available()){
+        delay(COMMAND_POLL_TIME);
+        gsm.poll();
+        if(gsm.isNewMsgAvailable()){
+            gsm.getMsg();
+            result.received++;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv){
+    unsigned long hours = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 1;
+    unsigned long interval = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 10;
+    if(hours == 0 || interval == 0){
+        fprintf(stderr, "hours and load interval must be at least 1\n");
+        return 1;
+    }
+    HostClock::useVirtual(true);
+    Serial.mute(true);
+
+    static const char* names[] = {"fixed", "deadline", "serial"};
+    static const Mode modes[] = {Mode::FIXED, Mode::DEADLINE, Mode::SERIAL_WAKE};
+    bool lost = false;
+
+    printf("%-9s %14s %14s %10s %16s\n", "mode", "idle wakes/h", "load wakes/h", "received", "max latency ms");
+    for(uint8_t m = 0; m < 3; m++){
+        Result idle = run(modes[m], hours * 3600000UL, 0);
+        Result load = run(modes[m], hours * 3600000UL, interval * 1000);
+        printf("%-9s %14lu %14lu %5lu/%-5lu %16lu\n", names[m], idle.wakeups / hours, load.wakeups / hours,
+               load.received, load.sent, load.maxLatency);
+        lost |= load.received != load.sent;
+    }
+    return lost ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+/**
+ *  @file       TimedEdits.cpp
+ *  Project     AdeonGSM
+ *  @brief      Cost of tick() with pending timed edits
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Parameters are switched on by "relayNNN = 1 for seconds;" with random time from 1 s
+ * to 2 hours, so that the given number of edits is always pending. Parameter which went
+ * off is switched on again by a new message. Virtual clock advances by one tick of the wheel
+ * per loop and only tick() is timed:
+ *  - wheel: Adeon::tick() with TimerWheel
+ *  - scan:  loop over all parameters comparing their deadline, as sketches did by millis()
+ * Exit code is non-zero if an edit comes early or more than one tick late.
+ *
+ * Usage: TimedEdits [virtual hours]
+ * Default: 4 hours.
+ */
+
+#include <AdeonGSM.h>
+#include <chrono>
+#include "../common/SimModem.h"
+
+constexpr static auto MAX_TIMERS = 254;
+constexpr static auto MAX_SECONDS = 7200;
+
+static unsigned long virtualTime = 0;
+static unsigned long virtualMillis(){
+    return virtualTime;
+}
+
+static unsigned long deadlines[MAX_TIMERS]; // when the running edit of each parameter is due
+static bool wrongTime = false;
+static uint16_t fired = 0;
+
+static unsigned long randomSeconds(){
+    return 1 + (unsigned long)rand() % MAX_SECONDS;
+}
+
+static void switchOn(Adeon& adeon, uint16_t index){
+    char payload[40];
+    char msg[MSG_BUFFER_LENGTH + 1];
+    unsigned long seconds = randomSeconds();
+    snprintf(payload, sizeof(payload), "relay%03u = 1 for %lu;", index, seconds);
+    makeAdeonMsg(msg, sizeof(msg), payload);
+    adeon.parseBuf(msg, ADEON_ADMIN);
+    deadlines[index] = virtualTime + seconds * 1000;
+}
+
+struct Result {
+    double nsPerTick;
+    uint32_t edits;
+};
+
+static void relayCallback(uint16_t val){
+    if(val == 0){
+        fired++;
+    }
+}
+
+static Result runWheel(uint16_t pending, unsigned long hours){
+    Adeon adeon;
+    BasicTimerWheel<MAX_TIMERS> wheel;
+    wheel.setClock(virtualMillis);
+    adeon.setTimerWheel(&wheel);
+
+    char name[LIST_ITEM_LENGTH];
+    for(uint16_t i = 0; i < pending; i++){
+        snprintf(name, sizeof(name), "relay%03u", i);
+        adeon.addParamWithCallback(relayCallback, name, 0);
+        switchOn(adeon, i);
+    }
+
+    Result result = {0, 0};
+    std::chrono::duration<double, std::nano> spent(0);
+    unsigned long end = virtualTime + hours * 3600000UL;
+    while(virtualTime < end){
+        virtualTime += TIMER_WHEEL_TICK;
+        fired = 0;
+        auto start = std::chrono::steady_clock::now();
+        adeon.tick();
+        spent += std::chrono::steady_clock::now() - start;
+        if(fired == 0){
+            continue;
+        }
+        //find parameters which went off, check their time and switch them on again
+        for(uint16_t i = 0; i < pending; i++){
+            snprintf(name, sizeof(name), "relay%03u", i);
+            if(adeon.getParamValue(name) == 0){
+                if(virtualTime < deadlines[i] || virtualTime - deadlines[i] > TIMER_WHEEL_TICK){
+                    wrongTime = true;
+                }
+                result.edits++;
+                switchOn(adeon, i);
+            }
+        }
+    }
+    result.nsPerTick = spent.count() / (hours * 3600000UL / TIMER_WHEEL_TICK);
+    return result;
+}
+
+static Result runScan(uint16_t pending, unsigned long hours){
+    Result result = {0, 0};
+    for(uint16_t i = 0; i < pending; i++){
+        deadlines[i] = virtualTime + randomSeconds() * 1000;
+    }
+    volatile uint16_t sink = 0;
+    std::chrono::duration<double, std::nano> spent(0);
+    unsigned long end = virtualTime + hours * 3600000UL;
+    while(virtualTime < end){
+        virtualTime += TIMER_WHEEL_TICK;
+        auto start = std::chrono::steady_clock::now();
+        for(uint16_t i = 0; i < pending; i++){
+            if((long)(virtualTime - deadlines[i]) >= 0){
+                sink = sink + i;
+                deadlines[i] = virtualTime + randomSeconds() * 1000;
+                result.edits++;
+            }
+        }
+        spent += std::chrono::steady_clock::now() - start;
+    }
+    result.nsPerTick = spent.count() / (hours * 3600000UL / TIMER_WHEEL_TICK);
+    return result;
+}
+
+int main(int argc, char** argv){
+    unsigned long hours = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4;
+    if(hours == 0){
+        fprintf(stderr, "hours must be at least 1\n");
+        return 1;
+    }
+    Serial.mute(true);
+    srand(1);
+
+    static const uint16_t counts[] = {1, 8, 64, MAX_TIMERS};
+    printf("%8s %10s %14s %10s %14s\n", "pending", "edits", "wheel ns/tick", "scan edits", "scan ns/tick");
+    for(uint16_t pending : counts){
+        Result wheel = runWheel(pending, hours);
+        Result scan = runScan(pending, hours);
+        printf("%8u %10u %14.0f %10u %14.0f\n", pending, wheel.edits, wheel.nsPerTick, scan.edits, scan.nsPerTick);
+    }
+    if(wrongTime){
+        printf("edit came at wrong time\n");
+    }
+    return wrongTime ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/**
+ *  @file       FirstFitArena.cpp
+ *  Project     AdeonGSM
+ *  @brief      Simulated small heap for host benchmarks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FirstFitArena.h"
+#include <utility/memstats.h>
+
+constexpr size_t FirstFitArena::ALIGN;
+constexpr size_t FirstFitArena::HEADER;
+FirstFitArena* FirstFitArena::_pInstalled = nullptr;
+
+/**
+ * @brief Constructor for the class FirstFitArena.
+ * @param size is number of bytes of simulated heap (headers included).
+ */
+FirstFitArena::FirstFitArena(size_t size){
+    _size = size & ~(ALIGN - 1);
+    _pMemory = (uint8_t*)aligned_alloc(ALIGN, _size);
+    Header* pFirst = (Header*)_pMemory;
+    pFirst->size = _size - HEADER;
+    pFirst->free = 1;
+}
+
+FirstFitArena::~FirstFitArena(){
+    if(_pInstalled == this){
+        install(nullptr);
+    }
+    free(_pMemory);
+}
+
+/**
+ * @brief Allocate block from the first free block which is big enough.
+ * @param size is number of requested bytes.
+ * @return Pointer to payload (null if no free block fits).
+ */
+void* FirstFitArena::allocate(size_t size){
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    if(size == 0){
+        size = ALIGN;
+    }
+    for(Header* pBlock = (Header*)_pMemory; pBlock != nullptr; pBlock = next(pBlock)){
+        if(pBlock->free && pBlock->size >= size){
+            if(pBlock->size >= size + HEADER + ALIGN){
+                Header* pRest = (Header*)((uint8_t*)pBlock + HEADER + size);
+                pRest->size = pBlock->size - size - HEADER;
+                pRest->free = 1;
+                pBlock->size = size;
+            }
+            pBlock->free = 0;
+            return (uint8_t*)pBlock + HEADER;
+        }
+    }
+    _failCount++;
+    return nullptr;
+}
+
+/**
+ * @brief Return block to the arena and merge free neighbours.
+ * @param ptr is pointer returned by allocate() (null is ignored).
+ */
+void FirstFitArena::release(void* ptr){
+    if(ptr != nullptr){
+        Header* pBlock = (Header*)((uint8_t*)ptr - HEADER);
+        pBlock->free = 1;
+        merge();
+    }
+}
+
+size_t FirstFitArena::getSize(){
+    return _size;
+}
+
+/**
+ * @brief Get sum of free payload bytes.
+ */
+size_t FirstFitArena::getFreeBytes(){
+    size_t sum = 0;
+    for(Header* pBlock = (Header*)_pMemory; pBlock != nullptr; pBlock = next(pBlock)){
+        sum += pBlock->free ? pBlock->size : 0;
+    }
+    return sum;
+}
+
+/**
+ * @brief Get size of the largest allocation which can succeed.
+ */
+size_t FirstFitArena::getLargestFreeBlock(){
+    size_t largest = 0;
+    for(Header* pBlock = (Header*)_pMemory; pBlock != nullptr; pBlock = next(pBlock)){
+        if(pBlock->free && pBlock->size > largest){
+            largest = pBlock->size;
+        }
+    }
+    return largest;
+}
+
+/**
+ * @brief Get fragmentation ratio.
+ * @return 1 - largest free block / free bytes (0 means one contiguous free block).
+ */
+float FirstFitArena::getFragmentation(){
+    size_t freeBytes = getFreeBytes();
+    if(freeBytes == 0){
+        return 0.0f;
+    }
+    return 1.0f - (float)getLargestFreeBlock() / (float)freeBytes;
+}
+
+/**
+ * @brief Get number of refused allocations.
+ */
+uint32_t FirstFitArena::getFailCount(){
+    return _failCount;
+}
+
+/**
+ * @brief Route all MemoryAccount allocations to the arena.
+ * @param pArena is pointer to arena (null restores malloc and free).
+ */
+void FirstFitArena::install(FirstFitArena* pArena){
+    _pInstalled = pArena;
+    if(pArena != nullptr){
+        MemoryAccount::setAllocator(installedAlloc, installedFree);
+    }
+    else{
+        MemoryAccount::setAllocator(nullptr, nullptr);
+    }
+}
+
+FirstFitArena::Header* FirstFitArena::next(Header* pBlock){
+    uint8_t* pNext = (uint8_t*)pBlock + HEADER + pBlock->size;
+    return (pNext < _pMemory + _size) ? (Header*)pNext : nullptr;
+}
+
+void FirstFitArena::merge(){
+    Header* pBlock = (Header*)_pMemory;
+    while(pBlock != nullptr){
+        Header* pNext = next(pBlock);
+        if(pNext != nullptr && pBlock->free && pNext->free){
+            pBlock->size += HEADER + pNext->size;
+        }
+        else{
+            pBlock = pNext;
+        }
+    }
+}
+
+void* FirstFitArena::installedAlloc(size_t size){
+    return _pInstalled->allocate(size);
+}
+
+void FirstFitArena::installedFree(void* ptr){
+    _pInstalled->release(ptr);
+}
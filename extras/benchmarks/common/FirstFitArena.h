@@ -0,0 +1,75 @@
+/**
+ *  @file       FirstFitArena.h
+ *  Project     AdeonGSM
+ *  @brief      Simulated small heap for host benchmarks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_FIRST_FIT_ARENA_H
+#define ADEON_FIRST_FIT_ARENA_H
+
+#include <Arduino.h>
+
+/**
+ * @brief First-fit heap on a fixed memory block, similar to avr-libc malloc.
+ * 
+ * Each block has a header with its size, free blocks are split on allocation
+ * and merged with free neighbours on release. Blocks are aligned to 8 bytes,
+ * so pointers returned on a 64-bit host are valid for any object.
+ */
+class FirstFitArena {
+    public:
+        FirstFitArena(size_t size);
+        ~FirstFitArena();
+
+        void* allocate(size_t size);
+        void release(void* ptr);
+
+        size_t getSize();
+        size_t getFreeBytes();
+        size_t getLargestFreeBlock();
+        float getFragmentation();
+        uint32_t getFailCount();
+
+        static void install(FirstFitArena* pArena);
+
+    private:
+        struct Header {
+            size_t size; // payload bytes
+            size_t free;
+        };
+
+    public:
+        static constexpr size_t ALIGN = 8;
+        static constexpr size_t HEADER = (sizeof(Header) + ALIGN - 1) & ~(ALIGN - 1);
+
+    private:
+
+        Header* next(Header* pBlock);
+        void merge();
+
+        uint8_t* _pMemory;
+        size_t _size;
+        uint32_t _failCount = 0;
+
+        static FirstFitArena* _pInstalled;
+        static void* installedAlloc(size_t size);
+        static void installedFree(void* ptr);
+};
+
+#endif // ADEON_FIRST_FIT_ARENA_H
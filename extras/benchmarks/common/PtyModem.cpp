@@ -0,0 +1,106 @@
+/**
+ *  @file       PtyModem.cpp
+ *  Project     AdeonGSM
+ *  @brief      Simulated GSM modem behind a pseudo-terminal
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "PtyModem.h"
+
+#include <poll.h>
+#include <pty.h>
+#include <unistd.h>
+
+PtyModem::~PtyModem(){
+    close();
+}
+
+/**
+ * @brief Create the pseudo-terminal and start the bridge thread.
+ * @return <code>true</code> if device is ready, <code>false</code> otherwise.
+ */
+bool PtyModem::open(){
+    if(_running){
+        return false;
+    }
+    if(openpty(&_masterFd, &_slaveFd, _device, nullptr, nullptr) != 0){
+        return false;
+    }
+    _running = true;
+    _thread = std::thread(&PtyModem::bridge, this);
+    return true;
+}
+
+/**
+ * @brief Stop the bridge thread and close the pseudo-terminal.
+ */
+void PtyModem::close(){
+    _running = false;
+    if(_thread.joinable()){
+        _thread.join();
+    }
+    if(_slaveFd >= 0){
+        ::close(_slaveFd);
+        ::close(_masterFd);
+        _slaveFd = -1;
+        _masterFd = -1;
+    }
+}
+
+/**
+ * @brief Get path of the slave side, e.g. "/dev/pts/3".
+ */
+const char* PtyModem::getDevice(){
+    return _device;
+}
+
+bool PtyModem::deliverSms(const char* sender, const char* body){
+    std::lock_guard<std::mutex> guard(_lock);
+    return _modem.deliverSms(sender, body);
+}
+
+uint8_t PtyModem::getStoredSms(){
+    std::lock_guard<std::mutex> guard(_lock);
+    return _modem.getStoredSms();
+}
+
+/**
+ * @brief Move bytes between master side of the pseudo-terminal and simulated modem.
+ */
+void PtyModem::bridge(){
+    uint8_t buf[256];
+    while(_running){
+        struct pollfd pfd = {_masterFd, POLLIN, 0};
+        if(poll(&pfd, 1, 1) > 0){
+            ssize_t n = read(_masterFd, buf, sizeof(buf));
+            std::lock_guard<std::mutex> guard(_lock);
+            for(ssize_t i = 0; i < n; i++){
+                _modem.write(buf[i]);
+            }
+        }
+        std::lock_guard<std::mutex> guard(_lock);
+        size_t len = 0;
+        while(_modem.available() && len < sizeof(buf)){
+            buf[len++] = _modem.read();
+        }
+        if(len > 0 && write(_masterFd, buf, len) != (ssize_t)len){
+            fprintf(stderr, "pty write failed\n");
+        }
+    }
+}
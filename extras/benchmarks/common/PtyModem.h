@@ -0,0 +1,61 @@
+/**
+ *  @file       PtyModem.h
+ *  Project     AdeonGSM
+ *  @brief      Simulated GSM modem behind a pseudo-terminal
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ADEON_PTY_MODEM_H
+#define ADEON_PTY_MODEM_H
+
+#include "SimModem.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief SimModem reachable through the slave side of a pseudo-terminal.
+ * 
+ * Master side is bridged to the modem by a thread, so the slave device can be opened
+ * by PosixSerial like a USB modem. Modem methods are called under a lock.
+ */
+class PtyModem {
+    public:
+        ~PtyModem();
+
+        bool open();
+        void close();
+        const char* getDevice();
+        bool deliverSms(const char* sender, const char* body);
+        uint8_t getStoredSms();
+
+    private:
+        void bridge();
+
+        SimModem _modem;
+        std::mutex _lock;
+        std::atomic<bool> _running{false};
+        std::thread _thread;
+        int _masterFd = -1;
+        int _slaveFd = -1;
+        char _device[64] = {};
+};
+
+#endif // ADEON_PTY_MODEM_H
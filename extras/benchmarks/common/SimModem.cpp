@@ -0,0 +1,481 @@
+/**
+ *  @file       SimModem.cpp
+ *  Project     AdeonGSM
+ *  @brief      Simulated GSM modem for host benchmarks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SimModem.h"
+#include <AdeonGSM.h>
+
+/**
+ * @brief Store SMS into first free slot and announce it by +CMTI.
+ * @param sender is phone number without leading plus.
+ * @param body is SMS text.
+ * @return <code>true</code> if SMS is stored, <code>false</code> if SIM storage is full.
+ */
+bool SimModem::deliverSms(const char* sender, const char* body){
+    return store(sender, body, 4, strlen(body));
+}
+
+/**
+ * @brief Convert ASCII character to GSM 7-bit default alphabet.
+ * @param pSeptets is pointer to output of two septets.
+ * @return Number of septets, characters of extension table are preceded by escape 0x1B.
+ */
+static uint8_t toSeptets(char c, uint8_t* pSeptets){
+    const char* extension = "^{}\\[~]|";
+    const uint8_t extensionCodes[] = {0x14, 0x28, 0x29, 0x2F, 0x3C, 0x3D, 0x3E, 0x40};
+    const char* pExt = (c != '\0') ? strchr(extension, c) : nullptr;
+    if(pExt != nullptr){
+        pSeptets[0] = 0x1B;
+        pSeptets[1] = extensionCodes[pExt - extension];
+        return 2;
+    }
+    switch(c){
+    case '@': pSeptets[0] = 0x00; break;
+    case '$': pSeptets[0] = 0x02; break;
+    case '_': pSeptets[0] = 0x11; break;
+    case '`': pSeptets[0] = '?'; break;
+    default: pSeptets[0] = ((uint8_t)c < 0x7F) ? c : '?'; break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Store long SMS as parts of 7-bit text with concatenation header and announce them.
+ * @param sender is phone number without leading plus.
+ * @param body is SMS text.
+ * @param ref is reference number of the message.
+ * @param skipPart is sequence number of part which is lost in the network (0 delivers all).
+ * @return Number of parts of the message, 0 if SIM storage is full.
+ */
+uint8_t SimModem::deliverConcatSms(const char* sender, const char* body, uint8_t ref, uint8_t skipPart){
+    static uint8_t septets[SIM_MODEM_SLOTS * SIM_MODEM_PART_SEPTETS];
+    uint16_t count = 0;
+    for(const char* p = body; *p != '\0' && (size_t)count + 2 <= sizeof(septets); p++){
+        count += toSeptets(*p, &septets[count]);
+    }
+    //escape is not separated from its character
+    uint8_t total = 0;
+    uint16_t starts[SIM_MODEM_SLOTS];
+    for(uint16_t start = 0; start < count && total < SIM_MODEM_SLOTS; total++){
+        starts[total] = start;
+        uint16_t end = (count - start > SIM_MODEM_PART_SEPTETS) ? start + SIM_MODEM_PART_SEPTETS : count;
+        if(end < count && septets[end - 1] == 0x1B){
+            end--;
+        }
+        start = end;
+    }
+    for(uint8_t seq = 1; seq <= total; seq++){
+        uint16_t start = starts[seq - 1];
+        uint16_t end = (seq < total) ? starts[seq] : count;
+        if(end - start > SIM_MODEM_PART_SEPTETS){
+            end = start + SIM_MODEM_PART_SEPTETS; // rest does not fit into SIM storage
+        }
+        //header of 6 octets takes 7 septets with a fill bit
+        uint8_t data[140] = {0x05, 0x00, 0x03, ref, total, seq};
+        uint16_t length = 7 + end - start;
+        for(uint16_t i = start; i < end; i++){
+            uint16_t bit = (7 + i - start) * 7;
+            data[bit / 8] |= septets[i] << (bit % 8);
+            if(bit % 8 > 1){
+                data[bit / 8 + 1] |= septets[i] >> (8 - bit % 8);
+            }
+        }
+        char hex[2 * sizeof(data) + 1];
+        uint16_t bytes = (length * 7 + 7) / 8;
+        for(uint16_t i = 0; i < bytes; i++){
+            snprintf(&hex[2 * i], 3, "%02X", data[i]);
+        }
+        hex[2 * bytes] = '\0';
+        if(seq != skipPart && !store(sender, hex, 0x44, length)){
+            return 0;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Store SMS into first free slot and announce it by +CMTI.
+ * @param sender is phone number without leading plus.
+ * @param body is SMS text, user data in hex for SMS with header.
+ * @param firstOctet is first octet of SMS, 0x40 marks user data header.
+ * @param length is number of characters or septets.
+ * @return <code>true</code> if SMS is stored, <code>false</code> if SIM storage is full.
+ */
+bool SimModem::store(const char* sender, const char* body, uint8_t firstOctet, uint8_t length){
+    for(uint8_t i = 0; i < SIM_MODEM_SLOTS; i++){
+        if(!_storage[i].used){
+            _storage[i].used = true;
+            _storage[i].firstOctet = firstOctet;
+            _storage[i].length = length;
+            snprintf(_storage[i].sender, sizeof(_storage[i].sender), "%s", sender);
+            snprintf(_storage[i].body, sizeof(_storage[i].body), "%s", body);
+            char urc[32];
+            snprintf(urc, sizeof(urc), "\r\n+CMTI: \"SM\",%u\r\n", _firstIndex + i);
+            reply(urc);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get number of SMS kept in SIM storage.
+ */
+uint8_t SimModem::getStoredSms(){
+    uint8_t count = 0;
+    for(uint8_t i = 0; i < SIM_MODEM_SLOTS; i++){
+        count += _storage[i].used ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Get number of processed command lines.
+ */
+uint32_t SimModem::getCommandCount(){
+    return _commands;
+}
+
+/**
+ * @brief Restart modem with radio off and PDU mode, commands are ignored during boot.
+ * @param bootTime is time in ms until modem answers.
+ */
+void SimModem::powerOn(unsigned long bootTime){
+    _readyTime = millis() + bootTime;
+    _hold = true;
+    _cfun = 0;
+    _cmgf = 0;
+    _outHead = _outTail;
+}
+
+/**
+ * @brief Model speed of the serial link.
+ * @param baud is rate of both the modem and the host.
+ * @param maxBaud is the highest rate accepted by AT+IPR.
+ */
+void SimModem::modelLink(long baud, long maxBaud){
+    _linkModel = true;
+    _baud = baud;
+    _hostBaud = baud;
+    _maxBaud = maxBaud;
+}
+
+/**
+ * @brief Set rate of the host port, e.g. from the baud handler of GSM.
+ */
+void SimModem::setHostBaud(long baud){
+    _hostBaud = baud;
+}
+
+/**
+ * @brief Set the highest rate at which the host receives correctly (0 for no limit).
+ */
+void SimModem::setReceiveLimit(long baud){
+    _receiveLimit = baud;
+}
+
+/**
+ * @brief Get rate of the modem.
+ */
+long SimModem::getBaud(){
+    return _baud;
+}
+
+/**
+ * @brief Let the next sends fail with +CMS ERROR.
+ * @param count is number of failing sends.
+ */
+void SimModem::failSends(uint8_t count){
+    _failSends = count;
+}
+
+/**
+ * @brief Set index of the first slot, e.g. 100 for a modem with SMS kept in larger storage.
+ * @param firstIndex is index announced for SMS in the first slot (default 1).
+ */
+void SimModem::setFirstIndex(uint16_t firstIndex){
+    _firstIndex = firstIndex;
+}
+
+/**
+ * @brief Echo command lines and text of SMS.
+ * @param echo is <code>true</code> for echo like ATE1, <code>false</code> like ATE0.
+ */
+void SimModem::setEcho(bool echo){
+    _echo = echo;
+}
+
+/**
+ * @brief Get number of SMS confirmed by the modem.
+ */
+uint32_t SimModem::getSentSms(){
+    return _sentSms;
+}
+
+/**
+ * @brief Get recipient of the last sent SMS.
+ */
+const char* SimModem::getLastRecipient(){
+    return _recipient;
+}
+
+/**
+ * @brief Get text of the last sent SMS.
+ */
+const char* SimModem::getLastSentText(){
+    return _sentText;
+}
+
+int SimModem::available(){
+    if(_sendPending && (long)(millis() - _sendDoneTime) >= 0){
+        _sendPending = false;
+        _sentSms += _sendConfirms;
+        reply(_sendAnswer);
+    }
+    if(_linkModel && (long)(millis() - _txDoneTime) < 0){
+        return 0;
+    }
+    if(_hold){
+        if((long)(millis() - _readyTime) < 0){
+            return 0;
+        }
+        _hold = false;
+    }
+    return (_outTail + SIM_MODEM_OUTPUT - _outHead) % SIM_MODEM_OUTPUT;
+}
+
+int SimModem::read(){
+    if(available() == 0){
+        return -1;
+    }
+    uint8_t c = _out[_outHead];
+    _outHead = (_outHead + 1) % SIM_MODEM_OUTPUT;
+    return c;
+}
+
+int SimModem::peek(){
+    return (available() == 0) ? -1 : (uint8_t)_out[_outHead];
+}
+
+size_t SimModem::write(uint8_t c){
+    if(_linkModel && _hostBaud != _baud){
+        return 1; // modem does not understand bytes at other rate
+    }
+    if(_echo && c != 0x1A && c != 0x1B){
+        char echo[2] = {(char)c, '\0'};
+        reply(echo);
+    }
+    if(_prompt){
+        if(c == 0x1A){
+            _line[_lineLen] = '\0';
+            finishSending();
+        }
+        else if(c == 0x1B){
+            _prompt = false;
+            reply("\r\nOK\r\n");
+        }
+        else if(_lineLen < sizeof(_line) - 1){
+            _line[_lineLen++] = c;
+        }
+        return 1;
+    }
+    if(c == '\n'){
+        _line[_lineLen] = '\0';
+        processLine();
+        _lineLen = 0;
+    }
+    else if(c != '\r' && _lineLen < sizeof(_line) - 1){
+        _line[_lineLen++] = c;
+    }
+    return 1;
+}
+
+/**
+ * @brief Answer one command line.
+ */
+void SimModem::processLine(){
+    char buf[SIM_MODEM_SMS_LENGTH + 128];
+    _commands++;
+    if(_hold){
+        return; // booting or busy with radio
+    }
+
+    if(strncmp(_line, "AT+CMGR=", 8) == 0){
+        Sms* pSms = findSlot(parseIndex(&_line[8]));
+        if(pSms != nullptr && pSms->used){
+            if(_csdh){
+                snprintf(buf, sizeof(buf), "\r\n+CMGR: \"REC UNREAD\",\"+%s\",\"\",\"24/01/01,10:00:00+04\",145,%u,0,0,"
+                         "\"+420603000000\",145,%u\r\n%s\r\n\r\nOK\r\n",
+                         pSms->sender, pSms->firstOctet, pSms->length, pSms->body);
+            }
+            else{
+                snprintf(buf, sizeof(buf), "\r\n+CMGR: \"REC UNREAD\",\"+%s\",\"\",\"24/01/01,10:00:00+04\"\r\n%s\r\n\r\nOK\r\n",
+                         pSms->sender, pSms->body);
+            }
+            reply(buf);
+        }
+        else{
+            reply("\r\nERROR\r\n");
+        }
+    }
+    else if(strncmp(_line, "AT+CMGD=", 8) == 0){
+        Sms* pSms = findSlot(parseIndex(&_line[8]));
+        if(pSms != nullptr){
+            pSms->used = false;
+        }
+        reply("\r\nOK\r\n");
+    }
+    else if(strcmp(_line, "AT+CFUN?") == 0 || strcmp(_line, "AT+CMGF?") == 0 || strcmp(_line, "AT+CFUN?;+CMGF?") == 0){
+        //queries of the line are answered together with one final result
+        buf[0] = '\0';
+        if(strstr(_line, "+CFUN?") != nullptr){
+            snprintf(&buf[strlen(buf)], sizeof(buf) - strlen(buf), "\r\n+CFUN: %u\r\n", _cfun);
+        }
+        if(strstr(_line, "+CMGF?") != nullptr){
+            snprintf(&buf[strlen(buf)], sizeof(buf) - strlen(buf), "\r\n+CMGF: %u\r\n", _cmgf);
+        }
+        reply(buf);
+        reply("\r\nOK\r\n");
+    }
+    else if(strncmp(_line, "AT+CFUN=", 8) == 0){
+        uint8_t cfun = parseIndex(&_line[8]);
+        if(cfun != _cfun){
+            _cfun = cfun;
+            _readyTime = millis() + SIM_MODEM_RADIO_ON_TIME;
+            _hold = true;
+        }
+        reply("\r\nOK\r\n");
+    }
+    else if(strncmp(_line, "AT+IPR=", 7) == 0){
+        long baud = atol(&_line[7]);
+        if(_linkModel && (baud < 1200 || baud > _maxBaud)){
+            reply("\r\nERROR\r\n");
+        }
+        else{
+            reply("\r\nOK\r\n"); // still at the old rate
+            _baud = baud;
+        }
+    }
+    else if(strncmp(_line, "AT+CMGS=\"", 9) == 0 && _cmgf == 1){
+        char* pEnd = strchr(&_line[9], '"');
+        if(pEnd != nullptr){
+            *pEnd = '\0';
+        }
+        size_t length = strlen(&_line[9]);
+        if(length >= sizeof(_recipient)){
+            length = sizeof(_recipient) - 1;
+        }
+        memcpy(_recipient, &_line[9], length);
+        _recipient[length] = '\0';
+        _prompt = true;
+        _lineLen = 0;
+        reply("\r\n> ");
+    }
+    else if(strncmp(_line, "ATE", 3) == 0){
+        _echo = _line[3] == '1';
+        reply("\r\nOK\r\n");
+    }
+    else if(strncmp(_line, "AT+CSDH=", 8) == 0){
+        _csdh = parseIndex(&_line[8]) == 1;
+        reply("\r\nOK\r\n");
+    }
+    else if(strncmp(_line, "AT+CMGF=", 8) == 0){
+        _cmgf = parseIndex(&_line[8]);
+        reply("\r\nOK\r\n");
+    }
+    else if(strncmp(_line, "AT", 2) == 0){
+        reply("\r\nOK\r\n");
+    }
+    else{
+        reply("\r\nERROR\r\n");
+    }
+}
+
+/**
+ * @brief Confirm text of SMS received after the prompt, network answers after SIM_MODEM_SEND_TIME.
+ * 
+ * Commands and notifications are served meanwhile.
+ */
+void SimModem::finishSending(){
+    _prompt = false;
+    _lineLen = 0;
+    _sendDoneTime = millis() + SIM_MODEM_SEND_TIME;
+    _sendPending = true;
+    _sendConfirms = _failSends == 0;
+    if(!_sendConfirms){
+        _failSends--;
+        snprintf(_sendAnswer, sizeof(_sendAnswer), "\r\n+CMS ERROR: 500\r\n");
+        return;
+    }
+    snprintf(_sentText, sizeof(_sentText), "%s", _line);
+    snprintf(_sendAnswer, sizeof(_sendAnswer), "\r\n+CMGS: %lu\r\n\r\nOK\r\n", (unsigned long)((_sentSms + 1) % 256));
+}
+
+void SimModem::reply(const char* str){
+    if(_linkModel){
+        if(_hostBaud != _baud || (_receiveLimit != 0 && _hostBaud > _receiveLimit)){
+            return;
+        }
+        //10 bits per byte
+        unsigned long start = ((long)(millis() - _txDoneTime) < 0) ? _txDoneTime : millis();
+        _txDoneTime = start + (strlen(str) * 10000UL) / _baud;
+    }
+    while(*str){
+        uint16_t next = (_outTail + 1) % SIM_MODEM_OUTPUT;
+        if(next == _outHead){
+            return; // modem output overflow, rest is lost like on a real UART
+        }
+        _out[_outTail] = *str++;
+        _outTail = next;
+    }
+}
+
+uint16_t SimModem::parseIndex(const char* str){
+    return (uint16_t)atol(str);
+}
+
+/**
+ * @brief Get slot of SIM storage by index of AT+CMGR or AT+CMGD.
+ * @return Pointer to slot, null if index is out of the storage.
+ */
+SimModem::Sms* SimModem::findSlot(uint16_t index){
+    if(index < _firstIndex || index - _firstIndex >= SIM_MODEM_SLOTS){
+        return nullptr;
+    }
+    return &_storage[index - _firstIndex];
+}
+
+void makeAdeonMsg(char* pOut, size_t outLen, const char* pPayload){
+    MD5_CTX context;
+    unsigned char hash[16];
+    MD5::MD5Init(&context);
+    MD5::MD5Update(&context, pPayload, strlen(pPayload));
+    MD5::MD5Final(hash, &context);
+
+    static const char hexits[17] = "0123456789abcdef";
+    char digest[33];
+    for(uint8_t i = 0; i < 16; i++){
+        digest[i * 2] = hexits[hash[i] >> 4];
+        digest[i * 2 + 1] = hexits[hash[i] & 0x0F];
+    }
+    digest[32] = '\0';
+    snprintf(pOut, outLen, "%s: %s", &digest[32 - SHORT_HASH_LENGTH], pPayload);
+}
@@ -0,0 +1,128 @@
+/**
+ *  @file       SimModem.h
+ *  Project     AdeonGSM
+ *  @brief      Simulated GSM modem for host benchmarks
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_SIM_MODEM_H
+#define ADEON_SIM_MODEM_H
+
+#include <Arduino.h>
+
+constexpr static auto SIM_MODEM_SLOTS = 10;
+constexpr static auto SIM_MODEM_SMS_LENGTH = 320; // part of concatenated SMS in hex
+constexpr static auto SIM_MODEM_OUTPUT = 1024;
+constexpr static auto SIM_MODEM_RADIO_ON_TIME = 800; //ms, answer of AT+CFUN=1 when radio is off
+constexpr static auto SIM_MODEM_SEND_TIME = 2000; //ms, network confirmation of sent SMS
+constexpr static auto SIM_MODEM_PART_SEPTETS = 153; // text of one part of concatenated SMS
+
+/**
+ * @brief Stream which answers AT commands like a SIMCom modem in text mode.
+ * 
+ * Received SMS are stored in a small SIM storage and announced by +CMTI.
+ * Answers are available for reading immediately after the command line is written,
+ * except switching the radio on. Modem starts configured, powerOn() models a cold start.
+ * modelLink() adds transfer time of answers and AT+IPR. Bytes are lost while rates
+ * of the host and the modem differ or the host receives faster than its limit.
+ * AT+CMGS answers the prompt, text ended by Ctrl+Z is confirmed after SIM_MODEM_SEND_TIME.
+ * setEcho() or ATE1 lets the modem echo command lines and the text of SMS like a SIMCom
+ * modem after power on.
+ * Long SMS is delivered in parts with user data header, shown in hex like in text mode
+ * of a real modem, AT+CSDH=1 adds first octet, coding and length to the header of AT+CMGR.
+ */
+class SimModem : public Stream {
+    public:
+        bool deliverSms(const char* sender, const char* body);
+        uint8_t deliverConcatSms(const char* sender, const char* body, uint8_t ref, uint8_t skipPart = 0);
+        uint8_t getStoredSms();
+        uint32_t getCommandCount();
+        void powerOn(unsigned long bootTime);
+        void modelLink(long baud, long maxBaud = 115200);
+        void setHostBaud(long baud);
+        void setReceiveLimit(long baud);
+        long getBaud();
+        void failSends(uint8_t count);
+        void setFirstIndex(uint16_t firstIndex);
+        void setEcho(bool echo);
+        uint32_t getSentSms();
+        const char* getLastRecipient();
+        const char* getLastSentText();
+
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t write(uint8_t c) override;
+        using Print::write;
+
+    private:
+        struct Sms {
+            bool used;
+            char sender[20];
+            char body[SIM_MODEM_SMS_LENGTH];
+            uint8_t firstOctet;
+            uint8_t length; // characters or septets of the part
+        };
+
+        void processLine();
+        void finishSending();
+        void reply(const char* str);
+        bool store(const char* sender, const char* body, uint8_t firstOctet, uint8_t length);
+        uint16_t parseIndex(const char* str);
+        Sms* findSlot(uint16_t index);
+
+        Sms _storage[SIM_MODEM_SLOTS] = {};
+        char _line[SIM_MODEM_SMS_LENGTH];
+        uint16_t _lineLen = 0;
+        char _out[SIM_MODEM_OUTPUT];
+        uint16_t _outHead = 0;
+        uint16_t _outTail = 0;
+        uint32_t _commands = 0;
+        unsigned long _readyTime = 0; // commands are ignored and output is held until this time
+        bool _hold = false;
+        uint8_t _cfun = 1;
+        uint8_t _cmgf = 1;
+        bool _csdh = false; // header values are shown by AT+CMGR
+        bool _linkModel = false;
+        long _baud = 9600;
+        long _maxBaud = 115200;
+        long _hostBaud = 9600;
+        long _receiveLimit = 0;
+        bool _prompt = false; // text of SMS is being received
+        bool _echo = false; // received bytes are sent back
+        uint8_t _failSends = 0;
+        uint16_t _firstIndex = 1; // index of the first slot in +CMTI, AT+CMGR and AT+CMGD
+        uint32_t _sentSms = 0;
+        char _sendAnswer[32] = {};
+        unsigned long _sendDoneTime = 0; // answer of sent SMS is given at this time
+        bool _sendPending = false;
+        bool _sendConfirms = false; // answer of sent SMS is +CMGS
+        char _recipient[20] = {};
+        char _sentText[SIM_MODEM_SMS_LENGTH] = {};
+        unsigned long _txDoneTime = 0; // answer is being transferred until this time
+};
+
+/**
+ * @brief Build message in Adeon format (short hash, colon, gap and payload).
+ * @param pOut is pointer to output buffer.
+ * @param outLen is size of output buffer.
+ * @param pPayload is pointer to "name = value;" list.
+ */
+void makeAdeonMsg(char* pOut, size_t outLen, const char* pPayload);
+
+#endif // ADEON_SIM_MODEM_H
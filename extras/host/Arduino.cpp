@@ -0,0 +1,173 @@
+/**
+ *  @file       Arduino.cpp
+ *  Project     AdeonGSM
+ *  @brief      Minimal Arduino API for building Adeon on a host computer
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include <sched.h>
+
+HostSerial Serial;
+
+static bool virtualClock = false;
+static unsigned long long virtualMicros = 0;
+
+static unsigned long long realMicros(){
+    static struct timespec start = {0, 0};
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(start.tv_sec == 0 && start.tv_nsec == 0){
+        start = now;
+    }
+    return (unsigned long long)(now.tv_sec - start.tv_sec) * 1000000ULL
+           + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+unsigned long millis(){
+    return (unsigned long)(micros() / 1000);
+}
+
+unsigned long micros(){
+    return (unsigned long)(virtualClock ? virtualMicros : realMicros());
+}
+
+void delay(unsigned long ms){
+    if(virtualClock){
+        virtualMicros += (unsigned long long)ms * 1000;
+        return;
+    }
+    struct timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, nullptr);
+}
+
+void yield(){
+    //like yield() of ESP32 core, another thread can run
+    sched_yield();
+}
+
+void HostClock::useVirtual(bool enable){
+    virtualClock = enable;
+}
+
+bool HostClock::isVirtual(){
+    return virtualClock;
+}
+
+void HostClock::advance(unsigned long ms){
+    virtualMicros += (unsigned long long)ms * 1000;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size){
+    size_t n = 0;
+    while(n < size && write(buffer[n])){
+        n++;
+    }
+    return n;
+}
+
+size_t Print::write(const char* str){
+    return (str == nullptr) ? 0 : write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::print(const __FlashStringHelper* str){
+    return write(reinterpret_cast<const char*>(str));
+}
+
+size_t Print::print(const char* str){
+    return write(str);
+}
+
+size_t Print::print(char c){
+    return write((uint8_t)c);
+}
+
+size_t Print::print(long num, int base){
+    char buf[24];
+    if(base == 10){
+        snprintf(buf, sizeof(buf), "%ld", num);
+        return write(buf);
+    }
+    return print((unsigned long)num, base);
+}
+
+size_t Print::print(unsigned long num, int base){
+    char buf[24];
+    snprintf(buf, sizeof(buf), (base == 16) ? "%lX" : (base == 8) ? "%lo" : "%lu", num);
+    return write(buf);
+}
+
+size_t Print::print(int num, int base){
+    return print((long)num, base);
+}
+
+size_t Print::print(unsigned int num, int base){
+    return print((unsigned long)num, base);
+}
+
+size_t Print::print(unsigned char num, int base){
+    return print((unsigned long)num, base);
+}
+
+size_t Print::print(double num, int digits){
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%.*f", digits, num);
+    return write(buf);
+}
+
+size_t Print::println(){
+    return write("\r\n");
+}
+
+int Stream::timedRead(){
+    unsigned long start = millis();
+    do{
+        int c = read();
+        if(c >= 0){
+            return c;
+        }
+        yield();
+    }while(!virtualClock && millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length){
+    size_t count = 0;
+    while(count < length){
+        int c = timedRead();
+        if(c < 0){
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+size_t HostSerial::write(uint8_t c){
+    if(!_muted){
+        fputc(c, stdout);
+    }
+    return 1;
+}
+
+void HostSerial::flush(){
+    fflush(stdout);
+}
@@ -0,0 +1,118 @@
+/**
+ *  @file       Arduino.h
+ *  Project     AdeonGSM
+ *  @brief      Minimal Arduino API for building Adeon on a host computer
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_HOST_ARDUINO_H
+#define ADEON_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h> // WCharacter.h of Arduino core
+
+#define ADEON_HOST_BUILD 1
+
+class __FlashStringHelper;
+#define F(str) (reinterpret_cast<const __FlashStringHelper*>(str))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+/**
+ * @brief Host clock control.
+ * 
+ * Real clock is used by default. Virtual clock only moves by delay() and
+ * advance(), so benchmarks can run hours of driver time in seconds.
+ */
+namespace HostClock {
+    void useVirtual(bool enable);
+    bool isVirtual();
+    void advance(unsigned long ms);
+}
+
+class Print {
+    public:
+        virtual ~Print(){}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* str);
+        virtual int availableForWrite(){ return 0; }
+        virtual void flush(){}
+
+        size_t print(const __FlashStringHelper* str);
+        size_t print(const char* str);
+        size_t print(char c);
+        size_t print(long num, int base = 10);
+        size_t print(unsigned long num, int base = 10);
+        size_t print(int num, int base = 10);
+        size_t print(unsigned int num, int base = 10);
+        size_t print(unsigned char num, int base = 10);
+        size_t print(double num, int digits = 2);
+
+        size_t println();
+        template<typename T> size_t println(T val){ return print(val) + println(); }
+        template<typename T> size_t println(T val, int format){ return print(val, format) + println(); }
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        void setTimeout(unsigned long timeout){ _timeout = timeout; }
+        size_t readBytes(char* buffer, size_t length);
+
+    protected:
+        int timedRead();
+        unsigned long _timeout = 1000;
+};
+
+/**
+ * @brief Serial console mapped to standard output (no input).
+ */
+class HostSerial : public Stream {
+    public:
+        void begin(unsigned long baud){ (void)baud; }
+        void end(){}
+        int available() override { return 0; }
+        int read() override { return -1; }
+        int peek() override { return -1; }
+        size_t write(uint8_t c) override;
+        using Print::write;
+        int availableForWrite() override { return 63; } // standard output does not block
+        void flush() override;
+        void mute(bool muted){ _muted = muted; }
+        operator bool(){ return true; }
+
+    private:
+        bool _muted = false;
+};
+
+extern HostSerial Serial;
+
+#endif // ADEON_HOST_ARDUINO_H
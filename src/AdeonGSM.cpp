@@ -22,27 +22,121 @@
 
 #include <AdeonGSM.h>
 
+#ifdef ADEON_CONCURRENT
+    #define ADEON_WRITE_SECTION() WriteSection section(this)
+    #define ADEON_LOCK_SECTION() std::lock_guard<std::recursive_mutex> section(_sync.lock)
+#else
+    #define ADEON_WRITE_SECTION()
+    #define ADEON_LOCK_SECTION()
+#endif
+
+/**
+ * @brief Count outcome of a command from message in metrics.
+ * @param result is outcome of the command.
+ */
+static void countResult(AuditResult result){
+    if(result == AuditResult::APPLIED){
+        AdeonMetrics::add(Metric::PARAMS_APPLIED);
+    }
+    else if(result == AuditResult::DENIED){
+        AdeonMetrics::add(Metric::UNAUTHORIZED);
+    }
+}
+
+/**
+ * @brief Constructor for the class AdeonBase.
+ * @param pMsg is pointer to message buffer of msgLength + 1 bytes.
+ * @param msgLength is maximum length of processed message.
+ * @param pNameBuf is pointer to name buffer of 2 * itemLength bytes.
+ * @param itemLength is size of phone number and parameter name including terminating null character.
+ * @param pHashBuf is pointer to hash buffer of 2 * (hashLength + 1) bytes.
+ * @param hashLength is length of the short hash.
+ * @param capacity is maximum number of users and parameters.
+ * @param pReplyBuf is pointer to reply buffer of replyLength + 1 bytes.
+ * @param replyLength is maximum length of answer to queries.
+ * 
+ * Buffers are owned by BasicAdeon.
+ */
+AdeonBase::AdeonBase(char* pMsg, uint16_t msgLength, char* pNameBuf, uint8_t itemLength,
+                     char* pHashBuf, uint8_t hashLength, uint8_t capacity, char* pReplyBuf, uint8_t replyLength)
+    : parser(pMsg, pNameBuf, itemLength, pHashBuf, hashLength, &_memory),
+      userList(&_memory, itemLength, capacity),
+      paramList(&_memory, itemLength, capacity),
+      _reply(pReplyBuf, replyLength){
+    _msg = pMsg;
+    _msgLength = msgLength;
+}
+
+#ifdef ADEON_CONCURRENT
+/**
+ * @brief Start of change of Adeon data.
+ * @param pAdeon is pointer to Adeon which is changed.
+ * 
+ * Writers are serialised by lock. Outermost section makes the sequence counter odd,
+ * so lock-free readers retry until the change is finished.
+ */
+AdeonBase::WriteSection::WriteSection(AdeonBase* pAdeon){
+    _pAdeon = pAdeon;
+    _pAdeon->_sync.lock.lock();
+    if(_pAdeon->_sync.writeDepth++ == 0){
+        _pAdeon->_sync.writer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        _pAdeon->_sync.seq.store(_pAdeon->_sync.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+}
+
+/**
+ * @brief End of change of Adeon data, sequence counter is even again.
+ */
+AdeonBase::WriteSection::~WriteSection(){
+    if(--_pAdeon->_sync.writeDepth == 0){
+        _pAdeon->_sync.seq.store(_pAdeon->_sync.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        _pAdeon->_sync.writer.store(std::thread::id(), std::memory_order_relaxed);
+    }
+    _pAdeon->_sync.lock.unlock();
+}
+
+/**
+ * @brief Wait until lock-free readers leave, so an item can be released.
+ * 
+ * Called in write section. Readers which come later see odd sequence counter
+ * and do not read through their handles.
+ */
+void AdeonBase::waitForReaders(){
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while(_sync.readers.load(std::memory_order_relaxed) != 0){
+        yield();
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+#endif
+
 /**
  * @brief Add user into Adeon.
  * @param phoneNum is pointer to telephone number constant string.
  * @param userGroup is variable which defines user rights.
+ * 
+ * User is member of ADEON_GROUP_DEFAULT, see setUserGroups().
  */
-void Adeon::addUser(const char* phoneNum, uint16_t userGroup){
-    userList.addItem(phoneNum, userGroup);
+void AdeonBase::addUser(const char* phoneNum, uint16_t userGroup){
+    ADEON_WRITE_SECTION();
+    userList.setItemGroups(userList.addItem(phoneNum, userGroup), ADEON_GROUP_DEFAULT);
 }
 
 /**
  * @brief Delete user from Adeon.
  * @param phoneNum is pointer to telephone number constant string.
  */
-void Adeon::deleteUser(const char* phoneNum){
+void AdeonBase::deleteUser(const char* phoneNum){
+    ADEON_WRITE_SECTION();
     userList.deleteItem(userList.findItem(phoneNum));
 }
 
 /**
  * @brief Delete whole Adeon list.
  */
-void Adeon::deleteList(){
+void AdeonBase::deleteList(){
+    ADEON_WRITE_SECTION();
     userList.deleteHead();
 }
 
@@ -51,7 +145,8 @@ void Adeon::deleteList(){
  * @param actualPhoneNum is a pointer to actual telephone number constant string.
  * @param newPhoneNum is pointer to new telephone number constant string.
  */
-char* Adeon::editUserPhone(const char* actualPhoneNum, const char* newPhoneNum){
+char* AdeonBase::editUserPhone(const char* actualPhoneNum, const char* newPhoneNum){
+    ADEON_WRITE_SECTION();
     return userList.editItemId(userList.findItem(actualPhoneNum), newPhoneNum);
 }
 
@@ -60,7 +155,8 @@ char* Adeon::editUserPhone(const char* actualPhoneNum, const char* newPhoneNum){
  * @param phoneNum is pointer to telephone number constant string.
  * @param userGroup is variable which defines user rights.
  */
-void Adeon::editUserRights(const char* phoneNum, uint16_t userGroup){
+void AdeonBase::editUserRights(const char* phoneNum, uint16_t userGroup){
+    ADEON_WRITE_SECTION();
     userList.editItemVal(userList.findItem(phoneNum), userGroup);
 }
 
@@ -69,7 +165,8 @@ void Adeon::editUserRights(const char* phoneNum, uint16_t userGroup){
  * @param phoneNum is pointer to telephone number constant string.
  * @return userList->isInList(userList->findItem(phoneNum)) <code>true</code> if user is in the list, <code>false</code> otherwise.
  */
-bool Adeon::isUserInAdeon(const char* phoneNum){
+bool AdeonBase::isUserInAdeon(const char* phoneNum){
+    ADEON_LOCK_SECTION();
     return userList.isInList(userList.findItem(phoneNum));
 }
 
@@ -77,7 +174,7 @@ bool Adeon::isUserInAdeon(const char* phoneNum){
  * @brief Get number of users in a list.
  * @return userList->getNumOfItems() - return value is number of users in the list.
  */
-uint8_t Adeon::getNumOfUsers(){
+uint8_t AdeonBase::getNumOfUsers(){
     return userList.getNumOfItems();
 }
 
@@ -86,17 +183,42 @@ uint8_t Adeon::getNumOfUsers(){
  * @param phoneNum is pointer to telephone number constant string.
  * @return userList->getItemVal(userList->findItem(phoneNum)) - return value is user rights value.
  */
-uint16_t Adeon::getUserRightsLevel(const char* phoneNum){
+uint16_t AdeonBase::getUserRightsLevel(const char* phoneNum){
+    ADEON_LOCK_SECTION();
     return userList.getItemVal(userList.findItem(phoneNum));
 }
 
+/**
+ * @brief Set groups of user.
+ * @param phoneNum is pointer to telephone number constant string.
+ * @param groups is bit mask of groups the user is member of.
+ * 
+ * Sender can access parameter only if they share a group, see setParamGroups().
+ * Admin can set groups also by message "@phone = groups;".
+ */
+void AdeonBase::setUserGroups(const char* phoneNum, uint16_t groups){
+    ADEON_WRITE_SECTION();
+    userList.setItemGroups(userList.findItem(phoneNum), groups);
+}
+
+/**
+ * @brief Get groups of user.
+ * @param phoneNum is pointer to telephone number constant string.
+ * @return Bit mask of groups, 0 if user is not in Adeon.
+ */
+uint16_t AdeonBase::getUserGroups(const char* phoneNum){
+    ADEON_LOCK_SECTION();
+    return userList.getItemGroups(userList.findItem(phoneNum));
+}
+
 /**
  * @brief Print content of the user list.
  * 
  * It calls method of ItemList class.
  * To carry out this metod is necessary to initialize serial terminal in setup (Serial.begin).
  */
-void Adeon::printUsers(){
+void AdeonBase::printUsers(){
+    ADEON_LOCK_SECTION();
     userList.printData();
 }
 
@@ -105,7 +227,8 @@ void Adeon::printUsers(){
  * @param pName is pointer to name constant string.
  * @param val is variable which defines value of parameter.
  */
-void Adeon::addParam(const char* pName, uint16_t val){
+void AdeonBase::addParam(const char* pName, uint16_t val){
+    ADEON_WRITE_SECTION();
     paramList.addItem(pName, val);
 }
 
@@ -115,7 +238,8 @@ void Adeon::addParam(const char* pName, uint16_t val){
  * @param val is variable which defines value of parameter.
  * @param *callback is function callback which is triggered after changing 
  */
-void Adeon::addParamWithCallback(void (*callback)(uint16_t), const char* pName, uint16_t val){
+void AdeonBase::addParamWithCallback(void (*callback)(uint16_t), const char* pName, uint16_t val){
+    ADEON_WRITE_SECTION();
     paramList.addItemWithCallback(pName, val, callback);
 }
 
@@ -125,16 +249,46 @@ void Adeon::addParamWithCallback(void (*callback)(uint16_t), const char* pName,
  * @param access is variable which defines user access level to parameter.
 Default access rights for parameter is level ADMIN
  */
-void Adeon::setParamAccess(const char* pName, uint8_t access){
+void AdeonBase::setParamAccess(const char* pName, uint8_t access){
+    ADEON_WRITE_SECTION();
     paramList.setParamAccess(paramList.findItem(pName), access);
 }
 
+/**
+ * @brief Set groups which can access parameter.
+ * @param pName is pointer to name constant string.
+ * @param groups is bit mask of groups, ADEON_GROUP_ALL by default.
+ * 
+ * Access rights level is checked as well. Admin can set groups also by message "&name = groups;".
+ */
+void AdeonBase::setParamGroups(const char* pName, uint16_t groups){
+    ADEON_WRITE_SECTION();
+    paramList.setItemGroups(paramList.findItem(pName), groups);
+}
+
+/**
+ * @brief Get groups which can access parameter.
+ * @param pName is pointer to name constant string.
+ * @return Bit mask of groups, 0 if parameter is not in Adeon.
+ */
+uint16_t AdeonBase::getParamGroups(const char* pName){
+    ADEON_LOCK_SECTION();
+    return paramList.getItemGroups(paramList.findItem(pName));
+}
+
 /**
  * @brief Delete parameter from Adeon.
  * @param pName is pointer to name constant string.
  */
-void Adeon::deleteParam(const char* pName){
-    paramList.deleteItem(paramList.findItem(pName));
+void AdeonBase::deleteParam(const char* pName){
+    ADEON_WRITE_SECTION();
+    auto pItem = paramList.findItem(pName);
+    #ifdef ADEON_CONCURRENT
+    if(pItem != nullptr){
+        waitForReaders();
+    }
+    #endif
+    paramList.deleteItem(pItem);
 }
 
 /**
@@ -142,7 +296,8 @@ void Adeon::deleteParam(const char* pName){
  * @param pActualName is pointer to actual name constant string. 
  * @param pNewName is pointer to new name constant string.
  */
-char* Adeon::editParamName(const char* pActualName, const char* pNewName){
+char* AdeonBase::editParamName(const char* pActualName, const char* pNewName){
+    ADEON_WRITE_SECTION();
     return paramList.editItemId(paramList.findItem(pActualName), pNewName);
 }
 
@@ -151,7 +306,8 @@ char* Adeon::editParamName(const char* pActualName, const char* pNewName){
  * @param pName is pointer to name constant string.
  * @param val is variable which defines new value of parameter.
  */
-void Adeon::editParamValue(const char* pName, uint16_t val){
+void AdeonBase::editParamValue(const char* pName, uint16_t val){
+    ADEON_WRITE_SECTION();
     paramList.editItemVal(paramList.findItem(pName), val);
 }
 
@@ -160,7 +316,8 @@ void Adeon::editParamValue(const char* pName, uint16_t val){
  * @param pName is pointer to name constant string.
  * @return paramList->isInList(paramList->findItem(pName)) <code>true</code> if parameter is in the list, <code>false</code> otherwise.
  */
-bool Adeon::isParamInAdeon(const char* pName){
+bool AdeonBase::isParamInAdeon(const char* pName){
+    ADEON_LOCK_SECTION();
     return paramList.isInList(paramList.findItem(pName));
 }
 
@@ -168,7 +325,7 @@ bool Adeon::isParamInAdeon(const char* pName){
  * @brief Get number of parameters in a list.
  * @return userList->getNumOfItems() - return value is number of parameters in the list.
  */
-uint8_t Adeon::getNumOfParams(){
+uint8_t AdeonBase::getNumOfParams(){
     return paramList.getNumOfItems();
 }
 
@@ -177,7 +334,8 @@ uint8_t Adeon::getNumOfParams(){
  * @param pName is pointer to name constant string.
  * @return paramList->getItemVal(paramList->findItem(pName)); - return value is parameter value.
  */
-uint16_t Adeon::getParamValue(const char* pName){
+uint16_t AdeonBase::getParamValue(const char* pName){
+    ADEON_LOCK_SECTION();
     return paramList.getItemVal(paramList.findItem(pName));
 }
 
@@ -187,66 +345,518 @@ uint16_t Adeon::getParamValue(const char* pName){
  * It calls method of ItemList class.
  * To carry out this metod is necessary to initialize serial terminal in setup (Serial.begin).
  */
-void Adeon::printParams(){
+void AdeonBase::printParams(){
+    ADEON_LOCK_SECTION();
     paramList.printData();
 }
 
+/**
+ * @brief Resolve parameter name to a handle.
+ * @param pName is pointer to name constant string.
+ * @return Handle for fast access to the parameter (unbound if parameter is not in Adeon).
+ * 
+ * Handle stays valid when parameter is renamed by editParamName and becomes
+ * stale after deleteParam.
+ */
+AdeonBase::ParamHandle AdeonBase::handle(const char* pName){
+    ADEON_LOCK_SECTION();
+    return paramList.makeHandle(paramList.findItem(pName));
+}
+
+/**
+ * @brief Check if handle references a parameter in Adeon.
+ * @param handle is reference to handle obtained by handle().
+ * @return <code>true</code> if parameter is in Adeon, <code>false</code> if handle is stale or unbound.
+ */
+bool AdeonBase::isHandleValid(ParamHandle& handle){
+    ADEON_LOCK_SECTION();
+    return paramList.getItem(handle) != nullptr;
+}
+
+/**
+ * @brief Get parameter value.
+ * @param handle is reference to handle obtained by handle().
+ * @return Parameter value (0 if handle is stale).
+ */
+uint16_t AdeonBase::getParamValue(ParamHandle& handle){
+    uint16_t val;
+    readParams(&handle, &val, 1);
+    return val;
+}
+
+/**
+ * @brief Read values of more parameters at once.
+ * @param pHandles is pointer to array of handles obtained by handle().
+ * @param pValues is pointer to array where values are saved (0 for stale handle).
+ * @param count is number of handles.
+ * @return <code>true</code> if all handles are valid, <code>false</code> otherwise.
+ * 
+ * With ADEON_CONCURRENT values are read without lock, consistently with a sequence counter
+ * of writers: all values come from between two messages, a message is never seen half applied.
+ * Handle is searched in the list under lock only after a parameter has been deleted.
+ */
+bool AdeonBase::readParams(ParamHandle* pHandles, uint16_t* pValues, uint8_t count){
+    #ifdef ADEON_CONCURRENT
+    if(_sync.writer.load(std::memory_order_relaxed) != std::this_thread::get_id()){
+        bool resolved = true;
+        while(true){
+            //writer which deletes a parameter waits until the reader leaves
+            _sync.readers.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t seq = _sync.seq.load(std::memory_order_seq_cst);
+            if(seq & 1){
+                _sync.readers.fetch_sub(1, std::memory_order_release);
+                yield();
+                continue;
+            }
+            bool stale = false;
+            for(uint8_t i = 0; i < count && !stale; i++){
+                stale = !paramList.peekItemVal(pHandles[i], &pValues[i]);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            bool changed = _sync.seq.load(std::memory_order_relaxed) != seq;
+            _sync.readers.fetch_sub(1, std::memory_order_release);
+            if(changed){
+                continue;
+            }
+            if(!stale){
+                break;
+            }
+            //a parameter has been deleted, handles are checked against the list
+            std::lock_guard<std::recursive_mutex> section(_sync.lock);
+            for(uint8_t i = 0; i < count; i++){
+                resolved &= paramList.getItem(pHandles[i]) != nullptr;
+            }
+        }
+        for(uint8_t i = 0; i < count; i++){
+            resolved &= pHandles[i].isBound();
+        }
+        return resolved;
+    }
+    #endif
+    //reader is the writer (e.g. callback) or there is no concurrency
+    bool valid = true;
+    for(uint8_t i = 0; i < count; i++){
+        pValues[i] = paramList.getItemVal(paramList.getItem(pHandles[i]));
+        valid &= pHandles[i].isBound();
+    }
+    return valid;
+}
+
+/**
+ * @brief Edit parameter value.
+ * @param handle is reference to handle obtained by handle().
+ * @param val is variable which defines new value of parameter.
+ * 
+ * Nothing happens if handle is stale.
+ */
+void AdeonBase::editParamValue(ParamHandle& handle, uint16_t val){
+    ADEON_WRITE_SECTION();
+    paramList.editItemVal(paramList.getItem(handle), val);
+}
+
+/**
+ * @brief Set parameter access rights.
+ * @param handle is reference to handle obtained by handle().
+ * @param access is variable which defines user access level to parameter.
+ * 
+ * Nothing happens if handle is stale.
+ */
+void AdeonBase::setParamAccess(ParamHandle& handle, uint8_t access){
+    ADEON_WRITE_SECTION();
+    paramList.setParamAccess(paramList.getItem(handle), access);
+}
+
+/**
+ * @brief Set groups which can access parameter.
+ * @param handle is reference to handle obtained by handle().
+ * @param groups is bit mask of groups.
+ * 
+ * Nothing happens if handle is stale.
+ */
+void AdeonBase::setParamGroups(ParamHandle& handle, uint16_t groups){
+    ADEON_WRITE_SECTION();
+    paramList.setItemGroups(paramList.getItem(handle), groups);
+}
+
+/**
+ * @brief Call function for every parameter changed since last clearChanged().
+ * @param fn is pointer to function which gets name, value and version of the parameter.
+ * 
+ * Cost depends on number of changed parameters only. Function may edit parameter
+ * values, but it must not delete parameters.
+ */
+void AdeonBase::forEachChanged(void (*fn)(const char* pName, uint16_t val, uint16_t version)){
+    ADEON_LOCK_SECTION();
+    paramList.forEachChanged(fn);
+}
+
+/**
+ * @brief Forget all parameter changes, e.g. at the end of the main loop tick.
+ */
+void AdeonBase::clearChanged(){
+    ADEON_WRITE_SECTION();
+    paramList.clearChanged();
+}
+
+/**
+ * @brief Check if parameter has been changed since last clearChanged().
+ * @param handle is reference to handle obtained by handle().
+ * @return <code>true</code> if parameter is changed, <code>false</code> otherwise.
+ */
+bool AdeonBase::isParamChanged(ParamHandle& handle){
+    ADEON_LOCK_SECTION();
+    return paramList.isChanged(paramList.getItem(handle));
+}
+
+/**
+ * @brief Get parameter version.
+ * @param pName is pointer to name constant string.
+ * @return Number of value edits since the parameter has been added (wraps around).
+ */
+uint16_t AdeonBase::getParamVersion(const char* pName){
+    ADEON_LOCK_SECTION();
+    return paramList.getItemVersion(paramList.findItem(pName));
+}
+
+/**
+ * @brief Get parameter version.
+ * @param handle is reference to handle obtained by handle().
+ * @return Number of value edits since the parameter has been added (wraps around).
+ */
+uint16_t AdeonBase::getParamVersion(ParamHandle& handle){
+    ADEON_LOCK_SECTION();
+    return paramList.getItemVersion(paramList.getItem(handle));
+}
+
 /**
  * @brief Call parsing process of a message.
  * @param pMsg is pointer to incoming message.
+ * @param pPhoneNum is pointer to phone number of sender, it is used by duplicate filter
+ * and to resolve groups of the sender once per message (can be null).
  * 
  * 1. Check if message length is valid and if parser is ready.
  * 2. Set Adeon state to <code>false</code> and copy message into internal Adeon buffer.
- * 3. Check if message is valid (validity of hash and symbols order).
+ * 3. Check if message is valid (validity of hash and symbols order) and not duplicate.
  * 4. Parse parameter names and values until all received data has been processed.
+ *    Query "name?;" adds value of the parameter to reply, "status?" all parameters the sender can write.
+ *    Packed message "#1...;" (see PackedWriter) edits parameters by index instead of name.
+ *    "name = value for seconds;" sets the value and the previous one comes back after the time,
+ *    "name = value in seconds;" sets the value after the time, both need setTimerWheel() and tick().
+ *    Parameter is accessible if level of the sender is sufficient and it shares a group with the sender.
+ *    Admin can set groups by "@phone = groups;" and "&name = groups;".
+ *    Edits and invalid messages are recorded in audit log, see setAuditLog().
+ *    Outcomes are counted in AdeonMetrics, see dumpMetrics().
  * 5. Set Adeon state to <code>true</code>.
  */
-void Adeon::parseBuf(const char* pMsg, uint8_t userGroup){
+void AdeonBase::parseBuf(const char* pMsg, uint8_t userGroup, const char* pPhoneNum){
+    parseMsg(pMsg, nullptr, userGroup, pPhoneNum);
+}
+
+/**
+ * @brief Call parsing process of a message reassembled from concatenated SMS.
+ * @param concat is assembler whose last add() completed a message.
+ * @param pPhoneNum is pointer to phone number of sender, it is used by duplicate filter (can be null).
+ * 
+ * Hash is checked against MD5 computed by the assembler while parts were coming,
+ * so the long message is not hashed again. Otherwise the same as parseBuf(pMsg, ...).
+ */
+void AdeonBase::parseBuf(ConcatBase& concat, uint8_t userGroup, const char* pPhoneNum){
+    parseMsg(concat.getMsg(), concat.getDigest(), userGroup, pPhoneNum);
+}
+
+/**
+ * @brief Get answer to queries of the last message, e.g. to send it by GSM::sendSms().
+ * @return Pointer to "name=value;" list of at most ADEON_REPLY_LENGTH characters,
+ * null if the message has no query.
+ * 
+ * Parameters which are unknown or not accessible to the sender are answered "name=?;".
+ * Answer which does not fit ends with "...". Pointer is valid until the next parseBuf().
+ */
+const char* AdeonBase::getReply(){
+    return _reply.get();
+}
+
+/**
+ * @brief Set filter of repeated messages.
+ * @param pDuplicateFilter is pointer to duplicate filter (null disables filtering).
+ * 
+ * Message already accepted from the same sender within window of the filter
+ * is rejected before hash calculation, so callbacks are not fired again.
+ */
+void AdeonBase::setDuplicateFilter(DuplicateFilterBase* pDuplicateFilter){
+    parser.setDuplicateFilter(pDuplicateFilter);
+}
+
+/**
+ * @brief Set timer wheel of scheduled edits.
+ * @param pTimerWheel is pointer to timer wheel (null disables scheduling).
+ * 
+ * Without timer wheel, message edits "name = value for seconds;" and "name = value in seconds;" are ignored.
+ */
+void AdeonBase::setTimerWheel(TimerWheelBase* pTimerWheel){
+    ADEON_WRITE_SECTION();
+    _pTimerWheel = pTimerWheel;
+}
+
+/**
+ * @brief Schedule edit of parameter value.
+ * @param pName is pointer to name constant string.
+ * @param val is value which is set when the delay elapses.
+ * @param delayMs is delay in ms, it is rounded up to resolution of the timer wheel.
+ * @return <code>true</code> if edit is scheduled, <code>false</code> if parameter is not in Adeon,
+ * no timer wheel is set or all its timers are pending.
+ * 
+ * Edit already pending for the parameter is replaced. Edit is made by tick().
+ */
+bool AdeonBase::scheduleParamValue(const char* pName, uint16_t val, unsigned long delayMs){
+    ADEON_WRITE_SECTION();
+    auto pItem = paramList.findItem(pName);
+    if(pItem == nullptr || _pTimerWheel == nullptr){
+        return false;
+    }
+    ParamHandle handle = paramList.makeHandle(pItem);
+    return _pTimerWheel->schedule(handle, val, delayMs);
+}
+
+/**
+ * @brief Schedule edit of parameter value.
+ * @param handle is reference to handle obtained by handle().
+ * @param val is value which is set when the delay elapses.
+ * @param delayMs is delay in ms, it is rounded up to resolution of the timer wheel.
+ * @return <code>true</code> if edit is scheduled, <code>false</code> if handle is stale,
+ * no timer wheel is set or all its timers are pending.
+ */
+bool AdeonBase::scheduleParamValue(ParamHandle& handle, uint16_t val, unsigned long delayMs){
+    ADEON_WRITE_SECTION();
+    if(paramList.getItem(handle) == nullptr || _pTimerWheel == nullptr){
+        return false;
+    }
+    return _pTimerWheel->schedule(handle, val, delayMs);
+}
+
+/**
+ * @brief Make scheduled edits which are due, call it from loop().
+ * 
+ * Edits are made as any other edit, so callbacks of parameters are called.
+ * Edit of a deleted parameter is dropped. Nothing is locked while no edit is pending.
+ */
+void AdeonBase::tick(){
+    if(_pTimerWheel == nullptr || _pTimerWheel->getPending() == 0){
+        return;
+    }
+    ParamHandle handle;
+    uint16_t val;
+    ADEON_WRITE_SECTION();
+    while(_pTimerWheel->poll(&handle, &val)){
+        auto pItem = paramList.getItem(handle);
+        if(pItem != nullptr && _pAuditLog != nullptr){
+            audit(0, paramList.getItemIndex(pItem), paramList.getItemVal(pItem), val, AuditResult::TIMED);
+        }
+        if(pItem != nullptr){
+            AdeonMetrics::add(Metric::PARAMS_APPLIED);
+        }
+        paramList.editItemVal(pItem, val);
+    }
+}
+
+/**
+ * @brief Set log of commands from messages.
+ * @param pAuditLog is pointer to audit log (null disables logging).
+ * 
+ * Every edit, group edit and invalid message of parseBuf() is recorded with key of the sender,
+ * edits made by tick() with key 0. Queries are not recorded.
+ */
+void AdeonBase::setAuditLog(AuditLogBase* pAuditLog){
+    ADEON_WRITE_SECTION();
+    _pAuditLog = pAuditLog;
+}
+
+/**
+ * @brief Check if Adeon is ready for incoming message.
+ * @return _ready <code>true</code> if Adeon is ready, <code>false</code> otherwise.
+ */
+bool AdeonBase::isAdeonReady(){
+    return _ready;
+}
+
+/**
+ * @brief Get heap usage of Adeon.
+ * @return Counters of memory used by users, parameters and hash calculation.
+ * 
+ * Message and parser buffers are not included, their size is given by sizeof of the Adeon configuration.
+ */
+MemoryStats AdeonBase::memoryStats(){
+    return _memory.getStats();
+}
+
+/**
+ * @brief Get parameter access rights.
+ * @param pName is pointer to name constant string.
+ */
+uint8_t AdeonBase::getParamAccess(const char* pName){
+    ADEON_LOCK_SECTION();
+    return paramList.getParamAccess(paramList.findItem(pName));
+}
+
+/**
+ * @brief Parse message, see parseBuf().
+ * @param pMsg is pointer to incoming message (null is ignored).
+ * @param pDigest is pointer to MD5 of text after the hash, null if it is calculated here.
+ * @param userGroup is group of the sender.
+ * @param pPhoneNum is pointer to phone number of sender (can be null), it gives groups of the sender.
+ * 
+ * Sender who is not in Adeon or is not given is member of ADEON_GROUP_DEFAULT only.
+ * With ADEON_CONCURRENT messages are parsed one at a time and the hash is verified before
+ * the write section, so readers and writers wait only while the commands are applied.
+ */
+void AdeonBase::parseMsg(const char* pMsg, const unsigned char* pDigest, uint8_t userGroup, const char* pPhoneNum){
+    #ifdef ADEON_CONCURRENT
+    std::lock_guard<std::mutex> parsing(_sync.parseLock);
+    #endif
     char* tmpName;
-    if(strlen(pMsg) <= MSG_BUFFER_LENGTH && parser.isParserReady() && !paramList.isListEmpty()){
+    if(pMsg != nullptr && strlen(pMsg) <= _msgLength && parser.isParserReady() && hasParams()){
         _ready = false;
-        memset(_msg, 0, sizeof(_msg));
+        _reply.clear();
+        memset(_msg, 0, _msgLength + 1);
         strcpy(_msg, pMsg);
-        if(parser.isMsgValid()){
+        uint32_t senderKey = (_pAuditLog != nullptr) ? makeStrKey(pPhoneNum) : 0;
+        if(parser.isMsgValid(pPhoneNum, pDigest)){
+            //readers see values of the whole message at once
+            ADEON_WRITE_SECTION();
+            //groups of sender are resolved once, each parameter is then checked by AND
+            auto pSender = (pPhoneNum != nullptr) ? userList.findItem(pPhoneNum) : nullptr;
+            uint16_t groups = (pSender != nullptr) ? userList.getItemGroups(pSender) : ADEON_GROUP_DEFAULT;
+            if(parser.isPacked()){
+                paramList.applyPacked(&parser, userGroup, groups, _pTimerWheel, _pAuditLog, senderKey);
+            }
             while(parser.isNameAvailable()){
                 parser.parse();
                 tmpName = parser.getTmpName();
-                if(isParamInAdeon(tmpName) && (getParamAccess(tmpName) >= userGroup)){
-                    editParamValue(tmpName, parser.getValue());
+                if(parser.isQuery()){
+                    answerQuery(tmpName, userGroup, groups);
+                }
+                else if(tmpName[0] == userGroupsSymbol || tmpName[0] == paramGroupsSymbol){
+                    bool admin = userGroup == ADEON_ADMIN;
+                    if(admin){
+                        editGroups(tmpName, parser.getValue());
+                    }
+                    AuditResult result = admin ? AuditResult::GROUPS : AuditResult::DENIED;
+                    countResult(result);
+                    audit(senderKey, AUDIT_NO_PARAM, 0, parser.getValue(), result);
+                }
+                else{
+                    uint8_t index = AUDIT_NO_PARAM;
+                    auto pItem = paramList.findItem(tmpName, &index);
+                    uint16_t oldVal = paramList.getItemVal(pItem);
+                    AuditResult result = (pItem != nullptr) ? AuditResult::DENIED : AuditResult::UNKNOWN;
+                    if(paramList.isAccessible(pItem, userGroup, groups)){
+                        result = paramList.editTimed(pItem, parser.getValue(), parser.getTiming(),
+                                                     parser.getSeconds(), _pTimerWheel);
+                    }
+                    countResult(result);
+                    audit(senderKey, index, oldVal, parser.getValue(), result);
                 }
             }
+            _reply.finish();
         }
         else{
-            Serial.println("Message is invalid");
+            ADEON_LOG_WARN(F("Message is invalid"));
+            ADEON_LOCK_SECTION();
+            audit(senderKey, AUDIT_NO_PARAM, 0, 0, AuditResult::INVALID);
         }
         _ready = true;
     }
+    else if(pMsg != nullptr && strlen(pMsg) > _msgLength){
+        //e.g. reassembled long SMS for Adeon with default MSG_LENGTH
+        ADEON_LOG_WARN(F("Message is too long "), (long)strlen(pMsg));
+        AdeonMetrics::add(Metric::PARSE_ERRORS);
+    }
 }
 
 /**
- * @brief Check if Adeon is ready for incoming message.
- * @return _ready <code>true</code> if Adeon is ready, <code>false</code> otherwise.
+ * @brief Check if Adeon has any parameter, messages are not parsed otherwise.
  */
-bool Adeon::isAdeonReady(){
-    return _ready;
+bool AdeonBase::hasParams(){
+    ADEON_LOCK_SECTION();
+    return !paramList.isListEmpty();
 }
 
 /**
- * @brief Get parameter access rights.
- * @param pName is pointer to name constant string.
+ * @brief Add answer to one query into reply.
+ * @param pName is pointer to name of queried parameter, "status" for all parameters.
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ * 
+ * Status is rendered again only when the parameter list has changed since the last status
+ * or the sender has other rights.
  */
-uint8_t Adeon::getParamAccess(const char* pName){
-    return paramList.getParamAccess(paramList.findItem(pName));
+void AdeonBase::answerQuery(const char* pName, uint8_t userGroup, uint16_t groups){
+    if(strcmp(pName, statusQuery) == 0){
+        uint32_t revision = paramList.getRevision();
+        if(_reply.isStatusCached(userGroup, groups, revision)){
+            _reply.reuseStatus();
+            return;
+        }
+        bool cacheable = _reply.isEmpty();
+        paramList.appendReadable(&_reply, userGroup, groups);
+        if(cacheable){
+            _reply.cacheStatus(userGroup, groups, revision);
+        }
+        return;
+    }
+    auto pItem = paramList.findItem(pName);
+    bool readable = paramList.isAccessible(pItem, userGroup, groups);
+    _reply.append(pName, readable ? paramList.getItemVal(pItem) : 0, readable);
+}
+
+/**
+ * @brief Set groups of user or parameter from admin message.
+ * @param pName is pointer to "@phone" or "&name".
+ * @param groups is bit mask of groups.
+ */
+void AdeonBase::editGroups(const char* pName, uint16_t groups){
+    if(pName[0] == userGroupsSymbol){
+        userList.setItemGroups(userList.findItem(pName + 1), groups);
+    }
+    else{
+        paramList.setItemGroups(paramList.findItem(pName + 1), groups);
+    }
+}
+
+/**
+ * @brief Add record into audit log if it is set.
+ * @param senderKey is key of sender phone number.
+ * @param param is index of parameter (AUDIT_NO_PARAM if the record is not related to one).
+ * @param oldVal is value before the command.
+ * @param newVal is value requested by the command.
+ * @param result is outcome of the command.
+ */
+void AdeonBase::audit(uint32_t senderKey, uint8_t param, uint16_t oldVal, uint16_t newVal, AuditResult result){
+    if(_pAuditLog != nullptr){
+        _pAuditLog->append(senderKey, param, oldVal, newVal, result);
+    }
 }
 
 /**
  * @brief Constructor for nested class Parser.
  * @param pMsg is a pointer to string which carrying content of received message in class Adeon.
+ * @param pNameBuf is pointer to buffer for parsed name and substring (2 * itemLength bytes).
+ * @param itemLength is size of parameter name including terminating null character.
+ * @param pHashBuf is pointer to buffer for received and calculated hash (2 * (hashLength + 1) bytes).
+ * @param hashLength is length of the short hash.
+ * @param pMemory is pointer to account which counts memory of hash calculation.
  * 
  * Constructor should be called only once.
  */
-Adeon::Parser::Parser(char* pMsg){
+AdeonBase::Parser::Parser(char* pMsg, char* pNameBuf, uint8_t itemLength, char* pHashBuf, uint8_t hashLength,
+                          MemoryAccount* pMemory)
+    : _pHash(pHashBuf + hashLength + 1, hashLength, pMemory){
     _pMsg = pMsg;
+    _pTmpName = pNameBuf;
+    _subStr = pNameBuf + itemLength;
+    _itemLength = itemLength;
+    _tmpHash = pHashBuf;
+    _hashLength = hashLength;
 }
 
 /**
@@ -255,20 +865,22 @@ Adeon::Parser::Parser(char* pMsg){
  * 
  * Must be called always before isMsgValid().
  */
-bool Adeon::Parser::isParserReady(){
+bool AdeonBase::Parser::isParserReady(){
     return parsState == State::READY;
 }
 
 /**
  * @brief Check if received message is valid.
+ * @param pPhoneNum is pointer to phone number of sender (can be null).
+ * @param pDigest is pointer to MD5 of text after the hash, null if it is calculated here.
  * @return <code>true</code> if message is valid, <code>false</code> otherwise.
  * 
  * Must be called always before isNameAvailable().
  * If message is valid, state will be changed to INIT and initialization is carried out.
  * Message is validated by checking incoming hash.
  */
-bool Adeon::Parser::isMsgValid(){
-    if(isHashParsingValid()){
+bool AdeonBase::Parser::isMsgValid(const char* pPhoneNum, const unsigned char* pDigest){
+    if(isHashParsingValid(pPhoneNum, pDigest)){
         parsState = State::INIT;
         parse();
         return true;
@@ -283,7 +895,7 @@ bool Adeon::Parser::isMsgValid(){
  * Must be called always before parse().
  * If there is no available parameter, parser's state is set to READY (waiting for new message).
  */
-bool Adeon::Parser::isNameAvailable(){
+bool AdeonBase::Parser::isNameAvailable(){
     if(_processedNames < _numberOfNames){
         return true;
     }
@@ -298,17 +910,20 @@ bool Adeon::Parser::isNameAvailable(){
  * The state of parser is changed to PROCESSING.
  * Processing state parses name and value from actual parameter
  */
-void Adeon::Parser::parse(){
+void AdeonBase::Parser::parse(){
     switch(parsState){
     case State::INIT:
         _processedNames = 0;
-        _numberOfNames = getNumberOfNames();        
+        _isPacked = _packed.begin(strchr(_pMsg, _hashEndSymbol) + 2);
+        _numberOfNames = _isPacked ? 0 : getNumberOfNames();
         parsState = State::PROCESSING;
         break;
     case State::PROCESSING:
         char* tmpStr;
         tmpStr = parseName();
-        parseValue(tmpStr);
+        if(!_isQuery){
+            parseValue(tmpStr);
+        }
         _processedNames++;
         break;
         default:
@@ -320,7 +935,7 @@ void Adeon::Parser::parse(){
  * @brief Get actual parsed parameter name.
  * @return _pTmpName is pointer to name string
  */
-char* Adeon::Parser::getTmpName(){
+char* AdeonBase::Parser::getTmpName(){
     return _pTmpName;
 }
 
@@ -328,43 +943,116 @@ char* Adeon::Parser::getTmpName(){
  * @brief Get actual parsed parameter value.
  * @return _tmpValue is value variable
  */
-uint16_t Adeon::Parser::getValue(){
+uint16_t AdeonBase::Parser::getValue(){
     return _tmpValue;
 }
 
+/**
+ * @brief Get when actual parsed value takes effect.
+ * @return Timing::NOW unless the value is followed by "for" or "in" and time.
+ */
+AdeonBase::Timing AdeonBase::Parser::getTiming(){
+    return _timing;
+}
+
+/**
+ * @brief Get time of actual parsed value.
+ * @return Seconds of Timing::DURATION or Timing::DELAY, 0 otherwise.
+ */
+uint16_t AdeonBase::Parser::getSeconds(){
+    return _seconds;
+}
+
+/**
+ * @brief Check if actual parsed item is a query.
+ * @return <code>true</code> for "name?", <code>false</code> for "name = value".
+ */
+bool AdeonBase::Parser::isQuery(){
+    return _isQuery;
+}
+
+/**
+ * @brief Check if message is packed, its edits are taken by nextPacked() instead of parse().
+ * @return <code>true</code> if text after hash starts with version prefix of packed encoding.
+ */
+bool AdeonBase::Parser::isPacked(){
+    return _isPacked;
+}
+
+/**
+ * @brief Get next edit of packed message.
+ * @param pStep is pointer to distance of parameter from the previous edit (index for the first one).
+ * @param pVal is pointer to new value.
+ * @return <code>true</code> if edit is read, <code>false</code> at the end of message.
+ */
+bool AdeonBase::Parser::nextPacked(uint16_t* pStep, uint16_t* pVal){
+    return _isPacked && _packed.next(pStep, pVal);
+}
+
+/**
+ * @brief Set filter of repeated messages.
+ * @param pDuplicateFilter is pointer to duplicate filter (null disables filtering).
+ */
+void AdeonBase::Parser::setDuplicateFilter(DuplicateFilterBase* pDuplicateFilter){
+    _pDuplicateFilter = pDuplicateFilter;
+}
+
 /**
  * @brief Parse hash from message and check its validity.
+ * @param pPhoneNum is pointer to phone number of sender (can be null).
+ * @param pDigest is pointer to MD5 of text after the hash, null if it is calculated here.
  * @return <code>true</code> if hash is valid, <code>false</code> otherwise.
  * 
- * After hash parsing is called method from class Hash which carries out if hash is valid or not.
+ * After hash parsing, duplicate filter is asked if the message has been accepted recently.
+ * Then is called method from class Hash which carries out if hash is valid or not.
+ * Only message with valid hash is recorded by duplicate filter.
  */
-bool Adeon::Parser::isHashParsingValid(){
+bool AdeonBase::Parser::isHashParsingValid(const char* pPhoneNum, const unsigned char* pDigest){
     char* pEndSymbol = strchr(_pMsg, _hashEndSymbol);
     //if wrong format (no colon) return false
     if(pEndSymbol != nullptr){
         uint8_t hashLen = strlen(_pMsg) - strlen(pEndSymbol);
         
-        if(hashLen == SHORT_HASH_LENGTH){
+        if(hashLen == _hashLength){
             strncpy(_tmpHash, _pMsg, hashLen);
-            return _pHash.isHashValid(pEndSymbol + 2, _tmpHash);
+            _tmpHash[hashLen] = _nullChar;
+            if(_pDuplicateFilter != nullptr && _pDuplicateFilter->isDuplicate(pPhoneNum, _tmpHash)){
+                return false;
+            }
+            bool valid = (pDigest != nullptr) ? _pHash.isDigestValid(pDigest, _tmpHash)
+                                              : _pHash.isHashValid(pEndSymbol + 2, _tmpHash);
+            if(valid){
+                if(_pDuplicateFilter != nullptr){
+                    _pDuplicateFilter->record(pPhoneNum, _tmpHash);
+                }
+                return true;
+            }
+            AdeonMetrics::add(Metric::HASH_FAILURES);
+            return false;
         }
     }
+    AdeonMetrics::add(Metric::PARSE_ERRORS);
     return false;
 }
 
 /**
  * @brief Get number of available parameters from the message.
  * @return Number of semicolons in message (semicolons separate parameters).
+ * 
+ * Single query may come without semicolon, e.g. "status?".
  */
-uint8_t Adeon::Parser::getNumberOfNames(){
-    uint8_t msgLen = strlen(_pMsg);
+uint8_t AdeonBase::Parser::getNumberOfNames(){
+    uint16_t msgLen = strlen(_pMsg);
     uint8_t semicolonCount = 0;
 
-    for(int i = 0; i < msgLen; i++){
+    for(uint16_t i = 0; i < msgLen; i++){
         if(_pMsg[i] == _semicolon){
             semicolonCount++;
         }
     }
+    if(semicolonCount == 0 && msgLen > 0 && _pMsg[msgLen - 1] == _question){
+        return 1;
+    }
     return semicolonCount;
 }
 
@@ -374,43 +1062,120 @@ uint8_t Adeon::Parser::getNumberOfNames(){
  * 
  * If number of processed names of parameters is zero, start symbol is a gap.
  * If number of processed names od parameters is higher than zero, start symbol is a semicolon.
+ * Query is recognised here, so its name is not searched up to a gap which it does not have.
  */
-char* Adeon::Parser::parseName(){
+char* AdeonBase::Parser::parseName(){
     char* tmp;
     if(_processedNames == 0){
         tmp = positionOfStr(_pMsg, 1, _gap);
-        strcpy(_pTmpName,getCharsUntilEndSym(tmp, _gap));
     }
     else{
         tmp = positionOfStr(_pMsg, _processedNames, _semicolon);
+    }
+    if(!parseQuery(tmp)){
         strcpy(_pTmpName, getCharsUntilEndSym(tmp, _gap));
     }
     return tmp;
 }
 
+/**
+ * @brief Pars query from the message.
+ * @param pActualParam is pointer to actual parameter in the message string.
+ * @return <code>true</code> if parameter is a query, <code>false</code> if it has a value.
+ * 
+ * Query has a question mark and no equal sign before the next semicolon,
+ * its name is saved without the question mark and gaps.
+ */
+bool AdeonBase::Parser::parseQuery(char* pActualParam){
+    uint16_t length = 0;
+    _isQuery = false;
+    while(pActualParam[length] != _semicolon && pActualParam[length] != _nullChar){
+        if(pActualParam[length] == _equal){
+            return false;
+        }
+        if(pActualParam[length] == _question){
+            _isQuery = true;
+        }
+        length++;
+    }
+    if(!_isQuery){
+        return false;
+    }
+    while(*pActualParam == _gap){
+        pActualParam++;
+    }
+    uint8_t i = 0;
+    while(pActualParam[i] != _question && pActualParam[i] != _gap && i < _itemLength - 1){
+        _pTmpName[i] = pActualParam[i];
+        i++;
+    }
+    _pTmpName[i] = _nullChar;
+    return true;
+}
+
 /**
  * @brief Pars value of actual parameter from the message.
  * @param pActualParam is pointer to actual parameter in the message string.
  * 
  * After parsing it carries out conversion value data type from char to uint16_t.
  */
-void Adeon::Parser::parseValue(char* pActualParam){
+void AdeonBase::Parser::parseValue(char* pActualParam){
     char* tmp;
     tmp = positionOfStr(pActualParam, 1, _equal) + 1; //address plus one because of the gap
+    parseTiming(tmp);
     tmp = getCharsUntilEndSym(tmp, _semicolon);
     _tmpValue = (uint16_t)atoi(tmp);
 }
 
+/**
+ * @brief Pars time which follows value of actual parameter, e.g. "1 for 5" or "1 in 60".
+ * @param pValue is pointer to value in the message string.
+ * 
+ * Time is parsed from the message, so it is not limited by the size of the name buffer.
+ * Anything else after the value is ignored as before.
+ */
+void AdeonBase::Parser::parseTiming(char* pValue){
+    _timing = Timing::NOW;
+    _seconds = 0;
+    while(*pValue == _gap){
+        pValue++;
+    }
+    while(isdigit(*pValue)){
+        pValue++;
+    }
+    while(*pValue == _gap){
+        pValue++;
+    }
+    uint8_t wordLength;
+    if(strncmp(pValue, durationWord, strlen(durationWord)) == 0){
+        _timing = Timing::DURATION;
+        wordLength = strlen(durationWord);
+    }
+    else if(strncmp(pValue, delayWord, strlen(delayWord)) == 0){
+        _timing = Timing::DELAY;
+        wordLength = strlen(delayWord);
+    }
+    else{
+        return;
+    }
+    pValue += wordLength;
+    if(*pValue != _gap){
+        _timing = Timing::NOW;
+        return;
+    }
+    unsigned long seconds = strtoul(pValue, nullptr, 10);
+    _seconds = (seconds > 0xFFFF) ? 0xFFFF : (uint16_t)seconds;
+}
+
 /**
  * @brief Pars value of actual parameter from the message.
  * @param pActualParam is pointer to actual substring in the message string.
  * @param endSymbol defines end symbol for substring in the message string.
  * @return Pointer to substring.
  * 
- * Substring is dynamic created according to number of characters.
- * After using string must be deleted.
+ * Substring is truncated to the size of the name buffer.
  */
-char* Adeon::Parser::getCharsUntilEndSym(char* pActualParam, char endSymbol){
+char* AdeonBase::Parser::getCharsUntilEndSym(char* pActualParam, char endSymbol){
     int i = 0;
     char* endPointer;
     while(pActualParam[i] != endSymbol){
@@ -418,9 +1183,9 @@ char* Adeon::Parser::getCharsUntilEndSym(char* pActualParam, char endSymbol){
     }
     endPointer = &pActualParam[i];
 
-    memset(_subStr, 0, sizeof(_subStr));
+    memset(_subStr, 0, _itemLength);
     i = 0;
-    while(&pActualParam[i] != endPointer){
+    while(&pActualParam[i] != endPointer && i < _itemLength - 1){
       _subStr[i] = pActualParam[i];
       i++;
     }
@@ -435,9 +1200,9 @@ char* Adeon::Parser::getCharsUntilEndSym(char* pActualParam, char endSymbol){
  * @param stertSymbol defines start symbol for substring in the message string.
  * @return Pointer to substring.
  */
-char* Adeon::Parser::positionOfStr(char* pStr, uint8_t pos, char startSymbol){
+char* AdeonBase::Parser::positionOfStr(char* pStr, uint8_t pos, char startSymbol){
     uint8_t symCount = 0;
-    uint8_t i = 0;
+    uint16_t i = 0;
     while(symCount != pos){
         if(pStr[i] == startSymbol){
             symCount++;
@@ -449,14 +1214,17 @@ char* Adeon::Parser::positionOfStr(char* pStr, uint8_t pos, char startSymbol){
 
 /**
  * @brief Constructor for the class Hash. Constructor is allowed to call only in class Parser.
- * @param pMsg is a pointer to received message without hash.
- * @param pMsgHash is a pointer to parsed hash from the message.
+ * @param pShortHash is a pointer to buffer for calculated hash (hashLength + 1 bytes).
+ * @param hashLength is length of the short hash.
+ * @param pMemory is pointer to account which counts memory of hash calculation.
  * 
  * @see MD5.cpp 
  * @see MD5.h
  */
-Adeon::Parser::Hash::Hash(){
-
+AdeonBase::Parser::Hash::Hash(char* pShortHash, uint8_t hashLength, MemoryAccount* pMemory){
+    _shortHash = pShortHash;
+    _hashLength = hashLength;
+    _pMemory = pMemory;
 }
 
 /**
@@ -464,23 +1232,56 @@ Adeon::Parser::Hash::Hash(){
  * @param hashLen is length variable of hash from message. 
  * @return <code>true</code> if hash is matching, <code>false</code> otherwise.
  */
-bool Adeon::Parser::Hash::isHashValid(char* msg, char* hash){
-    makeHashFromStr(msg);
+bool AdeonBase::Parser::Hash::isHashValid(char* msg, char* hash){
+    if(!makeHashFromStr(msg)){
+        return false;
+    }
+    return(strcmp(_shortHash, hash) == 0);
+}
+
+/**
+ * @brief Evaluate if hash given by MD5 digest is matching with parsed hash.
+ * @param pDigest is pointer to 16 bytes of MD5, e.g. computed while concatenated SMS was coming.
+ * @param hash is pointer to hash from message.
+ * @return <code>true</code> if hash is matching, <code>false</code> otherwise.
+ */
+bool AdeonBase::Parser::Hash::isDigestValid(const unsigned char* pDigest, char* hash){
+    if(!makeHashFromDigest(pDigest)){
+        return false;
+    }
     return(strcmp(_shortHash, hash) == 0);
 }
 
 /**
  * @brief Make hash from message content.
  * @param hashLen is length variable of hash from message. 
+ * @return <code>true</code> if hash is calculated, <code>false</code> if heap is exhausted.
  * 
  * Using MD5 encryption algorithm.
  */
-void Adeon::Parser::Hash::makeHashFromStr(char* msg){
-    unsigned char* hash = MD5::make_hash(msg);
-    char* md5Str = MD5::make_digest(hash, 16);   
-    free(hash);
+bool AdeonBase::Parser::Hash::makeHashFromStr(char* msg){
+    unsigned char* hash = MD5::make_hash(msg, *_pMemory);
+    if(hash == nullptr){
+        return false;
+    }
+    bool made = makeHashFromDigest(hash);
+    _pMemory->release(hash, 16);
+    return made;
+}
+
+/**
+ * @brief Make hash from MD5 digest.
+ * @param pDigest is pointer to 16 bytes of MD5.
+ * @return <code>true</code> if hash is made, <code>false</code> if heap is exhausted.
+ */
+bool AdeonBase::Parser::Hash::makeHashFromDigest(const unsigned char* pDigest){
+    char* md5Str = MD5::make_digest(pDigest, 16, *_pMemory);
+    if(md5Str == nullptr){
+        return false;
+    }
     makeShortHash(md5Str);
-    free(md5Str);
+    _pMemory->release(md5Str, 2 * 16 + 1);
+    return true;
 }
 
 /**
@@ -488,10 +1289,163 @@ void Adeon::Parser::Hash::makeHashFromStr(char* msg){
  * @param str is pointer to hash string.
  * @param hashLen is length variable of hash from message.  
  */
-void Adeon::Parser::Hash::makeShortHash(char* str){
+void AdeonBase::Parser::Hash::makeShortHash(char* str){
     uint8_t strLength = strlen(str); 
-    memset(_shortHash, 0, sizeof(_shortHash));
-    strcpy(_shortHash, &str[strLength - SHORT_HASH_LENGTH]);
+    memset(_shortHash, 0, _hashLength + 1);
+    strcpy(_shortHash, &str[strLength - _hashLength]);
+}
+
+/**
+ * @brief Constructor for nested class Reply.
+ * @param pBuf is pointer to buffer of capacity + 1 bytes.
+ * @param capacity is maximum length of reply.
+ */
+AdeonBase::Reply::Reply(char* pBuf, uint8_t capacity){
+    _pBuf = pBuf;
+    _capacity = capacity;
+    _pBuf[0] = '\0';
+}
+
+/**
+ * @brief Start reply to a new message, cached status is kept.
+ */
+void AdeonBase::Reply::clear(){
+    _length = 0;
+    _queried = false;
+    _truncated = false;
+}
+
+/**
+ * @brief Add "name=value;" to reply.
+ * @param pName is pointer to parameter name.
+ * @param val is parameter value.
+ * @param known is <code>false</code> if value is answered by "?".
+ * @return <code>true</code> if item fits, <code>false</code> if reply is truncated.
+ * 
+ * Room for "..." is always kept, so a truncated reply can be marked.
+ */
+bool AdeonBase::Reply::append(const char* pName, uint16_t val, bool known){
+    char digits[6];
+    uint8_t numDigits = 0;
+    if(!known){
+        digits[numDigits++] = '?';
+    }
+    else{
+        do{
+            digits[numDigits++] = '0' + val % 10;
+            val /= 10;
+        } while(val != 0);
+    }
+    _queried = true;
+    size_t itemLength = strlen(pName) + numDigits + 2;
+    if(_truncated || _length + itemLength + strlen(more) > _capacity){
+        _truncated = true;
+        return false;
+    }
+    if(_length < _statusLength){
+        _statusLength = 0; //cached status is overwritten
+    }
+    strcpy(&_pBuf[_length], pName);
+    _length += strlen(pName);
+    _pBuf[_length++] = '=';
+    while(numDigits > 0){
+        _pBuf[_length++] = digits[--numDigits];
+    }
+    _pBuf[_length++] = ';';
+    return true;
+}
+
+/**
+ * @brief End reply, "..." is added if something did not fit.
+ * 
+ * Buffer of message without query is left as it is, it may hold the cached status.
+ */
+void AdeonBase::Reply::finish(){
+    if(!_queried){
+        return;
+    }
+    if(_length < _statusLength){
+        _statusLength = 0; //cached status is overwritten
+    }
+    if(_truncated && _length + strlen(more) <= _capacity){
+        strcpy(&_pBuf[_length], more);
+        _length += strlen(more);
+    }
+    _pBuf[_length] = '\0';
+}
+
+/**
+ * @brief Get reply of the last message.
+ * @return Pointer to reply string, null if there has been no query.
+ */
+const char* AdeonBase::Reply::get(){
+    return _queried ? _pBuf : nullptr;
+}
+
+/**
+ * @brief Check if status for the sender can be taken from the cache.
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ * @param revision is actual revision of the parameter list.
+ * @return <code>true</code> if status is cached and reply is empty, <code>false</code> otherwise.
+ */
+bool AdeonBase::Reply::isStatusCached(uint8_t userGroup, uint16_t groups, uint32_t revision){
+    return _length == 0 && _statusLength != 0 && _statusGroup == userGroup && _statusGroups == groups
+           && _statusRevision == revision;
+}
+
+/**
+ * @brief Use cached status as reply.
+ */
+void AdeonBase::Reply::reuseStatus(){
+    _length = _statusLength;
+    _truncated = _statusTruncated;
+    _queried = true;
+}
+
+/**
+ * @brief Remember rendered status, it is at the beginning of reply.
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ * @param revision is revision of the parameter list used for rendering.
+ */
+void AdeonBase::Reply::cacheStatus(uint8_t userGroup, uint16_t groups, uint32_t revision){
+    _statusLength = _length;
+    _statusTruncated = _truncated;
+    _statusGroup = userGroup;
+    _statusGroups = groups;
+    _statusRevision = revision;
+    _queried = true;
+}
+
+/**
+ * @brief Check if nothing has been added to reply yet.
+ */
+bool AdeonBase::Reply::isEmpty(){
+    return _length == 0;
+}
+
+/**
+ * @brief Constructor for nested class UserList.
+ * @param pMemory is pointer to account which counts memory of users.
+ * @param idLength is size of phone number including terminating null character.
+ * @param capacity is maximum number of users.
+ */
+AdeonBase::UserList::UserList(MemoryAccount* pMemory, uint8_t idLength, uint8_t capacity)
+    : ItemListBase(pMemory, idLength, capacity){
+
+}
+
+/**
+ * @brief Constructor for nested class ParameterList.
+ * @param pMemory is pointer to account which counts memory of parameters.
+ * @param idLength is size of parameter name including terminating null character.
+ * @param capacity is maximum number of parameters.
+ */
+AdeonBase::ParameterList::ParameterList(MemoryAccount* pMemory, uint8_t idLength, uint8_t capacity)
+    : ItemListBase(pMemory, idLength, capacity){
+    _trackChanges = true;
+
 }
 
 /**
@@ -502,11 +1456,11 @@ void Adeon::Parser::Hash::makeShortHash(char* str){
  * 
  * Call addItem method and saves pointer to callback function
  */
-void Adeon::ParameterList::addItemWithCallback(const char* pId, uint16_t val, void (*callback)(uint16_t)){
+void AdeonBase::ParameterList::addItemWithCallback(const char* pId, uint16_t val, void (*callback)(uint16_t)){
     Item* pItem = addItem(pId, val);
 
     if (pItem == nullptr) {
-        Serial.print("Adeon: Unable to add parameter "); Serial.println(pId);
+        ADEON_LOG_ERROR(F("Adeon: Unable to add parameter "), pId);
         return;
     }
 
@@ -518,14 +1472,126 @@ void Adeon::ParameterList::addItemWithCallback(const char* pId, uint16_t val, vo
  * @param pItem is pointer to item object.
  * @param access is variable which defines user access level to parameter.
  */
-void Adeon::ParameterList::setParamAccess(Item* pItem, uint8_t access){
-    pItem->accessRights = access;
+void AdeonBase::ParameterList::setParamAccess(Item* pItem, uint8_t access){
+    if(pItem != nullptr){
+        pItem->accessRights = access;
+        _revision++;
+    }
+}
+
+/**
+ * @brief Add all parameters which the sender can access into reply.
+ * @param pReply is pointer to reply.
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ */
+void AdeonBase::ParameterList::appendReadable(Reply* pReply, uint8_t userGroup, uint16_t groups){
+    for(Item* pItem = _pHead; pItem != nullptr; pItem = pItem->getPointToNextItem()){
+        if(isAccessible(pItem, userGroup, groups) && !pReply->append(pItem->id, pItem->value, true)){
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Apply edits of packed message.
+ * @param pParser is pointer to parser which holds the message.
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ * @param pTimerWheel is pointer to timer wheel whose edits of the parameters are replaced (can be null).
+ * @param pAuditLog is pointer to audit log (can be null).
+ * @param senderKey is key of sender phone number for the audit log.
+ * 
+ * Indices ascend, so the list is walked only once. Edits behind the last parameter are ignored.
+ */
+void AdeonBase::ParameterList::applyPacked(Parser* pParser, uint8_t userGroup, uint16_t groups,
+                                           TimerWheelBase* pTimerWheel, AuditLogBase* pAuditLog,
+                                           uint32_t senderKey){
+    Item* pItem = _pHead;
+    uint16_t index = 0;
+    uint16_t step;
+    uint16_t val;
+    while(pParser->nextPacked(&step, &val)){
+        for(uint16_t i = 0; i < step && pItem != nullptr; i++){
+            pItem = pItem->getPointToNextItem();
+            index++;
+        }
+        if(pItem == nullptr){
+            return;
+        }
+        uint16_t oldVal = pItem->value;
+        AuditResult result = AuditResult::DENIED;
+        if(isAccessible(pItem, userGroup, groups)){
+            result = editTimed(pItem, val, Timing::NOW, 0, pTimerWheel);
+        }
+        countResult(result);
+        if(pAuditLog != nullptr){
+            pAuditLog->append(senderKey, (uint8_t)index, oldVal, val, result);
+        }
+    }
+}
+
+/**
+ * @brief Edit parameter from message now or by timer wheel.
+ * @param pItem is pointer to item object.
+ * @param val is new value.
+ * @param timing defines when the value is set.
+ * @param seconds is time of Timing::DURATION or Timing::DELAY.
+ * @param pTimerWheel is pointer to timer wheel (null if scheduling is disabled).
+ * @return AuditResult::APPLIED if value is set, AuditResult::SCHEDULED if it is set later,
+ * AuditResult::REJECTED if timed edit can not be scheduled.
+ * 
+ * Edit pending for the parameter is replaced, so a later message wins. Duration restores
+ * the value which the pending edit would have set. Timed edit is ignored without timer wheel,
+ * edit for a duration is not made if it can not be scheduled.
+ */
+AuditResult AdeonBase::ParameterList::editTimed(Item* pItem, uint16_t val, Timing timing, uint16_t seconds,
+                                                TimerWheelBase* pTimerWheel){
+    if(pTimerWheel == nullptr){
+        if(timing != Timing::NOW){
+            return AuditResult::REJECTED;
+        }
+        editItemVal(pItem, val);
+        return AuditResult::APPLIED;
+    }
+    ItemHandle handle = makeHandle(pItem);
+    uint16_t restoreVal = getItemVal(pItem);
+    if(pTimerWheel->getPending() != 0){
+        pTimerWheel->cancel(handle, &restoreVal);
+    }
+    switch(timing){
+    case Timing::NOW:
+        break;
+    case Timing::DURATION:
+        if(!pTimerWheel->schedule(handle, restoreVal, seconds * 1000UL)){
+            return AuditResult::REJECTED;
+        }
+        break;
+    case Timing::DELAY:
+        return pTimerWheel->schedule(handle, val, seconds * 1000UL) ? AuditResult::SCHEDULED : AuditResult::REJECTED;
+    }
+    editItemVal(pItem, val);
+    return AuditResult::APPLIED;
+}
+
+/**
+ * @brief Check if sender can access parameter.
+ * @param pItem is pointer to item object (can be null).
+ * @param userGroup is rights level of the sender.
+ * @param groups is bit mask of groups of the sender.
+ * @return <code>true</code> if level of the sender is sufficient and it shares a group with parameter.
+ */
+bool AdeonBase::ParameterList::isAccessible(Item* pItem, uint8_t userGroup, uint16_t groups){
+    return pItem != nullptr && pItem->accessRights >= userGroup && (pItem->groups & groups) != 0;
 }
 
 /**
  * @brief Get parameter access rights.
  * @param pItem is pointer to item object.
  */
-uint8_t Adeon::ParameterList::getParamAccess(Item* pItem){
-    return pItem->accessRights;
+uint8_t AdeonBase::ParameterList::getParamAccess(Item* pItem){
+    if(pItem != nullptr){
+        return pItem->accessRights;
+    }
+    return 0;
 }
\ No newline at end of file
@@ -28,20 +28,45 @@
 #include <Arduino.h>
 #include "utility/MD5.h"
 #include "utility/list.h"
+#include "utility/dedup.h"
+#include "utility/concat.h"
+#include "utility/packed.h"
+#include "utility/timerwheel.h"
+#include "utility/auditlog.h"
+#include "utility/logger.h"
+#include "utility/metrics.h"
+
+#ifdef ADEON_CONCURRENT
+    #include <atomic>
+    #include <mutex>
+    #include <thread>
+#endif
 
 #define ADEON_ADMIN 1
 #define ADEON_USER 2
 #define ADEON_HOST 3
 
+#define ADEON_GROUP_DEFAULT 0x0001 // every user is member of it until setUserGroups()
+#define ADEON_GROUP_ALL 0xFFFF // parameter is not restricted to groups
+
 constexpr static auto SHORT_HASH_LENGTH = 5;
 constexpr static auto MSG_BUFFER_LENGTH = 140; /* - Maximum number of characters in one SMS is 160
                                                   - Each character takes 7 bits of memory
                                                     (7/8 of one byte)
                                                   - Min. buffer size should be 160*7/8 = 140 bytes 
                                                 */
+constexpr static auto ADEON_REPLY_LENGTH = 160; // one SMS
 
-class Adeon {
+/**
+ * @brief Adeon logic shared by all buffer configurations.
+ * 
+ * Buffers are provided by BasicAdeon, so the code is emitted only once
+ * no matter how many configurations are used in a sketch.
+ */
+class AdeonBase {
     public:
+        typedef ItemHandle ParamHandle;
+
         void addUser(const char* phoneNum, uint16_t userGroup = 1);
         void deleteUser(const char* phoneNum);
         void deleteList();
@@ -50,11 +75,15 @@ class Adeon {
         bool isUserInAdeon(const char* phoneNum);
         uint8_t getNumOfUsers();
         uint16_t getUserRightsLevel(const char* phoneNum);
+        void setUserGroups(const char* phoneNum, uint16_t groups);
+        uint16_t getUserGroups(const char* phoneNum);
         void printUsers();
 
         void addParam(const char* pName, uint16_t val = 1);
         void addParamWithCallback(void (*callback)(uint16_t), const char* pName, uint16_t val = 1);
         void setParamAccess(const char* pName, uint8_t access);
+        void setParamGroups(const char* pName, uint16_t groups);
+        uint16_t getParamGroups(const char* pName);
         void deleteParam(const char* pName);
         char* editParamName(const char* pActualName, const char* pNewName);
         void editParamValue(const char* pName, uint16_t val = 1);
@@ -63,20 +92,66 @@ class Adeon {
         uint16_t getParamValue(const char* pName);
         void printParams();
 
-        void parseBuf(const char* pMsg, uint8_t userGroup);
+        ParamHandle handle(const char* pName);
+        bool isHandleValid(ParamHandle& handle);
+        uint16_t getParamValue(ParamHandle& handle);
+        bool readParams(ParamHandle* pHandles, uint16_t* pValues, uint8_t count);
+        void editParamValue(ParamHandle& handle, uint16_t val = 1);
+        void setParamAccess(ParamHandle& handle, uint8_t access);
+        void setParamGroups(ParamHandle& handle, uint16_t groups);
+
+        void forEachChanged(void (*fn)(const char* pName, uint16_t val, uint16_t version));
+        void clearChanged();
+        bool isParamChanged(ParamHandle& handle);
+        uint16_t getParamVersion(const char* pName);
+        uint16_t getParamVersion(ParamHandle& handle);
+
+        void parseBuf(const char* pMsg, uint8_t userGroup, const char* pPhoneNum = nullptr);
+        void parseBuf(ConcatBase& concat, uint8_t userGroup, const char* pPhoneNum = nullptr);
+        const char* getReply();
         bool isAdeonReady();
+        void setDuplicateFilter(DuplicateFilterBase* pDuplicateFilter);
+
+        void setTimerWheel(TimerWheelBase* pTimerWheel);
+        bool scheduleParamValue(const char* pName, uint16_t val, unsigned long delayMs);
+        bool scheduleParamValue(ParamHandle& handle, uint16_t val, unsigned long delayMs);
+        void tick();
+
+        void setAuditLog(AuditLogBase* pAuditLog);
+
+        MemoryStats memoryStats();
+
+    protected:
+        AdeonBase(char* pMsg, uint16_t msgLength, char* pNameBuf, uint8_t itemLength,
+                  char* pHashBuf, uint8_t hashLength, uint8_t capacity, char* pReplyBuf, uint8_t replyLength);
     
     private:
+        /**
+         * @brief When an edit of message takes effect.
+         */
+        enum class Timing{
+            NOW,      // "name = value;"
+            DURATION, // "name = value for seconds;", previous value comes back after the time
+            DELAY     // "name = value in seconds;"
+        };
+
         class Parser {
             public:
-                Parser(char* pMsg);
+                Parser(char* pMsg, char* pNameBuf, uint8_t itemLength, char* pHashBuf, uint8_t hashLength,
+                       MemoryAccount* pMemory);
                 bool isParserReady();
-                bool isMsgValid();
+                bool isMsgValid(const char* pPhoneNum, const unsigned char* pDigest = nullptr);
+                void setDuplicateFilter(DuplicateFilterBase* pDuplicateFilter);
                 bool isNameAvailable();
                 void parse();
 
                 char* getTmpName();
                 uint16_t getValue();
+                Timing getTiming();
+                uint16_t getSeconds();
+                bool isQuery();
+                bool isPacked();
+                bool nextPacked(uint16_t* pStep, uint16_t* pVal);
 
             private:
                 enum class State{
@@ -88,58 +163,196 @@ class Adeon {
                 const char _semicolon = ';';
                 const char _equal = '=';
                 const char _gap = ' ';
+                const char _question = '?';
                 const char _nullChar = '\0';
 
                 class Hash {
                     public:
-                        Hash();
+                        Hash(char* pShortHash, uint8_t hashLength, MemoryAccount* pMemory);
                         bool isHashValid(char* msg, char* hash);
+                        bool isDigestValid(const unsigned char* pDigest, char* hash);
 
                     private:
                         char* _pTmpMsg = nullptr;
-                        char _shortHash[SHORT_HASH_LENGTH + 1];
+                        char* _shortHash;
+                        uint8_t _hashLength;
+                        MemoryAccount* _pMemory;
 
-                        void makeHashFromStr(char* msg);
+                        bool makeHashFromStr(char* msg);
+                        bool makeHashFromDigest(const unsigned char* pDigest);
                         void makeShortHash(char* str);
                 };
 
-                Hash _pHash = Hash();
+                Hash _pHash;
                 State parsState = State::READY;
             
-                char _tmpHash[SHORT_HASH_LENGTH + 1]; // Reserve space for \0 character
-                char _subStr[LIST_ITEM_LENGTH];
-                char _pTmpName[LIST_ITEM_LENGTH];
+                char* _tmpHash; // hashLength + 1 bytes, reserve space for \0 character
+                char* _subStr;
+                char* _pTmpName;
+                uint8_t _itemLength;
+                uint8_t _hashLength;
                 uint16_t _tmpValue;
+                Timing _timing = Timing::NOW;
+                uint16_t _seconds = 0; // time of DURATION or DELAY
                 char* _pMsg = nullptr;
                 uint8_t _numberOfNames = 0; // get by getNumberOfParams(char* pMsg) function
                 uint8_t _processedNames = 0;
+                bool _isQuery = false; // actual item is "name?" instead of "name = value"
+                bool _isPacked = false; // message carries indices and values, see packed.h
+                PackedReader _packed;
+                DuplicateFilterBase* _pDuplicateFilter = nullptr;
 
-                bool isHashParsingValid(); 
+                bool isHashParsingValid(const char* pPhoneNum, const unsigned char* pDigest);
+                bool parseQuery(char* pActualParam);
                 uint8_t getNumberOfNames();
                 char* parseName();
                 void parseValue(char* pActualParam);
+                void parseTiming(char* pValue);
                 char* getCharsUntilEndSym(char* pActualParam, char endSymbol);
                 char* positionOfStr(char* pStr, uint8_t pos, char startSymbol);
         };
 
-        class UserList : public ItemList{
+        /**
+         * @brief Answer to queries of one message, "name=value;" for each parameter.
+         * 
+         * Answer to "status?" is kept until the parameter list changes or a sender
+         * with other rights asks, so repeated polls do not render the list again.
+         */
+        class Reply {
+            public:
+                Reply(char* pBuf, uint8_t capacity);
+                void clear();
+                bool append(const char* pName, uint16_t val, bool known);
+                void finish();
+                const char* get();
+                bool isStatusCached(uint8_t userGroup, uint16_t groups, uint32_t revision);
+                void reuseStatus();
+                void cacheStatus(uint8_t userGroup, uint16_t groups, uint32_t revision);
+                bool isEmpty();
+
+            private:
+                static constexpr const char* more = "..."; // ends answer which does not fit
+
+                char* _pBuf;
+                uint8_t _capacity;
+                uint8_t _length = 0;
+                bool _queried = false;
+                bool _truncated = false;
+                uint8_t _statusLength = 0; // 0 if no status is cached
+                bool _statusTruncated = false;
+                uint8_t _statusGroup = 0;
+                uint16_t _statusGroups = 0;
+                uint32_t _statusRevision = 0;
+        };
+
+        class UserList : public ItemListBase{
+            public:
+                UserList(MemoryAccount* pMemory, uint8_t idLength, uint8_t capacity);
         };
 
-        class ParameterList : public ItemList{
+        class ParameterList : public ItemListBase{
             public:
+                ParameterList(MemoryAccount* pMemory, uint8_t idLength, uint8_t capacity);
                 void addItemWithCallback(const char* pId, uint16_t val, void (*callback)(uint16_t));
                 void setParamAccess(Item* pItem, uint8_t access);
                 uint8_t getParamAccess(Item* pItem);
+                bool isAccessible(Item* pItem, uint8_t userGroup, uint16_t groups);
+                void appendReadable(Reply* pReply, uint8_t userGroup, uint16_t groups);
+                void applyPacked(Parser* pParser, uint8_t userGroup, uint16_t groups, TimerWheelBase* pTimerWheel,
+                                 AuditLogBase* pAuditLog, uint32_t senderKey);
+                AuditResult editTimed(Item* pItem, uint16_t val, Timing timing, uint16_t seconds,
+                                      TimerWheelBase* pTimerWheel);
         };
 
         uint8_t getParamAccess(const char* pName); 
+        bool hasParams();
+        void answerQuery(const char* pName, uint8_t userGroup, uint16_t groups);
+        void editGroups(const char* pName, uint16_t groups);
+        void audit(uint32_t senderKey, uint8_t param, uint16_t oldVal, uint16_t newVal, AuditResult result);
+        void parseMsg(const char* pMsg, const unsigned char* pDigest, uint8_t userGroup, const char* pPhoneNum);
 
-        char _msg[MSG_BUFFER_LENGTH];
+        static constexpr const char* statusQuery = "status";
+        static constexpr char userGroupsSymbol = '@';  // "@phone = groups;" sets groups of user
+        static constexpr char paramGroupsSymbol = '&'; // "&name = groups;" sets groups of parameter
+        static constexpr const char* durationWord = "for";
+        static constexpr const char* delayWord = "in";
+
+        MemoryAccount _memory; // users, parameters and hash calculation
+        char* _msg;
+        uint16_t _msgLength;
         bool _ready = true; // indicator, that Adeon is ready to process new data
 
-        Parser parser = Parser(_msg);
+        Parser parser;
         UserList userList;
         ParameterList paramList;
+        Reply _reply;
+        TimerWheelBase* _pTimerWheel = nullptr;
+        AuditLogBase* _pAuditLog = nullptr;
+
+        #ifdef ADEON_CONCURRENT
+        class WriteSection {
+            public:
+                WriteSection(AdeonBase* pAdeon);
+                ~WriteSection();
+
+            private:
+                AdeonBase* _pAdeon;
+        };
+
+        void waitForReaders();
+
+        /**
+         * @brief Lock and sequence counter, copy of Adeon gets new ones
+         * (keeps <code>Adeon adeon = Adeon();</code> valid).
+         */
+        struct Sync {
+            Sync(){}
+            Sync(const Sync&){}
+            Sync& operator=(const Sync&){ return *this; }
+
+            std::recursive_mutex lock; // serialises writers and list searches
+            std::mutex parseLock; // serialises messages, hash is verified without the lock
+            std::atomic<uint32_t> seq{0}; // odd while a writer changes data
+            std::atomic<uint16_t> readers{0}; // lock-free readers, see waitForReaders()
+            std::atomic<std::thread::id> writer{std::thread::id()}; // thread in outermost write section
+            uint8_t writeDepth = 0;
+        };
+
+        Sync _sync;
+        #endif
+};
+
+/**
+ * @brief Adeon with compile-time buffer sizes.
+ * @tparam MSG_LENGTH is maximum length of processed message.
+ * @tparam ITEM_LENGTH is size of user phone number and parameter name buffers including terminating null character.
+ * @tparam HASH_LENGTH is length of the short hash at the beginning of a message.
+ * @tparam CAPACITY is maximum number of users and maximum number of parameters.
+ * @tparam REPLY_LENGTH is maximum length of answer to queries (0 disables answers).
+ * 
+ * Use the Adeon alias for default sizes. Other configurations can be declared e.g.
+ * <code>BasicAdeon<280, 24> adeon;</code> for long concatenated commands.
+ */
+template<uint16_t MSG_LENGTH = MSG_BUFFER_LENGTH, uint8_t ITEM_LENGTH = LIST_ITEM_LENGTH,
+         uint8_t HASH_LENGTH = SHORT_HASH_LENGTH, uint8_t CAPACITY = LIST_CAPACITY,
+         uint8_t REPLY_LENGTH = ADEON_REPLY_LENGTH>
+class BasicAdeon : public AdeonBase {
+    static_assert(MSG_LENGTH > HASH_LENGTH + 2, "MSG_LENGTH must be longer than hash and its separator");
+    static_assert(ITEM_LENGTH > 1, "ITEM_LENGTH must leave room for at least one character");
+    static_assert(HASH_LENGTH > 0 && HASH_LENGTH <= 32, "HASH_LENGTH must fit into MD5 digest");
+    static_assert(CAPACITY > 0, "CAPACITY must be at least one item");
+
+    public:
+        BasicAdeon() : AdeonBase(_msgBuf, MSG_LENGTH, _nameBuf, ITEM_LENGTH, _hashBuf, HASH_LENGTH, CAPACITY,
+                                 _replyBuf, REPLY_LENGTH){}
+
+    private:
+        char _msgBuf[MSG_LENGTH + 1]; // Reserve space for \0 character
+        char _nameBuf[2 * ITEM_LENGTH]; // parsed name and parsed substring
+        char _hashBuf[2 * (HASH_LENGTH + 1)]; // received and calculated hash
+        char _replyBuf[REPLY_LENGTH + 1];
 };
 
+using Adeon = BasicAdeon<>;
+
 #endif // ADEON_GSM_H
\ No newline at end of file
@@ -14,12 +14,14 @@ MD5::MD5()
 	return;
 }
 
-char* MD5::make_digest(const unsigned char *digest, int len) /* {{{ */
+static char* fill_digest(char *md5str, const unsigned char *digest, int len)
 {
-	char * md5str = (char*) malloc(sizeof(char)*(len*2+1));
 	static const char hexits[17] = "0123456789abcdef";
 	int i;
 
+	if (md5str == nullptr) {
+		return nullptr;
+	}
 	for (i = 0; i < len; i++) {
 		md5str[i * 2]       = hexits[digest[i] >> 4];
 		md5str[(i * 2) + 1] = hexits[digest[i] &  0x0F];
@@ -28,6 +30,20 @@ char* MD5::make_digest(const unsigned char *digest, int len) /* {{{ */
 	return md5str;
 }
 
+char* MD5::make_digest(const unsigned char *digest, int len) /* {{{ */
+{
+	return fill_digest((char*) malloc(sizeof(char)*(len*2+1)), digest, len);
+}
+
+/*
+ * Same as make_digest(), the string is counted in memory account and must be
+ * released by memory.release(md5str, len * 2 + 1).
+ */
+char* MD5::make_digest(const unsigned char *digest, int len, MemoryAccount& memory)
+{
+	return fill_digest((char*) memory.allocate(sizeof(char)*(len*2+1)), digest, len);
+}
+
 /*
  * The basic MD5 functions.
  *
@@ -307,4 +323,19 @@ unsigned char* MD5::make_hash(char *arg,size_t size)
 	MD5Final(hash, &context);
 	return hash;
 }
-
+/*
+ * Same as make_hash(char*), the hash is counted in memory account and must be
+ * released by memory.release(hash, 16).
+ */
+unsigned char* MD5::make_hash(char *arg, MemoryAccount& memory)
+{
+	MD5_CTX context;
+	unsigned char * hash = (unsigned char *) memory.allocate(16);
+	if (hash == nullptr) {
+		return nullptr;
+	}
+	MD5Init(&context);
+	MD5Update(&context, arg, strlen(arg));
+	MD5Final(hash, &context);
+	return hash;
+}
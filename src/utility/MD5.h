@@ -25,8 +25,9 @@
 
 #include "Arduino.h"
 #include <string.h>
+#include "memstats.h"
 
-typedef unsigned long MD5_u32plus;
+typedef uint32_t MD5_u32plus;
 
 typedef struct {
 	MD5_u32plus lo, hi;
@@ -42,6 +43,8 @@ public:
 	static unsigned char* make_hash(char *arg);
 	static unsigned char* make_hash(char *arg,size_t size);
 	static char* make_digest(const unsigned char *digest, int len);
+	static unsigned char* make_hash(char *arg, MemoryAccount& memory);
+	static char* make_digest(const unsigned char *digest, int len, MemoryAccount& memory);
  	static const void *body(void *ctxBuf, const void *data, size_t size);
 	static void MD5Init(void *ctxBuf);
 	static void MD5Final(unsigned char *result, void *ctxBuf);
@@ -24,29 +24,40 @@
 
 #ifdef HW_SERIAL
 /**
- * @brief Constructor for the class GSM.
+ * @brief Constructor for the class GSMBase.
+ * @param pPhoneBuf is a pointer to phone number buffer of phoneLength bytes
+ * @param phoneLength, rxLength, msgLength are buffer limits
  * @param baudrate for Serial2 (default 9600)
  * Creat instances of parser and serial hanfler.
  */
-GSM::GSM(long baud){
+GSMBase::GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, long baud){
     #ifdef ESP32
         Serial2.begin(DEFAULT_BAUD_RATE, SERIAL_8N1, RX, TX);
     #else
         Serial2.begin(baud);
     #endif
 
-    _pSerialHandler = new SerialHandler(&Serial2);
-    _pParser = new ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex);
+    _pSerialHandler = new (&_memory) SerialHandler(&Serial2, rxLength, &_memory);
+    _pParser = new (&_memory) ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex, pPhoneBuf, phoneLength, msgLength, &_memory);
     _pPhoneBuffer = _pParser->getPointPhoneBuf();
+    #ifdef ESP32
+        _baud = DEFAULT_BAUD_RATE;
+    #else
+        _baud = baud;
+    #endif
+    _baudHandler = setHardwareBaud;
 }
 #endif
 
+#ifndef POSIX_SERIAL
 /**
- * @brief Constructor for the class GSM.
+ * @brief Constructor for the class GSMBase.
+ * @param pPhoneBuf is a pointer to phone number buffer of phoneLength bytes
+ * @param phoneLength, rxLength, msgLength are buffer limits
  * @param RX and TX pins, baudrate (default 9600)
  * Create instances of parser and serial handler.
  */
-GSM::GSM(uint8_t rx, uint8_t tx, long baud) {
+GSMBase::GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, uint8_t rx, uint8_t tx, long baud) {
 Stream *pGsmSerial = nullptr;
 
 #ifdef SW_SERIAL
@@ -65,59 +76,302 @@ Stream *pGsmSerial = nullptr;
     #endif
     pGsmSerial = &Serial2;
 #endif
-    _pSerialHandler = new SerialHandler(pGsmSerial);
-    _pParser = new ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex);
+    _pSerialHandler = new (&_memory) SerialHandler(pGsmSerial, rxLength, &_memory);
+    _pParser = new (&_memory) ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex, pPhoneBuf, phoneLength, msgLength, &_memory);
     _pPhoneBuffer = _pParser->getPointPhoneBuf();   
+    _baud = baud;
+#if defined(SW_SERIAL) && !defined(ESP8266)
+    _baudHandler = setSoftwareBaud;
+    _pBaudContext = pGsmSerial;
+#elif defined(HW_SERIAL)
+    _baudHandler = setHardwareBaud;
+#endif
 }
+#endif
 
 /**
- * @brief Constructor for the class GSM.
+ * @brief Constructor for the class GSMBase.
+ * @param pPhoneBuf is a pointer to phone number buffer of phoneLength bytes
+ * @param phoneLength, rxLength, msgLength are buffer limits
  * @param pGsmSerial is a pointer to Serial object
  * Creat instances of parser and serial hanfler.
  */
-GSM::GSM(Stream* pGsmSerial) {
-    _pSerialHandler = new SerialHandler(pGsmSerial);
-    _pParser = new ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex);
+GSMBase::GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, Stream* pGsmSerial) {
+    _pSerialHandler = new (&_memory) SerialHandler(pGsmSerial, rxLength, &_memory);
+    _pParser = new (&_memory) ParserGSM(_pSerialHandler, &_newMsg, &_lastMsgIndex, pPhoneBuf, phoneLength, msgLength, &_memory);
     _pPhoneBuffer = _pParser->getPointPhoneBuf();   
 }
 
+/**
+ * @brief Take depth of this GSM out of QUEUE_DEPTH.
+ */
+GSMBase::~GSMBase(){
+    AdeonMetrics::add(Metric::QUEUE_DEPTH, 0 - _reportedDepth);
+}
+
 /**
  * @brief Checks for incoming SMS.
 Checks serial for new incoming message. If message is detected, it starts to checks its validity.
 If message is valid phone number and message text are parsed.
 When the message is processed, SMS is deleted from GSM buffer.
 If GSM buffer keeps more than 10 SMS, whole buffer will be deleted.
+ * 
+ * Call blocks until the message is read and deleted. Use poll() to share the loop with other work.
+ * Outgoing SMS of the queue and health probe do not block, they move one step with each call.
  */
-void GSM::checkGsmOutput(){
-    _pSerialHandler->periodicSerialCheck();
-    //check if SMS is received
-    if(_pSerialHandler->isRxBufferAvailable()){
-        if(_pParser->identifyIncomingMsg(incomingSms)){
-            if(sendCommand(_pParser->makeDynamicCmd(smsReading, _lastMsgIndex))){
-                _pParser->getPhoneNumber();
-                _pParser->getMsg();
-                _pMsgBuffer = _pParser->getPointMsgBuf();
-                if(_lastMsgIndex > 10){
-                    deleteMsgGsmStack();
-                }
-                else{
-                    deleteMsg();
-                }
+void GSMBase::checkGsmOutput(){
+    poll();
+    while(isBusy() && _task != Task::SEND_SMS && _task != Task::SEND_SMS_BODY && _task != Task::PROBE){
+        delay(COMMAND_POLL_TIME);
+        poll();
+    }
+}
+
+/**
+ * @brief Make one non-blocking step of incoming SMS processing.
+ * @return <code>true</code> if a command is in progress, <code>false</code> if GSM is idle.
+ * 
+ * Same work as checkGsmOutput(), but it never waits for the modem. AT command is written
+ * and its answer is taken by one of the following calls, so many GSM objects can be
+ * served by one loop.
+ */
+bool GSMBase::poll(){
+    switch(_task){
+    case Task::IDLE:
+        //SMS announced during previous command is read first
+        if(_pendingMsgCount != 0){
+            startPendingRead();
+            break;
+        }
+        //check if SMS is received, all notifications of one read are kept
+        if(_pSerialHandler->settledSerialCheck()){
+            if(takePendingMsgs()){
+                startPendingRead();
+            }
+        }
+        //outgoing SMS is sent while nothing comes from GSM
+        else if(_pSmsQueue != nullptr && !_pSerialHandler->_rxPending){
+            startSmsSending();
+        }
+        //modem which has been idle for a long time is checked
+        if(_task == Task::IDLE && _probeTime != 0 && !_pSerialHandler->_rxPending
+           && millis() - _cmdStartTime >= _probeTime && startCommand(basicCommand)){
+            _task = Task::PROBE;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+
+    case Task::PROBE:
+        if(checkResponse() != Response::PENDING){
+            takePendingMsgs();
+            _task = Task::IDLE;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+
+    case Task::READ_SMS:
+        switch(checkResponse()){
+        case Response::OK:
+            takePendingMsgs();
+            AdeonMetrics::add(Metric::SMS_RECEIVED);
+            _pParser->getPhoneNumber();
+            if(_pRateLimiter == nullptr || _pRateLimiter->allow(_pPhoneBuffer)){
+                readMsg();
+            }
+            startDelete(_lastMsgIndex > 10);
+            break;
+        case Response::FAILED:
+            ADEON_LOG_ERROR(F("ERR"));
+            startDelete(true);
+            break;
+        default:
+            break;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+
+    case Task::DELETE_SMS:
+    case Task::DELETE_STACK:
+        switch(checkResponse()){
+        case Response::OK:
+            takePendingMsgs();
+            ADEON_LOG_INFO(F("MSG DELETED"));
+            AdeonMetrics::add(Metric::SMS_DELETED);
+            _lastMsgIndex--;
+            if(_task == Task::DELETE_STACK && _lastMsgIndex != 0){
+                startDelete(true);
             }
             else{
-                Serial.println(F("ERR"));
-                deleteMsgGsmStack();
+                _task = Task::IDLE;
             }
+            break;
+        case Response::FAILED:
+            //remaining messages are deleted with the next incoming message
+            ADEON_LOG_ERROR(F("DELETE ERR"));
+            _task = Task::IDLE;
+            break;
+        default:
+            break;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+
+    case Task::SEND_SMS:
+        switch(checkResponse(smsPrompt)){
+        case Response::OK:
+            takePendingMsgs();
+            //queue can be reset meanwhile
+            if(*_pSmsQueue->getSendingText() == '\0'){
+                _pSerialHandler->serialSendText("", smsCancel);
+                _pSmsQueue->finishSending(false);
+                _task = Task::IDLE;
+                break;
+            }
+            _pSerialHandler->serialSendText(_pSmsQueue->getSendingText(), smsEnd);
+            _cmdStartTime = millis();
+            _cmdTimeout = SMS_SEND_TIMEOUT;
+            _task = Task::SEND_SMS_BODY;
+            break;
+        case Response::FAILED:
+            _pSerialHandler->serialSendText("", smsCancel);
+            ADEON_LOG_ERROR(F("SMS ERR"));
+            _pSmsQueue->finishSending(false);
+            _task = Task::IDLE;
+            break;
+        default:
+            break;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+
+    case Task::SEND_SMS_BODY:
+        switch(checkSmsSent()){
+        case Response::OK:
+            takePendingMsgs();
+            ADEON_LOG_INFO(F("SMS SENT"));
+            _pSmsQueue->finishSending(true);
+            _task = Task::IDLE;
+            break;
+        case Response::FAILED:
+            ADEON_LOG_ERROR(F("SMS ERR"));
+            _pSmsQueue->finishSending(false);
+            _task = Task::IDLE;
+            break;
+        default:
+            break;
+        }
+        _pSerialHandler->setRxBufferAvailability(false);
+        break;
+    }
+    //gauge is shared by all GSM objects, only the change is added
+    uint32_t depth = _pendingMsgCount + ((_pSmsQueue != nullptr) ? _pSmsQueue->getDepth() : 0);
+    if(depth != _reportedDepth){
+        AdeonMetrics::add(Metric::QUEUE_DEPTH, depth - _reportedDepth);
+        _reportedDepth = depth;
+    }
+    return isBusy();
+}
+
+/**
+ * @brief Check if a command is in progress.
+ * @return <code>true</code> if GSM waits for answer of the modem, <code>false</code> otherwise.
+ */
+bool GSMBase::isBusy(){
+    return _task != Task::IDLE;
+}
+
+/**
+ * @brief Time when poll() has to be called next.
+ * @return millis() timestamp, it can already be in the past.
+ * 
+ * Between deadlines poll() is needed only when the modem sends something, so a sketch
+ * can sleep until the deadline or serial activity, whichever comes first.
+ * Compare it as <code>(long)(nextDeadline() - millis()) <= 0</code> to survive millis() overflow.
+ */
+unsigned long GSMBase::nextDeadline(){
+    unsigned long now = millis();
+    unsigned long deadline;
+    if(_task == Task::IDLE){
+        if(_pendingMsgCount != 0){
+            return now;
+        }
+        deadline = now + _idleCheckTime;
+        if(_probeTime != 0 && (long)(_cmdStartTime + _probeTime - deadline) < 0){
+            deadline = ((long)(_cmdStartTime + _probeTime - now) > 0) ? _cmdStartTime + _probeTime : now;
+        }
+        unsigned long due;
+        if(_pSmsQueue != nullptr && !_pSerialHandler->_rxPending && _pSmsQueue->getNextDueTime(&due)
+           && (long)(due - deadline) < 0){
+            deadline = ((long)(due - now) > 0) ? due : now;
         }
     }
-    _pSerialHandler->setRxBufferAvailability(false);
+    else{
+        //answer is not checked sooner
+        deadline = _cmdStartTime + COMMAND_DELAY;
+        if((long)(deadline - now) > 0){
+            return deadline;
+        }
+        deadline += _cmdTimeout;
+    }
+    if(_pSerialHandler->_rxPending){
+        unsigned long settled = _pSerialHandler->_lastReadTime + RX_SETTLE_TIME;
+        if((long)(settled - deadline) < 0){
+            deadline = settled;
+        }
+    }
+    else if(_pSerialHandler->_pGsmSerial->available() > 0){
+        return now;
+    }
+    return deadline;
+}
+
+/**
+ * @brief Set time between checks of idle GSM reported by nextDeadline().
+ * @param idleCheckTime is time in ms (default PERIODIC_READ_TIME).
+ * 
+ * Sketch which wakes up on serial activity can use a long time, it does not miss any message.
+ */
+void GSMBase::setIdleCheckTime(unsigned long idleCheckTime){
+    _idleCheckTime = idleCheckTime;
+}
+
+/**
+ * @brief Set function which changes baud rate of the local port.
+ * @param handler is a pointer to function, it returns <code>true</code> if the rate is changed.
+ * @param pContext is a pointer passed to the handler, e.g. the port.
+ * 
+ * Constructors with pins or baud rate set it for Serial2 or SoftwareSerial, GSM(Stream*) needs it
+ * for setTargetBaud(), e.g. PosixSerial::setBaud() in a small function.
+ */
+void GSMBase::setBaudHandler(BaudHandler handler, void* pContext){
+    _baudHandler = handler;
+    _pBaudContext = pContext;
+}
+
+/**
+ * @brief Let begin() raise baud rate of the link by AT+IPR.
+ * @param baud is wanted rate, it is limited by MAX_BAUD_RATE of the board (0 disables).
+ * 
+ * Slower rates are tried when the wanted one fails. begin() also finds the modem
+ * if it kept a faster rate from before reset of the board.
+ */
+void GSMBase::setTargetBaud(long baud){
+    _targetBaud = baud;
+}
+
+/**
+ * @brief Get current baud rate of the link.
+ * @return baud rate.
+ */
+long GSMBase::getBaud(){
+    return _baud;
 }
 
 /**
  * @brief Returns new message availability.
  * @return _newMsg <code>true</code> if new message is available, <code>false</code> otherwise.
  */
-bool GSM::isNewMsgAvailable(){
+bool GSMBase::isNewMsgAvailable(){
     return _newMsg;
 }
 
@@ -125,7 +379,7 @@ bool GSM::isNewMsgAvailable(){
  * @brief Returns pointer to message buffer array.
  * @return _pMsgBuffer is a pointer to an array.
  */
-char* GSM::getMsg(){
+char* GSMBase::getMsg(){
     _newMsg = false; //sms is returned, preparing logical variable for new msg
     return _pMsgBuffer;
 }
@@ -134,65 +388,483 @@ char* GSM::getMsg(){
  * @brief Returns pointer to phone number buffer array.
  * @return _phoneBuffer is a pointer to an array.
  */
-char* GSM::getPhoneNum(){
+char* GSMBase::getPhoneNum(){
     return _pPhoneBuffer;
 }
 
 /**
- * @brief Sets GSM module.
- * Performs standard AT test, sets GSM mode and message in plain text
+ * @brief Set rate limiter of incoming messages.
+ * @param pRateLimiter is pointer to rate limiter (null disables limiting).
+ * 
+ * Message over the limit is deleted from GSM without being copied,
+ * so isNewMsgAvailable() does not report it.
+ */
+void GSMBase::setRateLimiter(RateLimiterBase* pRateLimiter){
+    _pRateLimiter = pRateLimiter;
+}
+
+/**
+ * @brief Set queue of outgoing SMS.
+ * @param pSmsQueue is pointer to queue (null disables sending).
+ * 
+ * Queue is sent by poll() when no incoming SMS is processed. Change it only while GSM is not busy.
+ * Queue has to use the same clock as GSM, millis() by default.
+ */
+void GSMBase::setSmsQueue(SmsQueueBase* pSmsQueue){
+    _pSmsQueue = pSmsQueue;
+}
+
+/**
+ * @brief Set assembler of concatenated SMS, call it before begin().
+ * @param pConcat is pointer to assembler (null disables reassembly).
+ * 
+ * begin() lets GSM show header values of SMS (AT+CSDH=1). Parts of a long SMS are then
+ * passed to the assembler and only the whole message is reported by isNewMsgAvailable().
+ * Its text is returned by getMsg() and can be given to Adeon::parseBuf(concat, ...),
+ * RX_LENGTH of the GSM configuration has to hold a part in hex, e.g. BasicGSM<400>.
+ * Adeon has to be BasicAdeon with MSG_LENGTH of the whole message (see BufferSizing example),
+ * longer message is dropped by Adeon with a warning and counted in PARSE_ERRORS.
+ */
+void GSMBase::setConcat(ConcatBase* pConcat){
+    _pConcat = pConcat;
+}
+
+/**
+ * @brief Set monitor of AT command latency and modem health.
+ * @param pHealth is pointer to monitor (null disables monitoring).
+ * @param probeTime is time in ms after the last command when idle GSM sends AT (0 disables it),
+ * so a modem which stops answering is found before the next SMS is missed.
+ *
+ * Every command is recorded, also the ones of begin() and sendCommand().
+ */
+void GSMBase::setHealthMonitor(ModemHealth* pHealth, unsigned long probeTime){
+    _pHealth = pHealth;
+    _probeTime = (pHealth != nullptr) ? probeTime : 0;
+}
+
+/**
+ * @brief Queue SMS for recipient, it is sent by following calls of poll() or checkGsmOutput().
+ * @param pPhoneNum is pointer to phone number string of recipient, e.g. "+420123456789".
+ * @param pText is pointer to text string.
+ * @return <code>true</code> if SMS is queued, <code>false</code> if there is no queue or it is full.
+ * 
+ * Texts for the same recipient within coalescing window of the queue are sent as one SMS.
+ */
+bool GSMBase::sendSms(const char* pPhoneNum, const char* pText){
+    return _pSmsQueue != nullptr && _pSmsQueue->send(pPhoneNum, pText);
+}
+
+/**
+ * @brief Read serial without settle time.
+ * @param immediateRead is <code>true</code> if stream publishes whole answers of the modem,
+ * e.g. SerialReader on ESP32 or Linux.
+ * 
+ * Answer to a command is still taken after COMMAND_DELAY.
+ */
+void GSMBase::setImmediateRead(bool immediateRead){
+    _pSerialHandler->_immediateRead = immediateRead;
+    _pSerialHandler->_rxPending = false;
+}
+
+/**
+ * @brief Get heap usage of GSM.
+ * @return Counters of memory used by parser, serial handler and their buffers.
+ * 
+ * Phone number buffer is not included, its size is given by sizeof of the GSM configuration.
+ */
+MemoryStats GSMBase::memoryStats(){
+    return _memory.getStats();
+}
+
+/**
+ * @brief Bring GSM to full functionality and SMS text mode.
+ * @param warmStart is <code>true</code> if state of GSM is queried instead of AT and settings
+ * already in place are not sent again, e.g. after reboot of the MCU only.
+ * @return BeginStatus::OK if GSM is ready, otherwise the step which failed.
+ * 
+ * Every command is retried BEGIN_ATTEMPTS times with pauses growing from BEGIN_BACKOFF_MIN
+ * to BEGIN_BACKOFF_MAX, so begin() returns even if the modem is off.
+ */
+GSMBase::BeginStatus GSMBase::begin(bool warmStart){
+    if(_targetBaud != 0){
+        //modem can keep faster rate from before reset of the board
+        detectBaud();
+    }
+    if(!sendWithBackoff(warmStart ? stateQuery : basicCommand)){
+        ADEON_LOG_ERROR(F("GSM IS OFFLINE"));
+        return BeginStatus::OFFLINE;
+    }
+    ADEON_LOG_INFO(F("GSM IS ONLINE"));
+    bool gsmModeSet = warmStart && isInAnswer(gsmModeActive);
+    bool textModeSet = warmStart && isInAnswer(textModeActive);
+    if(!gsmModeSet && !sendWithBackoff(gsmMode)){
+        ADEON_LOG_ERROR(F("CONFIG FAILED"));
+        return BeginStatus::CONFIG_FAILED;
+    }
+    ADEON_LOG_INFO(F("GSM IS CONFIGURED"));
+    if(!textModeSet && !sendWithBackoff(plainTextMode)){
+        ADEON_LOG_ERROR(F("MSG SETTING FAILED"));
+        return BeginStatus::TEXT_MODE_FAILED;
+    }
+    if(_pConcat != nullptr && !sendWithBackoff(headerValues)){
+        ADEON_LOG_ERROR(F("MSG SETTING FAILED"));
+        return BeginStatus::TEXT_MODE_FAILED;
+    }
+    ADEON_LOG_INFO(F("MSG SET TO TEXT"));
+    if(_targetBaud != 0){
+        upgradeBaud();
+    }
+    return BeginStatus::OK;
+}
+
+/**
+ * @brief Send command and wait for its answer.
+ * @param cmd is an pointer to a command array.
+ * @return <code>true</code> if GSM answers OK, <code>false</code> otherwise.
+ * 
+ * Command can be sent only when GSM is not busy with incoming SMS, see isBusy().
+ */
+bool GSMBase::sendCommand(const char* cmd){
+    if(isBusy() || !startCommand(cmd)){
+        return false;
+    }
+    Response response;
+    while((response = checkResponse()) == Response::PENDING){
+        delay(COMMAND_POLL_TIME);
+    }
+    return response == Response::OK;
+}
+
+/**
+ * @brief Send command built by AtCommand and wait for its answer.
+ * @param cmd is a reference to command.
+ * @return <code>true</code> if GSM answers OK, <code>false</code> otherwise (also for too long command).
+ */
+bool GSMBase::sendCommand(const AtCommandBase& cmd){
+    return cmd.isValid() && sendCommand(cmd.c_str());
+}
+
+/**
+ * @brief Send command until GSM answers OK, with exponential backoff between tries.
+ * @param cmd is an pointer to a command array.
+ * @return <code>true</code> if GSM answers OK, <code>false</code> after BEGIN_ATTEMPTS failures.
+ */
+bool GSMBase::sendWithBackoff(const char* cmd){
+    unsigned long backoff = BEGIN_BACKOFF_MIN;
+    for(uint8_t attempt = 0; attempt < BEGIN_ATTEMPTS; attempt++){
+        if(sendCommand(cmd)){
+            return true;
+        }
+        delay(backoff);
+        backoff = (backoff * 2 < BEGIN_BACKOFF_MAX) ? backoff * 2 : BEGIN_BACKOFF_MAX;
+    }
+    return false;
+}
+
+//tried baud rates in multiples of DEFAULT_BAUD_RATE, fastest first
+static const uint8_t baudSteps[] = {12, 6, 4, 2, 1};
+
+/**
+ * @brief Find baud rate of the modem when it does not answer at the current one.
+ * @return <code>true</code> if modem answers, <code>false</code> otherwise (current rate is kept).
+ */
+bool GSMBase::detectBaud(){
+    if(_baudHandler == nullptr || sendCommand(basicCommand)){
+        return true;
+    }
+    long original = _baud;
+    for(uint8_t i = 0; i < sizeof(baudSteps); i++){
+        long baud = (long)baudSteps[i] * DEFAULT_BAUD_RATE;
+        if(baud > MAX_BAUD_RATE || baud == original){
+            continue;
+        }
+        if(setLocalBaud(baud) && sendCommand(basicCommand)){
+            return true;
+        }
+    }
+    setLocalBaud(original);
+    return false;
+}
+
+/**
+ * @brief Move the link to the fastest rate up to the target which works.
+ * 
+ * Rates which fail are skipped, so the link stays at the last working one.
+ */
+void GSMBase::upgradeBaud(){
+    long target = (_targetBaud < MAX_BAUD_RATE) ? _targetBaud : MAX_BAUD_RATE;
+    if(_baudHandler == nullptr){
+        return;
+    }
+    for(uint8_t i = 0; i < sizeof(baudSteps); i++){
+        long baud = (long)baudSteps[i] * DEFAULT_BAUD_RATE;
+        if(baud > target){
+            continue;
+        }
+        if(baud <= _baud || switchBaud(baud)){
+            break;
+        }
+    }
+    ADEON_LOG_INFO(F("BAUD "), (long)_baud);
+}
+
+/**
+ * @brief Switch the modem and local port to a new rate and verify the link by AT.
+ * @param baud is new baud rate.
+ * @return <code>true</code> if link works at the new rate, <code>false</code> if the old rate is restored.
+ * 
+ * Modem answers AT+IPR at the old rate. If the link does not work at the new rate,
+ * modem is asked to return to the old one, which passes when only receiving is broken,
+ * e.g. SoftwareSerial at high rate.
  */
-void GSM::begin(){
-    while(sendCommand(basicCommand) != true){
-        delay(1000);
-        Serial.println(F("GSM IS OFFLINE"));
+bool GSMBase::switchBaud(long baud){
+    long oldBaud = _baud;
+    if(!sendCommand(AtCommand(baudRateSetting).arg(baud))){
+        return false;
+    }
+    if(setLocalBaud(baud) && sendCommand(basicCommand)){
+        return true;
     }
-    Serial.println(F("GSM IS ONLINE"));
-    delay(1000);
-    while(sendCommand(gsmMode) != true){
-        delay(1000);
-        Serial.println(F("CONFIG FAILED"));
+    sendCommand(AtCommand(baudRateSetting).arg(oldBaud));
+    setLocalBaud(oldBaud);
+    if(!sendCommand(basicCommand)){
+        detectBaud();
     }
-    Serial.println(F("GSM IS CONFIGURED"));
-    delay(1000);
-    while(sendCommand(plainTextMode) != true){
-        delay(1000);
-        Serial.println(F("MSG SETTING FAILED"));
+    return false;
+}
+
+/**
+ * @brief Change rate of the local port by the baud handler.
+ * @param baud is new baud rate.
+ * @return <code>true</code> if port is changed, <code>false</code> otherwise.
+ */
+bool GSMBase::setLocalBaud(long baud){
+    if(!_baudHandler(baud, _pBaudContext)){
+        return false;
     }
-    Serial.println(F("MSG SET TO TEXT"));
-    delay(1000);
+    _baud = baud;
+    delay(COMMAND_POLL_TIME); //line settles at the new rate
+    return true;
+}
+
+#ifdef HW_SERIAL
+/**
+ * @brief Baud handler of Serial2.
+ */
+bool GSMBase::setHardwareBaud(long baud, void* pContext){
+    (void)pContext;
+    #ifdef ESP32
+        Serial2.updateBaudRate(baud);
+    #else
+        Serial2.end();
+        Serial2.begin(baud);
+    #endif
+    return true;
 }
+#endif
 
+#if defined(SW_SERIAL) && !defined(ESP8266)
 /**
- * @brief Send command from parameter to serial.
+ * @brief Baud handler of SoftwareSerial.
+ * @param pContext is a pointer to SoftwareSerial.
+ */
+bool GSMBase::setSoftwareBaud(long baud, void* pContext){
+    SoftwareSerial* pSerial = (SoftwareSerial*)pContext;
+    pSerial->end();
+    pSerial->begin(baud);
+    return true;
+}
+#endif
+
+/**
+ * @brief Search answer to the last command.
+ * @param expected is a pointer to searched string.
+ * @return <code>true</code> if answer contains expected string, <code>false</code> otherwise.
+ */
+bool GSMBase::isInAnswer(const char* expected){
+    char* pAnswer = _pSerialHandler->getRxBufferP();
+    return pAnswer != nullptr && strstr(pAnswer, expected) != nullptr;
+}
+
+/**
+ * @brief Write command without waiting for answer.
  * @param cmd is an pointer to a command array.
- * @return _pParser->getResponse(confirmFeedback) <code>true</code> if GSM answers OK, <code>false</code> otherwise.
+ * @return <code>true</code> if command is written, <code>false</code> if command is null.
+ */
+bool GSMBase::startCommand(const char* cmd){
+    if(cmd == nullptr){
+        return false;
+    }
+    _pSerialHandler->serialSend(cmd);
+    _cmdStartTime = millis();
+    _cmdTimeout = COMMAND_TIMEOUT;
+    if(_pHealth != nullptr){
+        _cmdType = ModemHealth::classify(cmd);
+    }
+    return true;
+}
+
+/**
+ * @brief Write command built by AtCommand without waiting for answer.
+ * @param cmd is a reference to command.
+ * @return <code>true</code> if command is written, <code>false</code> if it is too long.
+ */
+bool GSMBase::startCommand(const AtCommandBase& cmd){
+    return cmd.isValid() && startCommand(cmd.c_str());
+}
+
+/**
+ * @brief Check answer of the modem to the last command written by startCommand().
+ * @param expected is a pointer to string which confirms the command (OK by default).
+ * @return Response::PENDING while answer can still come, Response::OK or Response::FAILED otherwise.
+ * 
+ * Answer is taken after COMMAND_DELAY, modem has COMMAND_TIMEOUT more to send it.
+ * New message notification which comes alone is kept for later and the answer is still waited for.
+ */
+GSMBase::Response GSMBase::checkResponse(const char* expected){
+    unsigned long elapsed = millis() - _cmdStartTime;
+    if(elapsed < COMMAND_DELAY){
+        return Response::PENDING;
+    }
+    if(_pSerialHandler->settledSerialCheck()){
+        if(_pParser->isResponseOk(expected)){
+            return finishCommand(CommandResult::OK, elapsed);
+        }
+        if(!isInAnswer(errorFeedback) && takePendingMsgs()
+           && elapsed < COMMAND_DELAY + _cmdTimeout){
+            return Response::PENDING;
+        }
+        return finishCommand(CommandResult::FAILED, elapsed);
+    }
+    if(elapsed >= COMMAND_DELAY + _cmdTimeout){
+        return finishCommand(CommandResult::TIMEOUT, elapsed);
+    }
+    return Response::PENDING;
+}
+
+/**
+ * @brief Check network confirmation of the text of SMS written last.
+ * @return Response::PENDING while confirmation can still come, Response::OK or Response::FAILED otherwise.
+ * 
+ * Modem with echo returns the text at once and confirms it seconds later, so only
+ * +CMGS: followed by OK or a line with error finishes the command. Anything else
+ * (echo, new message notification) is waited through until SMS_SEND_TIMEOUT.
+ */
+GSMBase::Response GSMBase::checkSmsSent(){
+    unsigned long elapsed = millis() - _cmdStartTime;
+    if(elapsed < COMMAND_DELAY){
+        return Response::PENDING;
+    }
+    if(_pSerialHandler->settledSerialCheck()){
+        char* pAnswer = _pSerialHandler->getRxBufferP();
+        char* pSent = strstr(pAnswer, smsSent);
+        if(pSent != nullptr && strstr(pSent, confirmFeedback) != nullptr){
+            return finishCommand(CommandResult::OK, elapsed);
+        }
+        if(strstr(pAnswer, smsRefused) != nullptr || strstr(pAnswer, errorLine) != nullptr){
+            return finishCommand(CommandResult::FAILED, elapsed);
+        }
+        takePendingMsgs();
+    }
+    if(elapsed >= COMMAND_DELAY + _cmdTimeout){
+        return finishCommand(CommandResult::TIMEOUT, elapsed);
+    }
+    return Response::PENDING;
+}
+
+/**
+ * @brief Count answer of the last command in metrics and health monitor.
+ * @param result is outcome of the command.
+ * @param elapsed is time in ms since the command was written.
+ * @return Response::OK for CommandResult::OK, Response::FAILED otherwise.
  */
-bool GSM::sendCommand(const char* cmd){
-    _pSerialHandler->serialWrite(cmd);
-    return _pParser->getResponse(confirmFeedback);
+GSMBase::Response GSMBase::finishCommand(CommandResult result, unsigned long elapsed){
+    if(result == CommandResult::TIMEOUT){
+        AdeonMetrics::add(Metric::CMD_TIMEOUTS);
+    }
+    if(_pHealth != nullptr){
+        _pHealth->record(_cmdType, elapsed, result);
+    }
+    return (result == CommandResult::OK) ? Response::OK : Response::FAILED;
 }
 
 /**
- * @brief Send command from deleting message from GSM buffer.
+ * @brief Start deleting of the last message from GSM buffer.
+ * @param wholeStack is <code>true</code> if all messages are deleted one by one.
+ * 
+ * Deleting stops at first failure, remaining messages are deleted with the next incoming message.
  */
-void GSM::deleteMsg(){
-    if(sendCommand(_pParser->makeDynamicCmd(deleteSms, _lastMsgIndex))){
-        Serial.println(F("MSG DELETED"));
-        _lastMsgIndex--;
+void GSMBase::startDelete(bool wholeStack){
+    if(_lastMsgIndex == 0){
+        _task = Task::IDLE;
+        return;
+    }
+    if(startCommand(AtCommand(deleteSms).arg(_lastMsgIndex))){
+        _task = wholeStack ? Task::DELETE_STACK : Task::DELETE_SMS;
     }
     else{
-        Serial.println(F("DELETE ERR"));
+        ADEON_LOG_ERROR(F("DELETE ERR"));
+        _task = Task::IDLE;
     }
 }
 
 /**
- * @brief Send command from deleting messages from GSM buffer until it won't be empty.
+ * @brief Start reading of the oldest announced SMS.
  */
-void GSM::deleteMsgGsmStack(){
-    while(_lastMsgIndex != 0){
-        deleteMsg();
+void GSMBase::startPendingRead(){
+    _lastMsgIndex = _pendingMsgIndex[0];
+    _pendingMsgCount--;
+    memmove(_pendingMsgIndex, &_pendingMsgIndex[1], _pendingMsgCount * sizeof(_pendingMsgIndex[0]));
+    if(startCommand(AtCommand(smsReading).arg(_lastMsgIndex))){
+        _task = Task::READ_SMS;
+    }
+    else{
+        ADEON_LOG_ERROR(F("ERR"));
+        startDelete(true);
+    }
+}
+
+/**
+ * @brief Take the next due SMS of the queue and write AT+CMGS for it.
+ */
+void GSMBase::startSmsSending(){
+    if(!_pSmsQueue->startNext()){
+        return;
+    }
+    if(startCommand(AtCommand(smsSending).quoted(_pSmsQueue->getSendingPhoneNum()))){
+        _task = Task::SEND_SMS;
+    }
+    else{
+        _pSmsQueue->finishSending(false);
+    }
+}
+
+/**
+ * @brief Keep new message notifications of the last read, they are read one by one when GSM is idle.
+ * @return <code>true</code> if a notification is kept, <code>false</code> otherwise.
+ * 
+ * Notifications over PENDING_MSG_SLOTS are lost, the messages stay in GSM buffer.
+ */
+bool GSMBase::takePendingMsgs(){
+    uint8_t count = _pParser->takeIncomingMsgIndexes(incomingSms, &_pendingMsgIndex[_pendingMsgCount],
+                                                     PENDING_MSG_SLOTS - _pendingMsgCount);
+    _pendingMsgCount += count;
+    return count > 0;
+}
+
+/**
+ * @brief Copy message which has been read, part of concatenated SMS is passed to assembler.
+ */
+void GSMBase::readMsg(){
+    if(_pConcat != nullptr && _pParser->addConcatPart(_pConcat)){
+        if(_pConcat->getMsg() != nullptr){
+            _pMsgBuffer = _pConcat->getMsg();
+            _newMsg = true;
+        }
+        return;
     }
+    _pParser->getMsg();
+    _pMsgBuffer = _pParser->getPointMsgBuf();
 }
 
 /**
@@ -200,23 +872,31 @@ void GSM::deleteMsgGsmStack(){
  * @param pSerialHandler is a pointer to SerialHandler object
  * @param newMsg is a pointer to logical variable
  * @param lastMsgIndex is a pointer to GSM buffer number of last message 
+ * @param pPhoneBuf is a pointer to phone number buffer
+ * @param phoneLength is size of phone number buffer
+ * @param msgLength is maximum length of received message
+ * @param pMemory is a pointer to account which counts memory of message and command buffers
  */
-GSM::ParserGSM::ParserGSM(GSM::SerialHandler* pSerialHandler, bool* newMsg, uint8_t* lastMsgIndex){
+GSMBase::ParserGSM::ParserGSM(GSMBase::SerialHandler* pSerialHandler, bool* newMsg, uint16_t* lastMsgIndex,
+                              char* pPhoneBuf, uint8_t phoneLength, uint16_t msgLength, MemoryAccount* pMemory){
+    _pMemory = pMemory;
     _pSerialHandler = pSerialHandler;
     _pNewMsg = newMsg;
     _pLastMsgIndex = lastMsgIndex;
+    _phoneBuffer = pPhoneBuf;
+    _phoneLength = phoneLength;
+    _msgLength = msgLength;
 }
 
 /**
- * @brief Checks reaction of GSM to AT command.
+ * @brief Checks reaction of GSM to AT command which is already in rx buffer.
  * @param searchedChar is a pointer to string
  * @return  <code>true</code> if GSM answer is the same like searchedChar, <code>false</code> otherwise.
  */
-bool GSM::ParserGSM::getResponse(const char* searchedChar){
-    _pSerialHandler->feedbackSerialCheck();
+bool GSMBase::ParserGSM::isResponseOk(const char* searchedChar){
     _pRxBuffer = _pSerialHandler->getRxBufferP();
     if(_pSerialHandler->isRxBufferAvailable()){
-        if(strstr(_pRxBuffer, "OK") != nullptr){
+        if(strstr(_pRxBuffer, searchedChar) != nullptr){
             _pSerialHandler->setRxBufferAvailability(false);
             return true;
         }
@@ -230,18 +910,26 @@ bool GSM::ParserGSM::getResponse(const char* searchedChar){
 /**
  * @brief Gets a message from a new message from the GSM output.
  */
-void GSM::ParserGSM::getMsg(){
+void GSMBase::ParserGSM::getMsg(){
     _pRxBuffer = _pSerialHandler->getRxBufferP();
-    char* tmpStr = strrchr(_pRxBuffer, '\"') + 3;
-    //if semicolon is not present, message is not valid
-    if(strrchr(tmpStr, ';') != nullptr){
+    char* tmpStr = findBody(findHeader());
+    //if semicolon is not present or message does not fit, message is not valid
+    if(tmpStr != nullptr && strrchr(tmpStr, ';') != nullptr){
         char* endMsgPointer = strrchr(tmpStr, ';') + 1;
-        uint8_t counter = 0;
+        uint16_t counter = 0;
+
+        if((size_t)(endMsgPointer - tmpStr) > _msgLength){
+            AdeonMetrics::add(Metric::PARSE_ERRORS);
+            return;
+        }
 
         if(_msgBuffer != nullptr){
-            free(_msgBuffer);
+            _pMemory->release(_msgBuffer, strlen(_msgBuffer) + 1);
+        }
+        _msgBuffer = (char*)_pMemory->allocate(strlen(tmpStr) - strlen(endMsgPointer) + 1);
+        if(_msgBuffer == nullptr){
+            return;
         }
-        _msgBuffer = (char*)malloc(strlen(tmpStr) - strlen(endMsgPointer) + 1);
         while(&tmpStr[counter] != endMsgPointer){
             _msgBuffer[counter] = tmpStr[counter];
             counter++;
@@ -249,19 +937,121 @@ void GSM::ParserGSM::getMsg(){
         _msgBuffer[counter] = '\0';
         *_pNewMsg = true;
     }
+    else{
+        AdeonMetrics::add(Metric::PARSE_ERRORS);
+    }
+}
+
+/**
+ * @brief Passes a part of concatenated SMS to assembler.
+ * @param pConcat is pointer to assembler.
+ * @return <code>true</code> if SMS has user data header, <code>false</code> if it is a plain SMS.
+ * 
+ * GSM shows SMS with user data header in hex, header values (AT+CSDH=1) tell its length and coding.
+ * Hex is converted in place, text of the part is decoded from GSM 7-bit, 8-bit or UCS2 data.
+ * SMS with other header than concatenation is passed as a message of one part.
+ */
+bool GSMBase::ParserGSM::addConcatPart(ConcatBase* pConcat){
+    _pRxBuffer = _pSerialHandler->getRxBufferP();
+    char* pHeader = findHeader();
+    char* pBody = findBody(pHeader);
+    if(pBody == nullptr){
+        return false;
+    }
+    const char* pFirstOctet = findHeaderField(pHeader, pBody, 5);
+    const char* pCoding = findHeaderField(pHeader, pBody, 7);
+    const char* pLength = findHeaderField(pHeader, pBody, 10);
+    if(pLength == nullptr || (atoi(pFirstOctet) & udhIndicator) == 0){
+        return false;
+    }
+    uint8_t coding = atoi(pCoding) & 0x0C;
+    uint16_t dataLength = atoi(pLength);
+
+    uint8_t* pData = (uint8_t*)pBody;
+    uint16_t size = 0;
+    while(size < 255 && hexValue(pBody[2 * size]) >= 0 && hexValue(pBody[2 * size + 1]) >= 0){
+        pData[size] = (hexValue(pBody[2 * size]) << 4) | hexValue(pBody[2 * size + 1]);
+        size++;
+    }
+    if(size == 0 || pData[0] >= size){
+        AdeonMetrics::add(Metric::PARSE_ERRORS);
+        return true; // broken header, part is dropped
+    }
+
+    uint8_t headerLength = pData[0] + 1;
+    uint16_t ref = 0;
+    uint8_t total = 1;
+    uint8_t seq = 1;
+    for(uint8_t i = 1; i + 1 < headerLength && i + 2 + pData[i + 1] <= headerLength; i += 2 + pData[i + 1]){
+        if(pData[i] == 0x00 && pData[i + 1] == 3){
+            ref = pData[i + 2];
+            total = pData[i + 3];
+            seq = pData[i + 4];
+        }
+        else if(pData[i] == 0x08 && pData[i + 1] == 4){
+            ref = (pData[i + 2] << 8) | pData[i + 3];
+            total = pData[i + 4];
+            seq = pData[i + 5];
+        }
+    }
+
+    char* pText = (char*)_pMemory->allocate(SMS_TEXT_LENGTH + 1);
+    if(pText == nullptr){
+        return true;
+    }
+    uint8_t length = 0;
+    if(coding == 0x00){
+        //septets of text start after fill bits which align them behind the header
+        bool escaped = false;
+        for(uint16_t septet = (headerLength * 8 + 6) / 7; septet < dataLength && length < SMS_TEXT_LENGTH; septet++){
+            uint16_t bit = septet * 7;
+            if(bit / 8 >= size){
+                break;
+            }
+            uint16_t value = pData[bit / 8];
+            if(bit / 8 + 1 < size){
+                value |= pData[bit / 8 + 1] << 8;
+            }
+            uint8_t c = (value >> (bit % 8)) & 0x7F;
+            if(c == 0x1B){
+                escaped = true;
+                continue;
+            }
+            pText[length++] = gsmToAscii(c, escaped);
+            escaped = false;
+        }
+    }
+    else if(coding == 0x08){
+        for(uint16_t i = headerLength; i + 1 < size && length < SMS_TEXT_LENGTH; i += 2){
+            pText[length++] = (pData[i] == 0 && pData[i + 1] < 0x80) ? pData[i + 1] : '?';
+        }
+    }
+    else{
+        for(uint16_t i = headerLength; i < size && length < SMS_TEXT_LENGTH; i++){
+            pText[length++] = pData[i];
+        }
+    }
+    pText[length] = '\0';
+    pConcat->add(_phoneBuffer, ref, seq, total, pText);
+    _pMemory->release(pText, SMS_TEXT_LENGTH + 1);
+    return true;
 }
 
 /**
  * @brief Gets a phone number from a new message from the GSM output.
  */
-void GSM::ParserGSM::getPhoneNumber(){
+void GSMBase::ParserGSM::getPhoneNumber(){
     _pRxBuffer = _pSerialHandler->getRxBufferP();
-    char* tmpStr = strstr(_pRxBuffer, "\"+") + 2;
+    memset(_phoneBuffer, 0, _phoneLength);
+    char* tmpStr = (_pRxBuffer != nullptr) ? strstr(_pRxBuffer, "\"+") : nullptr;
+    if(tmpStr == nullptr){
+        return;
+    }
+    tmpStr += 2;
     char* endMsgPointer = strstr(tmpStr, "\",\"\",\"");
     uint8_t counter = 0;
 
-    memset(_phoneBuffer, 0, sizeof(_phoneBuffer));
-    while(&tmpStr[counter] != endMsgPointer){
+    while(&tmpStr[counter] != endMsgPointer && counter < _phoneLength - 1){
         _phoneBuffer[counter] = tmpStr[counter];
         counter++;
     }
@@ -272,7 +1062,7 @@ void GSM::ParserGSM::getPhoneNumber(){
  * @brief Gets a pointer to message buffer
  * @return _msgBuffer is a pointer to an array.
  */
-char* GSM::ParserGSM::getPointMsgBuf(){
+char* GSMBase::ParserGSM::getPointMsgBuf(){
     return _msgBuffer;
 }
 
@@ -280,127 +1070,230 @@ char* GSM::ParserGSM::getPointMsgBuf(){
  * @brief Gets a pointer to phone number buffer
  * * @return _phoneBuffer is a pointer to an array.
  */
-char* GSM::ParserGSM::getPointPhoneBuf(){
+char* GSMBase::ParserGSM::getPointPhoneBuf(){
     return _phoneBuffer;
 }
 
 /**
- * @brief Identifies if new message is on the GSM output
+ * @brief Takes new message notifications which came together with answer to a command.
  * @param command is a pointer to searching command
- * @return  <code>true</code> if new message is on the GSM output, <code>false</code> otherwise.
+ * @param pIndexes is a pointer to array where indexes of new messages are saved
+ * @param capacity is number of free entries of the array
+ * @return number of saved indexes.
+ * 
+ * Notifications are cut off the rx buffer, so the answer can be parsed as usual.
  */
-bool GSM::ParserGSM::identifyIncomingMsg(const char* command){
+uint8_t GSMBase::ParserGSM::takeIncomingMsgIndexes(const char* command, uint16_t* pIndexes, uint8_t capacity){
     _pRxBuffer = _pSerialHandler->getRxBufferP();
+    if(_pRxBuffer == nullptr){
+        return 0;
+    }
+    char* pEnd = _pRxBuffer + strlen(_pRxBuffer);
+    char* pFirst = nullptr;
+    uint8_t count = 0;
     char *tmpStr = strstr(_pRxBuffer, command);
-    if(tmpStr != nullptr){
-        if(strncmp(tmpStr, incomingSms, strlen(incomingSms)) == 0){
-            *_pLastMsgIndex = GetIndex(tmpStr, ',');
-            _pSerialHandler->setRxBufferAvailability(false);
-            return true;
+    while(tmpStr != nullptr && strchr(tmpStr, ',') != nullptr){
+        if(pFirst == nullptr){
+            pFirst = tmpStr;
+        }
+        char* pDigits = strchr(tmpStr, ',') + 1;
+        uint16_t index = GetIndex(tmpStr, ',');
+        if(index != 0 && count < capacity){
+            pIndexes[count++] = index;
+        }
+        //GetIndex ends the digits by null character
+        char* pNext = pDigits + strlen(pDigits) + 1;
+        tmpStr = (pNext < pEnd) ? strstr(pNext, command) : nullptr;
+    }
+    if(pFirst != nullptr){
+        if(pFirst > _pRxBuffer && *(pFirst - 1) == '+'){
+            pFirst--;
+        }
+        *pFirst = '\0';
+    }
+    return count;
+}
+
+/**
+ * @brief Finds header of SMS read by AT+CMGR.
+ * @return Pointer to the header in rx buffer, null if it is missing.
+ */
+char* GSMBase::ParserGSM::findHeader(){
+    return (_pRxBuffer != nullptr) ? strstr(_pRxBuffer, msgHeader) : nullptr;
+}
+
+/**
+ * @brief Finds text of SMS, it starts on the line after the header.
+ * @param pHeader is pointer to the header (can be null).
+ * @return Pointer to the text in rx buffer, null if it is missing.
+ */
+char* GSMBase::ParserGSM::findBody(char* pHeader){
+    char* pBody = (pHeader != nullptr) ? strchr(pHeader, '\n') : nullptr;
+    return (pBody != nullptr) ? pBody + 1 : nullptr;
+}
+
+/**
+ * @brief Finds value in the header, commas inside quotes (time stamp) are skipped.
+ * @param pHeader is pointer to the header.
+ * @param pBody is pointer to the text, end of the header.
+ * @param field is index of value, 0 is status of SMS.
+ * @return Pointer to the value, null if header has less values.
+ */
+const char* GSMBase::ParserGSM::findHeaderField(const char* pHeader, const char* pBody, uint8_t field){
+    uint8_t index = 0;
+    bool quoted = false;
+    for(const char* p = pHeader; p < pBody; p++){
+        if(*p == '"'){
+            quoted = !quoted;
+        }
+        else if(*p == ',' && !quoted && ++index == field){
+            return p + 1;
         }
     }
-    _pSerialHandler->setRxBufferAvailability(false);
-    return false;    
+    return nullptr;
 }
 
 /**
- * @brief Make dynamic command (str + num)
- * @param command is a pointer to command string
- * @param id is a pointer to number which is related to the command
- * @return _cmdBuffer - pointer to _cmdBuffer.
+ * @brief Converts hex digit.
+ * @return Value of the digit, -1 if character is not a hex digit.
  */
-char* GSM::ParserGSM::makeDynamicCmd(const char* command, uint8_t id){
-    if(_cmdBuffer != nullptr){
-        free(_cmdBuffer);
+int8_t GSMBase::ParserGSM::hexValue(char c){
+    if(c >= '0' && c <= '9'){
+        return c - '0';
+    }
+    if(c >= 'A' && c <= 'F'){
+        return c - 'A' + 10;
     }
+    if(c >= 'a' && c <= 'f'){
+        return c - 'a' + 10;
+    }
+    return -1;
+}
 
-    //+ 3 – array cells for 2 digit number and end char
-    _cmdBuffer = (char*)malloc(strlen(command) + 3);
-    strcpy(_cmdBuffer, command);
-    sprintf(&_cmdBuffer[strlen(command)], "%d", id);
-    _cmdBuffer[strlen(command) + 2] = '\0';
-    return _cmdBuffer;
+/**
+ * @brief Converts character of GSM 7-bit default alphabet to ASCII.
+ * @param septet is code of the character.
+ * @param escaped is <code>true</code> if the character follows escape to extension table.
+ * @return ASCII character, '?' for national characters.
+ */
+char GSMBase::ParserGSM::gsmToAscii(uint8_t septet, bool escaped){
+    if(escaped){
+        switch(septet){
+        case 0x14: return '^';
+        case 0x28: return '{';
+        case 0x29: return '}';
+        case 0x2F: return '\\';
+        case 0x3C: return '[';
+        case 0x3D: return '~';
+        case 0x3E: return ']';
+        case 0x40: return '|';
+        default: return '?';
+        }
+    }
+    switch(septet){
+    case 0x00: return '@';
+    case 0x02: return '$';
+    case 0x0A: return '\n';
+    case 0x0D: return '\r';
+    case 0x11: return '_';
+    default: break;
+    }
+    if(septet < 0x20 || septet == 0x24 || septet == 0x40 || (septet >= 0x5B && septet <= 0x60) || septet >= 0x7B){
+        return '?';
+    }
+    return septet;
 }
 
 /**
  * @brief Gets index of incoming message
  * @param buffer is pointer to buffer which is carring the GSM output
  * @param startSym is a start symbol character
- * @return (uint8_t)atoi(tmpStr) - convert string to uint8_t
+ * @return (uint16_t)atol(tmpStr) - index of the message, storages of some modems hold more than 255
  */
-uint8_t GSM::ParserGSM::GetIndex(char* buffer, char startSym){
+uint16_t GSMBase::ParserGSM::GetIndex(char* buffer, char startSym){
     char *tmpStr = strchr(buffer, startSym) + 1;
     uint8_t indexLenCount = 0;
-    while(tmpStr[indexLenCount] >= 0x31 && tmpStr[indexLenCount] <= 0x39){
+    while(tmpStr[indexLenCount] >= 0x30 && tmpStr[indexLenCount] <= 0x39){
         indexLenCount++;
     }
     tmpStr[indexLenCount] = '\0';
-    return (uint8_t)atoi(tmpStr);
+    return (uint16_t)atol(tmpStr);
 }
 
 /**
  * @brief Constructor for the nested class SerialHandler.
  * @param pGsmSerial is a pointer to Serial object
+ * @param rxLength is maximum number of bytes taken from serial in one read
+ * @param pMemory is a pointer to account which counts memory of rx buffer
  */
-GSM::SerialHandler::SerialHandler(Stream* pGsmSerial){
+GSMBase::SerialHandler::SerialHandler(Stream* pGsmSerial, uint16_t rxLength, MemoryAccount* pMemory){
     _pGsmSerial = pGsmSerial;
+    _rxLength = rxLength;
+    _pMemory = pMemory;
 }
 /**
- * @brief Writes command to serial.
+ * @brief Writes command to serial without waiting.
  * @param command is a pointer to command constant
  */
-void GSM::SerialHandler::serialWrite(const char* command){
-    _periodicReading = false;
+void GSMBase::SerialHandler::serialSend(const char* command){
     _pGsmSerial->println(command);
-	_pGsmSerial->flush();
-    delay(200);
-    _periodicReading = true;
+    _pGsmSerial->flush();
+    _rxPending = false;
 }
 
 /**
- * @brief Method which is able to periodicaly (150 ms) read serial output.
- * Searching for incoming GSM output
+ * @brief Writes text of SMS after prompt of GSM.
+ * @param text is a pointer to text string
+ * @param terminator is Ctrl+Z to send the text or ESC to cancel it
  */
-void GSM::SerialHandler::periodicSerialCheck(){
-    if(_periodicReading){
-        if(_periodicReadingFlag){
-            _lastReadTime = millis();
-            _periodicReadingFlag = false;
-        }
-
-        if((millis() - _lastReadTime) >= PERIODIC_READ_TIME){
-            uint16_t var;
-            var = _pGsmSerial->available();
-            delay(100);
-            if(var > 0 && _periodicReading){
-                serialRead(var);
-            }
-            _periodicReadingFlag = true;
-        }
-    }
+void GSMBase::SerialHandler::serialSendText(const char* text, char terminator){
+    _pGsmSerial->print(text);
+    _pGsmSerial->write(terminator);
+    _pGsmSerial->flush();
+    _rxPending = false;
 }
 
 /**
- * @brief Checks serial for feedback of GSM module to AT commands
+ * @brief Non-blocking read of serial output.
+ * @return <code>true</code> if rx buffer has been filled, <code>false</code> otherwise.
+ * 
+ * When bytes are found, they are read RX_SETTLE_TIME later, so the whole answer
+ * of GSM is taken at once. In immediate mode bytes are read as soon as the stream has them.
  */
-void GSM::SerialHandler::feedbackSerialCheck(){
-    unsigned long timeFlag = millis();
-    while(millis() < (timeFlag + 1000)){
-        uint16_t var;
-        var = _pGsmSerial->available();
-        delay(100);
+bool GSMBase::SerialHandler::settledSerialCheck(){
+    if(_immediateRead){
+        uint16_t var = _pGsmSerial->available();
         if(var > 0){
             serialRead(var);
-            break;
+            return _rxBufferAvailable;
         }
+        return false;
     }
+    unsigned long now = millis();
+    if(_rxPending){
+        //_lastReadTime is time when bytes have been found
+        if((now - _lastReadTime) >= RX_SETTLE_TIME){
+            _rxPending = false;
+            uint16_t var = _pGsmSerial->available();
+            if(var > 0){
+                serialRead(var);
+                return _rxBufferAvailable;
+            }
+        }
+        return false;
+    }
+    if(_pGsmSerial->available() > 0){
+        _lastReadTime = now;
+        _rxPending = true;
+    }
+    return false;
 }
 
 /**
  * @brief Gets pointer to rx buffer
  * @return  _rxBuffer is a pointer to _rxBuffer
  */
-char* GSM::SerialHandler::getRxBufferP(){
+char* GSMBase::SerialHandler::getRxBufferP(){
     return _rxBuffer;
 }
 
@@ -408,7 +1301,7 @@ char* GSM::SerialHandler::getRxBufferP(){
  * @brief Availability of rx buffer
  * @return  _rxBufferAvailable <code>true</code> if rx buffer is available, <code>false</code> otherwise.
  */
-bool GSM::SerialHandler::isRxBufferAvailable(){
+bool GSMBase::SerialHandler::isRxBufferAvailable(){
     return _rxBufferAvailable;
 }
 
@@ -416,20 +1309,34 @@ bool GSM::SerialHandler::isRxBufferAvailable(){
  * @brief Sets rx buffer state
  * @param var is a logical state
  */
-void GSM::SerialHandler::setRxBufferAvailability(bool var){
+void GSMBase::SerialHandler::setRxBufferAvailability(bool var){
     _rxBufferAvailable = var;
 }
 
 /**
  * @brief Reads serial output.
  * @param incomingBytes is a number of incoming bytes of actual string in stack
+ * 
+ * At most rxLength bytes are read, the rest stays in serial for the next read.
+ * If heap is exhausted, the bytes are read and discarded and rx buffer is not available.
  */
-void GSM::SerialHandler::serialRead(uint8_t incomingBytes){
+void GSMBase::SerialHandler::serialRead(uint16_t incomingBytes){
+    if(incomingBytes > _rxLength){
+        incomingBytes = _rxLength;
+    }
     if(_rxBuffer != nullptr){
-        free(_rxBuffer);
+        _pMemory->release(_rxBuffer, _rxBufferSize);
         _rxBuffer = nullptr;
     }
-    _rxBuffer = (char*)malloc(sizeof(char) * (incomingBytes + 1));
+    _rxBufferSize = sizeof(char) * (incomingBytes + 1);
+    _rxBuffer = (char*)_pMemory->allocate(_rxBufferSize);
+    if(_rxBuffer == nullptr){
+        //bytes are dropped, otherwise they would be taken as answer to the next command
+        while(incomingBytes-- > 0 && _pGsmSerial->read() >= 0){
+        }
+        _rxBufferAvailable = false;
+        return;
+    }
     _pGsmSerial->readBytes(_rxBuffer, incomingBytes);
     _rxBuffer[incomingBytes] = '\0';
     _rxBufferAvailable = true;
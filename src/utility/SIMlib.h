@@ -24,24 +24,40 @@
 #define ADEON_SIM_LIB_H
 
 #include <Arduino.h>
+#include "utility/memstats.h"
+#include "utility/ratelimit.h"
+#include "utility/atcommand.h"
+#include "utility/smsqueue.h"
+#include "utility/concat.h"
+#include "utility/logger.h"
+#include "utility/metrics.h"
+#include "utility/health.h"
 
 #define DEFAULT_BAUD_RATE       9600
 
+// MAX_BAUD_RATE is the highest rate which GSM negotiates by AT+IPR on the board
 #if defined(__AVR_ATmega2560__)
     #define HW_SERIAL
+    #define MAX_BAUD_RATE   115200
 #elif defined(__AVR_ATmega328P__)       
     #define SW_SERIAL
     #define RX          10
     #define TX          11
+    #define MAX_BAUD_RATE   19200
 #elif defined(ESP8266)
     #define SW_SERIAL
     #define RX          14  //D5
     #define TX          12  //D6
     #define RX_BUF_SIZE 256       
+    #define MAX_BAUD_RATE   DEFAULT_BAUD_RATE
 #elif defined(ESP32)       
     #define HW_SERIAL
     #define RX          16
     #define TX          17
+    #define MAX_BAUD_RATE   115200
+#elif defined(__linux__)
+    #define POSIX_SERIAL
+    #define MAX_BAUD_RATE   115200
 #else
     #error "Unsupported board"
 #endif
@@ -50,102 +66,261 @@
   #include <SoftwareSerial.h>
 #endif
 
+#ifdef POSIX_SERIAL
+  #include "utility/posixserial.h"
+#endif
+
 constexpr static auto RX_BUFFER = 255;
 constexpr static auto MSG_LENGTH = 147;
-constexpr static auto MAX_CMD_LENGTH = 20;
 constexpr static auto PHONE_NUMBER_LENGTH = 16;
-constexpr static auto PERIODIC_READ_TIME = 150; //ms 
+constexpr static auto PERIODIC_READ_TIME = 150; //ms, default idle check of nextDeadline()
+constexpr static auto RX_SETTLE_TIME = 100; //ms, wait for the rest of GSM answer
+constexpr static auto COMMAND_DELAY = 200; //ms, GSM answer is not checked sooner
+constexpr static auto COMMAND_TIMEOUT = 1000; //ms
+constexpr static auto SMS_SEND_TIMEOUT = 10000; //ms, network confirmation of sent SMS
+constexpr static auto PENDING_MSG_SLOTS = 4; //SMS announced while GSM is busy, read afterwards
+constexpr static auto COMMAND_POLL_TIME = 10; //ms, step of blocking checkGsmOutput
+constexpr static auto BEGIN_ATTEMPTS = 8; //tries of one begin() command before giving up
+constexpr static auto BEGIN_BACKOFF_MIN = 250; //ms, pause after first failure, doubled with each next one
+constexpr static auto BEGIN_BACKOFF_MAX = 4000; //ms
 
-class GSM {
+/**
+ * @brief GSM driver logic shared by all buffer configurations.
+ * 
+ * Buffers are provided by BasicGSM, so the code is emitted only once
+ * no matter how many configurations are used in a sketch.
+ */
+class GSMBase {
   public:
+    typedef bool (*BaudHandler)(long baud, void* pContext);
 
-    #ifdef HW_SERIAL
-    GSM(long baud = DEFAULT_BAUD_RATE);
-    #endif
+    enum class BeginStatus : uint8_t {
+        OK,
+        OFFLINE,            // no answer to AT
+        CONFIG_FAILED,      // AT+CFUN=1 failed
+        TEXT_MODE_FAILED    // AT+CMGF=1 or AT+CSDH=1 failed
+    };
 
-    #if defined(RX) && defined(TX)
-    GSM(uint8_t rx = RX, uint8_t tx = TX, long baud = DEFAULT_BAUD_RATE);
-    #else
-    GSM(uint8_t rx, uint8_t tx, long baud = DEFAULT_BAUD_RATE);
-    #endif
-    GSM(Stream* pGsmSerial);
-    
-    void begin();
+    BeginStatus begin(bool warmStart = false);
     void checkGsmOutput();
+    bool poll();
+    bool isBusy();
+    unsigned long nextDeadline();
+    void setIdleCheckTime(unsigned long idleCheckTime);
+    void setBaudHandler(BaudHandler handler, void* pContext = nullptr);
+    void setTargetBaud(long baud);
+    long getBaud();
+    bool sendCommand(const char* cmd);
+    bool sendCommand(const AtCommandBase& cmd);
     bool isNewMsgAvailable();
     char* getMsg();
     char* getPhoneNum();
+    void setRateLimiter(RateLimiterBase* pRateLimiter);
+    void setSmsQueue(SmsQueueBase* pSmsQueue);
+    void setConcat(ConcatBase* pConcat);
+    void setHealthMonitor(ModemHealth* pHealth, unsigned long probeTime = HEALTH_PROBE_TIME);
+    bool sendSms(const char* pPhoneNum, const char* pText);
+    void setImmediateRead(bool immediateRead);
+
+    MemoryStats memoryStats();
+
+  protected:
+    #ifdef HW_SERIAL
+    GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, long baud);
+    #endif
+    #ifndef POSIX_SERIAL
+    GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, uint8_t rx, uint8_t tx, long baud);
+    #endif
+    GSMBase(char* pPhoneBuf, uint8_t phoneLength, uint16_t rxLength, uint16_t msgLength, Stream* pGsmSerial);
+    ~GSMBase();
 
   private:
-    class SerialHandler{
+    class SerialHandler : public MemoryAccounted<SerialHandler>{
       public:
-      SerialHandler(Stream* pGsmSerial);
+      SerialHandler(Stream* pGsmSerial, uint16_t rxLength, MemoryAccount* pMemory);
 
-      void serialWrite(const char* command);
-      void periodicSerialCheck(); //get num of received bytes
-      void feedbackSerialCheck();
+      void serialSend(const char* command);
+      void serialSendText(const char* text, char terminator);
+      bool settledSerialCheck(); //get num of received bytes
       char* getRxBufferP();
       bool isRxBufferAvailable();
       void setRxBufferAvailability(bool var);
-      void serialRead(uint8_t incomingBytes);
+      void serialRead(uint16_t incomingBytes);
 
       Stream* _pGsmSerial;
 
-      bool _periodicReading = true; //peridical serial monitor reading, can be used in timer or loop as well
       bool _rxBufferAvailable = false;
       unsigned long _lastReadTime = 0;
-      bool _periodicReadingFlag = true;
+      bool _rxPending = false; // bytes found, waiting RX_SETTLE_TIME before reading
+      bool _immediateRead = false; // stream publishes whole answers, no periodic check
 
       char* _rxBuffer = nullptr;
+      uint16_t _rxBufferSize = 0;
+      uint16_t _rxLength;
+      MemoryAccount* _pMemory;
     };
 
-    class ParserGSM{
+    class ParserGSM : public MemoryAccounted<ParserGSM>{
       public:
-        ParserGSM(SerialHandler* pSerialHandler, bool* newMsg, uint8_t* lastMsgIndex);
-        bool getResponse(const char* searchedChar);
-        bool identifyIncomingMsg(const char* command);
-        char* makeDynamicCmd(const char* command, uint8_t id);
+        ParserGSM(SerialHandler* pSerialHandler, bool* newMsg, uint16_t* lastMsgIndex,
+                  char* pPhoneBuf, uint8_t phoneLength, uint16_t msgLength, MemoryAccount* pMemory);
+        bool isResponseOk(const char* searchedChar);
+        uint8_t takeIncomingMsgIndexes(const char* command, uint16_t* pIndexes, uint8_t capacity);
         void getMsg();
+        bool addConcatPart(ConcatBase* pConcat);
         void getPhoneNumber();
         char* getPointMsgBuf();
         char* getPointPhoneBuf();
 
       private:
-        uint8_t GetIndex(char* buffer, char startSym);
+        uint16_t GetIndex(char* buffer, char startSym);
+        char* findHeader();
+        char* findBody(char* pHeader);
+        const char* findHeaderField(const char* pHeader, const char* pBody, uint8_t field);
+        static int8_t hexValue(char c);
+        static char gsmToAscii(uint8_t septet, bool escaped);
+
+        static constexpr const char* msgHeader = "+CMGR:";
+        static constexpr uint8_t udhIndicator = 0x40; // first octet of SMS with user data header
 
         SerialHandler* _pSerialHandler;
 
         bool* _pNewMsg;
         char* _pRxBuffer = nullptr;
         char* _msgBuffer = nullptr;
-        char* _cmdBuffer = nullptr;
-        char _phoneBuffer[PHONE_NUMBER_LENGTH];
-        uint8_t* _pLastMsgIndex;
+        char* _phoneBuffer;
+        uint8_t _phoneLength;
+        uint16_t _msgLength;
+        uint16_t* _pLastMsgIndex;
+        MemoryAccount* _pMemory;
     };
 
-    bool sendCommand(const char* cmd);
-    void deleteMsg();
-    void deleteMsgGsmStack();
+    enum class Task : uint8_t {
+        IDLE,
+        READ_SMS,
+        DELETE_SMS,
+        DELETE_STACK,
+        SEND_SMS,       // AT+CMGS written, waiting for prompt
+        SEND_SMS_BODY,  // text written, waiting for network confirmation
+        PROBE           // AT of health monitor written
+    };
+
+    enum class Response : uint8_t {
+        PENDING,
+        OK,
+        FAILED
+    };
+
+    bool sendWithBackoff(const char* cmd);
+    bool isInAnswer(const char* expected);
+    bool detectBaud();
+    void upgradeBaud();
+    bool switchBaud(long baud);
+    bool setLocalBaud(long baud);
+    #ifdef HW_SERIAL
+    static bool setHardwareBaud(long baud, void* pContext);
+    #endif
+    #if defined(SW_SERIAL) && !defined(ESP8266)
+    static bool setSoftwareBaud(long baud, void* pContext);
+    #endif
+    bool startCommand(const char* cmd);
+    bool startCommand(const AtCommandBase& cmd);
+    Response checkResponse(const char* expected = confirmFeedback);
+    Response checkSmsSent();
+    Response finishCommand(CommandResult result, unsigned long elapsed);
+    void startDelete(bool wholeStack);
+    void startPendingRead();
+    void startSmsSending();
+    bool takePendingMsgs();
+    void readMsg();
 
     static constexpr const char* confirmFeedback = "OK";
+    static constexpr const char* errorFeedback = "ERROR";
     static constexpr const char* basicCommand = "AT";
     static constexpr const char* pinCheck = "AT+CPIN?";
     static constexpr const char* checkSimCard = "AT+CPIN?";
     static constexpr const char* plainTextMode = "AT+CMGF=1";
+    static constexpr const char* headerValues = "AT+CSDH=1"; // first octet and coding of SMS shown by AT+CMGR
     static constexpr const char* gsmMode = "AT+CFUN=1";
-    static constexpr const char* smsReading = "AT+CMGR=";
-    static constexpr const char* deleteSms = "AT+CMGD=";
+    static constexpr const char* baudRateSetting = "AT+IPR";
+    static constexpr const char* stateQuery = "AT+CFUN?;+CMGF?";
+    static constexpr const char* gsmModeActive = "+CFUN: 1";
+    static constexpr const char* textModeActive = "+CMGF: 1";
+    static constexpr const char* smsReading = "AT+CMGR";
+    static constexpr const char* deleteSms = "AT+CMGD";
     static constexpr const char* incomingSms = "CMTI";
+    static constexpr const char* smsSending = "AT+CMGS";
+    static constexpr const char* smsPrompt = ">";
+    static constexpr const char* smsSent = "+CMGS:";
+    static constexpr const char* smsRefused = "\r\n+CMS ERROR"; // at line start, echo of the text can contain it
+    static constexpr const char* errorLine = "\r\nERROR";
+    static constexpr char smsEnd = 0x1A; // Ctrl+Z sends the text
+    static constexpr char smsCancel = 0x1B; // ESC leaves the prompt
 
+    MemoryAccount _memory; // parser, serial handler and their buffers
     ParserGSM* _pParser;
     SerialHandler* _pSerialHandler;
 
     char* _pMsgBuffer;
     char* _pPhoneBuffer;
-    uint8_t _lastMsgIndex = 0;
+    uint16_t _lastMsgIndex = 0;
+    uint16_t _pendingMsgIndex[PENDING_MSG_SLOTS] = {}; // SMS announced while a command was in progress
+    uint8_t _pendingMsgCount = 0;
+    uint32_t _reportedDepth = 0; // part of QUEUE_DEPTH added by this GSM
     uint8_t _pwrPin = 0;
+    RateLimiterBase* _pRateLimiter = nullptr;
+    SmsQueueBase* _pSmsQueue = nullptr;
+    ConcatBase* _pConcat = nullptr;
+    ModemHealth* _pHealth = nullptr;
+    unsigned long _probeTime = 0; // idle time after which AT is sent, 0 disables probing
+    AtType _cmdType = AtType::AT; // type of the last command for the health monitor
+    Task _task = Task::IDLE;
+    unsigned long _cmdStartTime = 0;
+    unsigned long _cmdTimeout = COMMAND_TIMEOUT;
+    unsigned long _idleCheckTime = PERIODIC_READ_TIME;
+    BaudHandler _baudHandler = nullptr;
+    void* _pBaudContext = nullptr;
+    long _baud = DEFAULT_BAUD_RATE;
+    long _targetBaud = 0; // 0 keeps the rate of constructor
 
     bool _newMsg = false; //if GSM recieve new message, it will be checked by timer
 };
 
+/**
+ * @brief GSM driver with compile-time buffer sizes.
+ * @tparam RX_LENGTH is maximum number of bytes taken from serial in one read.
+ * @tparam MSG_LEN is maximum length of received message.
+ * @tparam PHONE_LENGTH is size of phone number buffer including terminating null character.
+ * 
+ * Use the GSM alias for default sizes.
+ */
+template<uint16_t RX_LENGTH = RX_BUFFER, uint16_t MSG_LEN = MSG_LENGTH, uint8_t PHONE_LENGTH = PHONE_NUMBER_LENGTH>
+class BasicGSM : public GSMBase {
+    static_assert(RX_LENGTH >= MSG_LEN, "RX_LENGTH must be able to hold whole message");
+    static_assert(PHONE_LENGTH > 1, "PHONE_LENGTH must leave room for at least one character");
+
+  public:
+    #ifdef HW_SERIAL
+    BasicGSM(long baud = DEFAULT_BAUD_RATE)
+      : GSMBase(_phoneBuf, PHONE_LENGTH, RX_LENGTH, MSG_LEN, baud){}
+    #endif
+
+    #ifndef POSIX_SERIAL
+    #if defined(RX) && defined(TX)
+    BasicGSM(uint8_t rx = RX, uint8_t tx = TX, long baud = DEFAULT_BAUD_RATE)
+    #else
+    BasicGSM(uint8_t rx, uint8_t tx, long baud = DEFAULT_BAUD_RATE)
+    #endif
+      : GSMBase(_phoneBuf, PHONE_LENGTH, RX_LENGTH, MSG_LEN, rx, tx, baud){}
+    #endif
+
+    BasicGSM(Stream* pGsmSerial)
+      : GSMBase(_phoneBuf, PHONE_LENGTH, RX_LENGTH, MSG_LEN, pGsmSerial){}
+
+  private:
+    char _phoneBuf[PHONE_LENGTH];
+};
+
+using GSM = BasicGSM<>;
+
 #endif // ADEON_SIM_LIB_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ *  @file       atcommand.cpp
+ *  Project     AdeonGSM
+ *  @brief      Fixed-buffer builder of AT commands
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/atcommand.h"
+
+/**
+ * @brief Constructor for the class AtCommandBase.
+ * @param pBuffer is pointer to command buffer.
+ * @param size is size of command buffer.
+ * @param pPrefix is pointer to command without arguments, e.g. "AT+CMGR".
+ */
+AtCommandBase::AtCommandBase(char* pBuffer, uint8_t size, const char* pPrefix){
+    _pBuffer = pBuffer;
+    _size = size;
+    _pBuffer[0] = '\0';
+    append(pPrefix);
+}
+
+/**
+ * @brief Append number argument.
+ * @param value is number.
+ * @return Reference to this command.
+ */
+AtCommandBase& AtCommandBase::arg(long value){
+    separate();
+    unsigned long rest = (unsigned long)value;
+    if(value < 0){
+        append('-');
+        rest = 0UL - rest;
+    }
+    char digits[20];
+    uint8_t count = 0;
+    do{
+        digits[count++] = '0' + rest % 10;
+        rest /= 10;
+    }while(rest != 0);
+    while(count > 0){
+        append(digits[--count]);
+    }
+    return *this;
+}
+
+/**
+ * @brief Append string argument in quotes.
+ * @param pStr is pointer to string, e.g. phone number.
+ * @return Reference to this command.
+ */
+AtCommandBase& AtCommandBase::quoted(const char* pStr){
+    separate();
+    append('"');
+    append(pStr);
+    append('"');
+    return *this;
+}
+
+/**
+ * @brief Get command text.
+ * @return Pointer to null terminated command.
+ */
+const char* AtCommandBase::c_str() const{
+    return _pBuffer;
+}
+
+/**
+ * @brief Get length of command text.
+ * @return Number of characters.
+ */
+uint8_t AtCommandBase::length() const{
+    return _length;
+}
+
+/**
+ * @brief Check that the whole command fits into buffer.
+ * @return <code>true</code> if command is complete, <code>false</code> if it is too long.
+ */
+bool AtCommandBase::isValid() const{
+    return !_overflow;
+}
+
+/**
+ * @brief Append '=' before first argument and ',' before next ones.
+ */
+void AtCommandBase::separate(){
+    append(_hasArg ? ',' : '=');
+    _hasArg = true;
+}
+
+void AtCommandBase::append(char c){
+    if(_length + 1 >= _size){
+        _overflow = true;
+        return;
+    }
+    _pBuffer[_length++] = c;
+    _pBuffer[_length] = '\0';
+}
+
+void AtCommandBase::append(const char* pStr){
+    if(pStr == nullptr){
+        return;
+    }
+    while(*pStr != '\0'){
+        append(*pStr++);
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ *  @file       atcommand.h
+ *  Project     AdeonGSM
+ *  @brief      Fixed-buffer builder of AT commands
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_AT_COMMAND_H
+#define ADEON_AT_COMMAND_H
+
+#include <Arduino.h>
+
+constexpr static auto AT_COMMAND_LENGTH = 32;
+
+/**
+ * @brief AT command built in a fixed buffer.
+ * 
+ * Prefix is followed by arguments, first one after '=', next ones after ','.
+ * Numbers are formatted without sprintf and nothing is allocated on heap.
+ * Too long command is marked invalid instead of being cut.
+ * 
+ *     AtCommand("AT+CMGD").arg(1).arg(4)           // AT+CMGD=1,4
+ *     AtCommand("AT+CMGS").quoted("+420123456789") // AT+CMGS="+420123456789"
+ */
+class AtCommandBase {
+    public:
+        AtCommandBase& arg(long value);
+        AtCommandBase& quoted(const char* pStr);
+        const char* c_str() const;
+        uint8_t length() const;
+        bool isValid() const;
+
+    protected:
+        AtCommandBase(char* pBuffer, uint8_t size, const char* pPrefix);
+
+    private:
+        AtCommandBase(const AtCommandBase&) = delete;
+        AtCommandBase& operator=(const AtCommandBase&) = delete;
+
+        void separate();
+        void append(char c);
+        void append(const char* pStr);
+
+        char* _pBuffer;
+        uint8_t _size;
+        uint8_t _length = 0;
+        bool _hasArg = false;
+        bool _overflow = false;
+};
+
+/**
+ * @brief AT command with compile-time buffer size.
+ * @tparam SIZE is size of buffer including terminating null character.
+ * 
+ * Use the AtCommand alias for default size.
+ */
+template<uint8_t SIZE = AT_COMMAND_LENGTH>
+class BasicAtCommand : public AtCommandBase {
+    static_assert(SIZE > 2, "SIZE must leave room for AT");
+
+    public:
+        explicit BasicAtCommand(const char* pPrefix) : AtCommandBase(_buffer, SIZE, pPrefix){}
+
+    private:
+        char _buffer[SIZE];
+};
+
+using AtCommand = BasicAtCommand<>;
+
+#endif // ADEON_AT_COMMAND_H
@@ -0,0 +1,240 @@
+/**
+ *  @file       auditlog.cpp
+ *  Project     AdeonGSM
+ *  @brief      Ring log of applied commands
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/auditlog.h"
+
+/**
+ * @brief Constructor for the class AuditLogBase.
+ * @param pRecords is pointer to records.
+ * @param capacity is number of records.
+ */
+AuditLogBase::AuditLogBase(AuditRecord* pRecords, uint16_t capacity){
+    _pRecords = pRecords;
+    _capacity = capacity;
+}
+
+/**
+ * @brief Add record, the oldest one is replaced if the log is full.
+ * @param senderKey is key of sender phone number, see makeStrKey().
+ * @param param is index of parameter (AUDIT_NO_PARAM if the record is not related to one).
+ * @param oldVal is value before the command.
+ * @param newVal is value requested by the command.
+ * @param result is outcome of the command.
+ */
+void AuditLogBase::append(uint32_t senderKey, uint8_t param, uint16_t oldVal, uint16_t newVal, AuditResult result){
+    AuditRecord* pRecord = &_pRecords[_next];
+    pRecord->senderKey = senderKey;
+    pRecord->time = _clockFn();
+    pRecord->oldVal = oldVal;
+    pRecord->newVal = newVal;
+    pRecord->param = param;
+    pRecord->result = result;
+
+    _next = (_next + 1 < _capacity) ? _next + 1 : 0;
+    if(_count < _capacity){
+        _count++;
+    }
+    else{
+        _stats.overwritten++;
+    }
+    _stats.appended++;
+}
+
+/**
+ * @brief Get number of kept records.
+ */
+uint16_t AuditLogBase::getCount(){
+    return _count;
+}
+
+/**
+ * @brief Get kept record.
+ * @param index is position of record, 0 is the oldest one.
+ * @param pRecord is pointer where record is copied.
+ * @return <code>true</code> if record exists, <code>false</code> otherwise.
+ */
+bool AuditLogBase::getRecord(uint16_t index, AuditRecord* pRecord){
+    if(index >= _count){
+        return false;
+    }
+    uint16_t position = (_next + _capacity - _count + index) % _capacity;
+    *pRecord = _pRecords[position];
+    return true;
+}
+
+/**
+ * @brief Print records as CSV from the oldest one.
+ * @param out is reference to output, e.g. Serial.
+ *
+ * Line "time,sender,param,old,new,result" is followed by a line for each record,
+ * sender is hexadecimal key and param is empty for AUDIT_NO_PARAM.
+ */
+void AuditLogBase::dumpCsv(Print& out){
+    AuditRecord record;
+    out.println(F("time,sender,param,old,new,result"));
+    for(uint16_t i = 0; getRecord(i, &record); i++){
+        out.print((unsigned long)record.time);
+        out.print(',');
+        out.print((unsigned long)record.senderKey, 16);
+        out.print(',');
+        if(record.param != AUDIT_NO_PARAM){
+            out.print(record.param);
+        }
+        out.print(',');
+        out.print(record.oldVal);
+        out.print(',');
+        out.print(record.newVal);
+        out.print(',');
+        out.println(resultName(record.result));
+    }
+}
+
+/**
+ * @brief Write records in binary form from the oldest one, it can be read by restore().
+ * @param out is reference to output, e.g. a file.
+ */
+void AuditLogBase::dumpBinary(Print& out){
+    AuditRecord record;
+    out.write('A');
+    out.write('L');
+    out.write(binaryVersion);
+    writeNumber(out, _count, 2);
+    for(uint16_t i = 0; getRecord(i, &record); i++){
+        writeNumber(out, record.senderKey, 4);
+        writeNumber(out, record.time, 4);
+        writeNumber(out, record.oldVal, 2);
+        writeNumber(out, record.newVal, 2);
+        out.write(record.param);
+        out.write((uint8_t)record.result);
+    }
+}
+
+/**
+ * @brief Append records written by dumpBinary(), e.g. after reset of the board.
+ * @param in is reference to input.
+ * @return Number of restored records, 0 if input does not start with binary dump.
+ *
+ * Restored records keep their time, reading stops at the end of input.
+ */
+uint16_t AuditLogBase::restore(Stream& in){
+    uint8_t header[3];
+    uint32_t count;
+    if(in.readBytes((char*)header, sizeof(header)) != sizeof(header) || header[0] != 'A' || header[1] != 'L'
+       || header[2] != binaryVersion || !readNumber(in, &count, 2)){
+        return 0;
+    }
+    uint16_t restored = 0;
+    for(; restored < count; restored++){
+        uint32_t senderKey, time, oldVal, newVal, param, result;
+        if(!readNumber(in, &senderKey, 4) || !readNumber(in, &time, 4) || !readNumber(in, &oldVal, 2)
+           || !readNumber(in, &newVal, 2) || !readNumber(in, &param, 1) || !readNumber(in, &result, 1)){
+            break;
+        }
+        append(senderKey, (uint8_t)param, (uint16_t)oldVal, (uint16_t)newVal, (AuditResult)result);
+        _pRecords[(_next + _capacity - 1) % _capacity].time = time;
+    }
+    return restored;
+}
+
+/**
+ * @brief Replace time source of records.
+ * @param clockFn is pointer to function returning time (millis by default), e.g. seconds of RTC.
+ */
+void AuditLogBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+}
+
+/**
+ * @brief Drop all records. Counters are kept.
+ */
+void AuditLogBase::reset(){
+    _next = 0;
+    _count = 0;
+}
+
+/**
+ * @brief Get counters of the log.
+ * @return Copy of counters.
+ */
+AuditStats AuditLogBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Get name of result used in CSV dump.
+ * @param result is outcome of a command.
+ * @return Pointer to name constant string.
+ */
+const char* AuditLogBase::resultName(AuditResult result){
+    switch(result){
+    case AuditResult::APPLIED:
+        return "applied";
+    case AuditResult::SCHEDULED:
+        return "scheduled";
+    case AuditResult::TIMED:
+        return "timed";
+    case AuditResult::DENIED:
+        return "denied";
+    case AuditResult::UNKNOWN:
+        return "unknown";
+    case AuditResult::REJECTED:
+        return "rejected";
+    case AuditResult::GROUPS:
+        return "groups";
+    case AuditResult::INVALID:
+        return "invalid";
+    }
+    return "?";
+}
+
+/**
+ * @brief Write little-endian number.
+ * @param out is reference to output.
+ * @param val is number.
+ * @param bytes is number of written bytes.
+ */
+void AuditLogBase::writeNumber(Print& out, uint32_t val, uint8_t bytes){
+    for(uint8_t i = 0; i < bytes; i++){
+        out.write((uint8_t)(val >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Read little-endian number.
+ * @param in is reference to input.
+ * @param pVal is pointer where number is saved.
+ * @param bytes is number of read bytes.
+ * @return <code>true</code> if all bytes have been read, <code>false</code> otherwise.
+ */
+bool AuditLogBase::readNumber(Stream& in, uint32_t* pVal, uint8_t bytes){
+    uint8_t buf[4];
+    if(in.readBytes((char*)buf, bytes) != bytes){
+        return false;
+    }
+    *pVal = 0;
+    for(uint8_t i = 0; i < bytes; i++){
+        *pVal |= (uint32_t)buf[i] << (8 * i);
+    }
+    return true;
+}
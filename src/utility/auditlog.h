@@ -0,0 +1,130 @@
+/**
+ *  @file       auditlog.h
+ *  Project     AdeonGSM
+ *  @brief      Ring log of applied commands
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_AUDITLOG_H
+#define ADEON_AUDITLOG_H
+
+#include <Arduino.h>
+#include "utility/strkey.h"
+
+constexpr static uint8_t AUDIT_NO_PARAM = 0xFF; // record is not related to one parameter
+constexpr static auto AUDIT_RECORD_SIZE = 14;   // bytes of record in binary dump
+
+/**
+ * @brief Outcome of a logged command.
+ */
+enum class AuditResult : uint8_t {
+    APPLIED,   // value has been set
+    SCHEDULED, // value is set later by timer wheel
+    TIMED,     // value has been set by timer wheel
+    DENIED,    // sender has no access to parameter
+    UNKNOWN,   // parameter is not in Adeon
+    REJECTED,  // timed edit has not been scheduled
+    GROUPS,    // admin has set groups of a user or parameter
+    INVALID    // message has wrong hash or format, or it is repeated
+};
+
+/**
+ * @brief One logged command.
+ */
+struct AuditRecord {
+    uint32_t senderKey = 0; // makeStrKey() of phone number, 0 for timer wheel
+    uint32_t time = 0;      // clock of the log when the record has been added
+    uint16_t oldVal = 0;
+    uint16_t newVal = 0;
+    uint8_t param = AUDIT_NO_PARAM; // index of parameter in order of adding
+    AuditResult result = AuditResult::APPLIED;
+};
+
+/**
+ * @brief Counters of the log.
+ */
+struct AuditStats {
+    uint32_t appended = 0;    // records added
+    uint32_t overwritten = 0; // oldest records replaced in full log
+};
+
+/**
+ * @brief Audit log logic shared by all capacities.
+ *
+ * Records are kept in a preallocated ring, full log replaces the oldest record.
+ * append() only copies the record, so it can be called while a message is applied.
+ * Dumps and restore() are meant for the sketch, e.g. to send the log or keep it
+ * in a file or EEPROM. Binary dump is "AL", version byte, 16-bit count and records
+ * of AUDIT_RECORD_SIZE bytes, all numbers little-endian.
+ */
+class AuditLogBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        void append(uint32_t senderKey, uint8_t param, uint16_t oldVal, uint16_t newVal, AuditResult result);
+        uint16_t getCount();
+        bool getRecord(uint16_t index, AuditRecord* pRecord);
+        void dumpCsv(Print& out);
+        void dumpBinary(Print& out);
+        uint16_t restore(Stream& in);
+        void setClock(ClockFn clockFn);
+        void reset();
+        AuditStats getStats();
+
+        static const char* resultName(AuditResult result);
+
+    protected:
+        AuditLogBase(AuditRecord* pRecords, uint16_t capacity);
+
+    private:
+        static constexpr uint8_t binaryVersion = 1;
+
+        void writeNumber(Print& out, uint32_t val, uint8_t bytes);
+        bool readNumber(Stream& in, uint32_t* pVal, uint8_t bytes);
+
+        AuditRecord* _pRecords;
+        uint16_t _capacity;
+        uint16_t _next = 0; // position of the next record
+        uint16_t _count = 0;
+
+        ClockFn _clockFn = millis;
+        AuditStats _stats;
+};
+
+/**
+ * @brief Audit log with compile-time capacity.
+ * @tparam RECORDS is number of kept records.
+ *
+ * Use the AuditLog alias for default capacity.
+ */
+template<uint16_t RECORDS = 16>
+class BasicAuditLog : public AuditLogBase {
+    static_assert(RECORDS > 0, "RECORDS must be at least 1");
+
+    public:
+        BasicAuditLog() : AuditLogBase(_records, RECORDS){}
+
+    private:
+        AuditRecord _records[RECORDS];
+};
+
+using AuditLog = BasicAuditLog<>;
+
+#endif // ADEON_AUDITLOG_H
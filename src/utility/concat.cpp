@@ -0,0 +1,261 @@
+/**
+ *  @file       concat.cpp
+ *  Project     AdeonGSM
+ *  @brief      Reassembly of concatenated SMS
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/concat.h"
+
+/**
+ * @brief Constructor for the class ConcatBase.
+ * @param pSets is pointer to table of messages.
+ * @param pBuffers is pointer to text storage, length + 1 bytes for each message.
+ * @param numOfSets is number of entries in table of messages.
+ * @param length is maximum length of whole message.
+ */
+ConcatBase::ConcatBase(ConcatSet* pSets, char* pBuffers, uint8_t numOfSets, uint16_t length){
+    _pSets = pSets;
+    _pBuffers = pBuffers;
+    _numOfSets = numOfSets;
+    _length = length;
+}
+
+/**
+ * @brief Add part of concatenated SMS.
+ * @param pPhoneNum is pointer to phone number string of sender.
+ * @param ref is reference number of the message from user data header.
+ * @param seq is sequence number of the part, starting at 1.
+ * @param total is number of parts of the message.
+ * @param pText is pointer to text of the part.
+ * @return <code>true</code> if message is complete, see getMsg(), <code>false</code> otherwise.
+ * 
+ * Message completed by previous call is released here.
+ */
+bool ConcatBase::add(const char* pPhoneNum, uint16_t ref, uint8_t seq, uint8_t total, const char* pText){
+    unsigned long now = _clockFn();
+    if(_pComplete != nullptr){
+        _pComplete->used = false;
+        _pComplete = nullptr;
+    }
+    expire(now);
+    _stats.parts++;
+
+    size_t length = (pText == nullptr) ? 0 : strlen(pText);
+    if(total == 0 || total > CONCAT_MAX_PARTS || seq == 0 || seq > total || length > 255){
+        _stats.rejected++;
+        return false;
+    }
+    ConcatSet* pSet = findSet(makeStrKey(pPhoneNum), ref, total, now);
+    uint8_t bit = 1 << (seq - 1);
+    if((pSet->received & bit) != 0){
+        _stats.rejected++;
+        return false;
+    }
+    if(pSet->length + length > _length){
+        //message can not be completed
+        _stats.rejected++;
+        pSet->used = false;
+        return false;
+    }
+
+    //parts are kept in order
+    char* pBuf = getBuffer(pSet);
+    uint16_t offset = getOffset(pSet, seq);
+    memmove(pBuf + offset + length, pBuf + offset, pSet->length - offset);
+    memcpy(pBuf + offset, pText, length);
+    pSet->length += length;
+    pSet->partLength[seq - 1] = length;
+    pSet->received |= bit;
+    hashReadyParts(pSet);
+
+    if(pSet->hashed != pSet->total){
+        return false;
+    }
+    pBuf[pSet->length] = '\0';
+    MD5::MD5Final(_digest, &pSet->context);
+    _pComplete = pSet;
+    _stats.completed++;
+    return true;
+}
+
+/**
+ * @brief Get message completed by the last add().
+ * @return Pointer to whole text, null if the last part did not complete a message.
+ */
+char* ConcatBase::getMsg(){
+    return (_pComplete == nullptr) ? nullptr : getBuffer(_pComplete);
+}
+
+/**
+ * @brief Get MD5 of the completed message.
+ * @return Pointer to 16 bytes of MD5 of text after "hash: ", null if there is no completed message.
+ */
+const unsigned char* ConcatBase::getDigest(){
+    return (_pComplete == nullptr) ? nullptr : _digest;
+}
+
+/**
+ * @brief Set time in which all parts have to come.
+ * @param timeoutMs is time in ms from the first received part.
+ */
+void ConcatBase::setTimeout(unsigned long timeoutMs){
+    _timeoutMs = timeoutMs;
+}
+
+/**
+ * @brief Replace time source.
+ * @param clockFn is pointer to function returning time in ms (millis by default).
+ */
+void ConcatBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+}
+
+/**
+ * @brief Drop all messages. Counters are kept.
+ */
+void ConcatBase::reset(){
+    for(uint8_t i = 0; i < _numOfSets; i++){
+        _pSets[i].used = false;
+    }
+    _pComplete = nullptr;
+}
+
+/**
+ * @brief Get counters of reassembly.
+ * @return Copy of counters.
+ */
+ConcatStats ConcatBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Find message of the part or start a new one.
+ * @param senderKey is hash of phone number.
+ * @param ref is reference number of the message.
+ * @param total is number of parts of the message.
+ * @param now is current time in ms.
+ * @return Pointer to message.
+ * 
+ * If table is full, the oldest incomplete message is replaced.
+ */
+ConcatSet* ConcatBase::findSet(uint32_t senderKey, uint16_t ref, uint8_t total, unsigned long now){
+    ConcatSet* pFree = nullptr;
+    ConcatSet* pOldest = &_pSets[0];
+    for(uint8_t i = 0; i < _numOfSets; i++){
+        ConcatSet* pSet = &_pSets[i];
+        if(!pSet->used){
+            if(pFree == nullptr){
+                pFree = pSet;
+            }
+            continue;
+        }
+        if(pSet->senderKey == senderKey && pSet->ref == ref){
+            if(pSet->total != total){
+                //reference is reused for other message
+                startSet(pSet, senderKey, ref, total, now);
+            }
+            return pSet;
+        }
+        if((now - pSet->startTime) > (now - pOldest->startTime)){
+            pOldest = pSet;
+        }
+    }
+    if(pFree == nullptr){
+        pFree = pOldest;
+        _stats.evicted++;
+    }
+    startSet(pFree, senderKey, ref, total, now);
+    return pFree;
+}
+
+/**
+ * @brief Initialise message.
+ */
+void ConcatBase::startSet(ConcatSet* pSet, uint32_t senderKey, uint16_t ref, uint8_t total, unsigned long now){
+    pSet->used = true;
+    pSet->senderKey = senderKey;
+    pSet->ref = ref;
+    pSet->total = total;
+    pSet->startTime = now;
+    pSet->length = 0;
+    pSet->received = 0;
+    pSet->hashed = 0;
+    memset(pSet->partLength, 0, sizeof(pSet->partLength));
+    MD5::MD5Init(&pSet->context);
+}
+
+/**
+ * @brief Pass parts which follow the hashed ones to MD5.
+ * @param pSet is pointer to message.
+ * 
+ * Short hash and gap at the beginning of the first part are skipped,
+ * as Adeon hashes the text after them.
+ */
+void ConcatBase::hashReadyParts(ConcatSet* pSet){
+    while(pSet->hashed < pSet->total && (pSet->received & (1 << pSet->hashed)) != 0){
+        const char* pPart = getBuffer(pSet) + getOffset(pSet, pSet->hashed + 1);
+        size_t length = pSet->partLength[pSet->hashed];
+        if(pSet->hashed == 0){
+            const char* pColon = (const char*)memchr(pPart, ':', length);
+            size_t skip = (pColon == nullptr) ? length : (size_t)(pColon - pPart) + 2;
+            skip = (skip > length) ? length : skip;
+            pPart += skip;
+            length -= skip;
+        }
+        MD5::MD5Update(&pSet->context, pPart, length);
+        pSet->hashed++;
+    }
+}
+
+/**
+ * @brief Get position of part in text of message.
+ * @param pSet is pointer to message.
+ * @param seq is sequence number of the part.
+ * @return Offset of the part, missing parts have zero length.
+ */
+uint16_t ConcatBase::getOffset(ConcatSet* pSet, uint8_t seq){
+    uint16_t offset = 0;
+    for(uint8_t i = 0; i + 1 < seq; i++){
+        offset += pSet->partLength[i];
+    }
+    return offset;
+}
+
+/**
+ * @brief Get text buffer of message.
+ */
+char* ConcatBase::getBuffer(ConcatSet* pSet){
+    return _pBuffers + (pSet - _pSets) * (_length + 1);
+}
+
+/**
+ * @brief Drop incomplete messages older than timeout.
+ * @param now is current time in ms.
+ */
+void ConcatBase::expire(unsigned long now){
+    for(uint8_t i = 0; i < _numOfSets; i++){
+        ConcatSet* pSet = &_pSets[i];
+        if(pSet->used && (now - pSet->startTime) >= _timeoutMs){
+            pSet->used = false;
+            _stats.timedOut++;
+        }
+    }
+}
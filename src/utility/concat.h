@@ -0,0 +1,128 @@
+/**
+ *  @file       concat.h
+ *  Project     AdeonGSM
+ *  @brief      Reassembly of concatenated SMS
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_CONCAT_H
+#define ADEON_CONCAT_H
+
+#include <Arduino.h>
+#include "utility/MD5.h"
+#include "utility/strkey.h"
+
+constexpr static auto CONCAT_MAX_PARTS = 8;
+constexpr static auto CONCAT_LENGTH = 459; // three parts of GSM 7-bit text
+constexpr static auto CONCAT_TIMEOUT = 60000; //ms, incomplete message is dropped
+
+/**
+ * @brief Counters of reassembly.
+ */
+struct ConcatStats {
+    uint32_t parts = 0;     // parts passed to add()
+    uint32_t completed = 0; // whole messages
+    uint32_t timedOut = 0;  // incomplete messages dropped after timeout
+    uint32_t rejected = 0;  // invalid, repeated or too long parts
+    uint32_t evicted = 0;   // incomplete messages replaced by a new one
+};
+
+/**
+ * @brief Message being reassembled, its text is kept by the assembler.
+ */
+struct ConcatSet {
+    MD5_CTX context;
+    uint32_t senderKey = 0;
+    unsigned long startTime = 0;
+    uint16_t ref = 0;
+    uint16_t length = 0;
+    uint8_t partLength[CONCAT_MAX_PARTS] = {};
+    uint8_t total = 0;
+    uint8_t received = 0; // bit for each part
+    uint8_t hashed = 0;   // parts passed to MD5, they are hashed in order
+    bool used = false;
+};
+
+/**
+ * @brief Reassembly logic shared by all assembler sizes.
+ * 
+ * Parts are identified by sender and reference number of the user data header and
+ * kept in order in a fixed buffer. MD5 of Adeon message (text after "hash: ") is
+ * updated as soon as parts follow each other, so the whole message is not hashed again.
+ * Incomplete message is dropped after timeout or when a new message needs its buffer.
+ */
+class ConcatBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        bool add(const char* pPhoneNum, uint16_t ref, uint8_t seq, uint8_t total, const char* pText);
+        char* getMsg();
+        const unsigned char* getDigest();
+        void setTimeout(unsigned long timeoutMs);
+        void setClock(ClockFn clockFn);
+        void reset();
+        ConcatStats getStats();
+
+    protected:
+        ConcatBase(ConcatSet* pSets, char* pBuffers, uint8_t numOfSets, uint16_t length);
+
+    private:
+        ConcatSet* findSet(uint32_t senderKey, uint16_t ref, uint8_t total, unsigned long now);
+        void startSet(ConcatSet* pSet, uint32_t senderKey, uint16_t ref, uint8_t total, unsigned long now);
+        void hashReadyParts(ConcatSet* pSet);
+        uint16_t getOffset(ConcatSet* pSet, uint8_t seq);
+        char* getBuffer(ConcatSet* pSet);
+        void expire(unsigned long now);
+
+        ConcatSet* _pSets;
+        char* _pBuffers;
+        uint8_t _numOfSets;
+        uint16_t _length;
+        ConcatSet* _pComplete = nullptr; // kept until the next add()
+        unsigned char _digest[16];
+        unsigned long _timeoutMs = CONCAT_TIMEOUT;
+
+        ClockFn _clockFn = millis;
+        ConcatStats _stats;
+};
+
+/**
+ * @brief Assembler with compile-time size.
+ * @tparam SETS is number of messages reassembled at the same time.
+ * @tparam LENGTH is maximum length of whole message.
+ * 
+ * Use the Concat alias for default size.
+ */
+template<uint8_t SETS = 1, uint16_t LENGTH = CONCAT_LENGTH>
+class BasicConcat : public ConcatBase {
+    static_assert(SETS > 0, "SETS must be at least 1");
+    static_assert(LENGTH > 0, "LENGTH must be at least 1");
+
+    public:
+        BasicConcat() : ConcatBase(_sets, _buffers, SETS, LENGTH){}
+
+    private:
+        ConcatSet _sets[SETS];
+        char _buffers[SETS * (LENGTH + 1)];
+};
+
+using Concat = BasicConcat<>;
+
+#endif // ADEON_CONCAT_H
@@ -0,0 +1,133 @@
+/**
+ *  @file       dedup.cpp
+ *  Project     AdeonGSM
+ *  @brief      Suppression of duplicate messages
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/dedup.h"
+
+/**
+ * @brief Constructor for the class DuplicateFilterBase.
+ * @param pEntries is pointer to cache entries.
+ * @param numOfEntries is number of cache entries.
+ */
+DuplicateFilterBase::DuplicateFilterBase(DuplicateEntry* pEntries, uint8_t numOfEntries){
+    _pEntries = pEntries;
+    _numOfEntries = numOfEntries;
+}
+
+/**
+ * @brief Check if message has been accepted recently.
+ * @param pSender is pointer to phone number of sender (null if sender is unknown).
+ * @param pShortHash is pointer to short hash of message.
+ * @return <code>true</code> if message is duplicate, <code>false</code> otherwise.
+ */
+bool DuplicateFilterBase::isDuplicate(const char* pSender, const char* pShortHash){
+    DuplicateEntry* pEntry = findEntry(makeStrKey(pSender), makeStrKey(pShortHash));
+    if(pEntry != nullptr && (_clockFn() - pEntry->time) < _windowMs){
+        _stats.hits++;
+        return true;
+    }
+    _stats.misses++;
+    return false;
+}
+
+/**
+ * @brief Remember accepted message.
+ * @param pSender is pointer to phone number of sender (null if sender is unknown).
+ * @param pShortHash is pointer to short hash of message.
+ */
+void DuplicateFilterBase::record(const char* pSender, const char* pShortHash){
+    uint32_t senderKey = makeStrKey(pSender);
+    uint32_t hashKey = makeStrKey(pShortHash);
+    unsigned long now = _clockFn();
+
+    DuplicateEntry* pEntry = findEntry(senderKey, hashKey);
+    if(pEntry == nullptr){
+        DuplicateEntry* pOldest = nullptr;
+        for(uint8_t i = 0; i < _numOfEntries; i++){
+            if(!_pEntries[i].used){
+                pEntry = &_pEntries[i];
+                break;
+            }
+            if(pOldest == nullptr || (now - _pEntries[i].time) > (now - pOldest->time)){
+                pOldest = &_pEntries[i];
+            }
+        }
+        if(pEntry == nullptr){
+            pEntry = pOldest;
+            _stats.evictions++;
+        }
+    }
+    pEntry->used = true;
+    pEntry->senderKey = senderKey;
+    pEntry->hashKey = hashKey;
+    pEntry->time = now;
+}
+
+/**
+ * @brief Set time in which repeated message is rejected.
+ * @param windowMs is time in ms from acceptance of the original message.
+ */
+void DuplicateFilterBase::setWindow(unsigned long windowMs){
+    _windowMs = windowMs;
+}
+
+/**
+ * @brief Replace time source.
+ * @param clockFn is pointer to function returning time in ms (millis by default).
+ */
+void DuplicateFilterBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+}
+
+/**
+ * @brief Forget all messages. Counters are kept.
+ */
+void DuplicateFilterBase::reset(){
+    for(uint8_t i = 0; i < _numOfEntries; i++){
+        _pEntries[i].used = false;
+    }
+}
+
+/**
+ * @brief Get counters of cache lookups.
+ * @return Copy of counters.
+ */
+DuplicateStats DuplicateFilterBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Find entry of message.
+ * @param senderKey is key of sender phone number.
+ * @param hashKey is key of short hash.
+ * @return Pointer to entry (null if message is not in cache).
+ */
+DuplicateEntry* DuplicateFilterBase::findEntry(uint32_t senderKey, uint32_t hashKey){
+    for(uint8_t i = 0; i < _numOfEntries; i++){
+        DuplicateEntry* pEntry = &_pEntries[i];
+        if(pEntry->used && pEntry->senderKey == senderKey && pEntry->hashKey == hashKey){
+            return pEntry;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,102 @@
+/**
+ *  @file       dedup.h
+ *  Project     AdeonGSM
+ *  @brief      Suppression of duplicate messages
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_DEDUP_H
+#define ADEON_DEDUP_H
+
+#include <Arduino.h>
+#include "utility/strkey.h"
+
+/**
+ * @brief Counters of duplicate filter lookups.
+ */
+struct DuplicateStats {
+    uint32_t hits = 0;      // messages rejected as duplicates
+    uint32_t misses = 0;    // messages not found in cache
+    uint32_t evictions = 0; // entries replaced in full cache
+};
+
+/**
+ * @brief Recently accepted message, identified by sender and short hash.
+ */
+struct DuplicateEntry {
+    uint32_t senderKey = 0;
+    uint32_t hashKey = 0;
+    unsigned long time = 0;
+    bool used = false;
+};
+
+/**
+ * @brief Duplicate filter logic shared by all cache sizes.
+ * 
+ * Message is duplicate if the same sender has sent message with the same short hash
+ * within the window. Only messages with verified hash are recorded, so forged
+ * messages can not suppress valid ones. If cache is full, the entry accepted first is
+ * replaced (FIFO). A hit does not refresh the entry, so repeated copies can not extend the window.
+ */
+class DuplicateFilterBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        bool isDuplicate(const char* pSender, const char* pShortHash);
+        void record(const char* pSender, const char* pShortHash);
+        void setWindow(unsigned long windowMs);
+        void setClock(ClockFn clockFn);
+        void reset();
+        DuplicateStats getStats();
+
+    protected:
+        DuplicateFilterBase(DuplicateEntry* pEntries, uint8_t numOfEntries);
+
+    private:
+        DuplicateEntry* findEntry(uint32_t senderKey, uint32_t hashKey);
+
+        DuplicateEntry* _pEntries;
+        uint8_t _numOfEntries;
+        unsigned long _windowMs = 60000;
+
+        ClockFn _clockFn = millis;
+        DuplicateStats _stats;
+};
+
+/**
+ * @brief Duplicate filter with compile-time cache size.
+ * @tparam ENTRIES is number of remembered messages.
+ * 
+ * Use the DuplicateFilter alias for default size. Default window is one minute.
+ */
+template<uint8_t ENTRIES = 4>
+class BasicDuplicateFilter : public DuplicateFilterBase {
+    static_assert(ENTRIES > 0, "ENTRIES must be at least 1");
+
+    public:
+        BasicDuplicateFilter() : DuplicateFilterBase(_entries, ENTRIES){}
+
+    private:
+        DuplicateEntry _entries[ENTRIES];
+};
+
+using DuplicateFilter = BasicDuplicateFilter<>;
+
+#endif // ADEON_DEDUP_H
@@ -0,0 +1,186 @@
+/**
+ *  @file       gsmpool.cpp
+ *  Project     AdeonGSM
+ *  @brief      Scheduler of many GSM modems
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/gsmpool.h"
+
+/**
+ * @brief Constructor for the class GsmPoolBase.
+ * @param pModems is pointer to modem table.
+ * @param capacity is number of entries in modem table.
+ */
+GsmPoolBase::GsmPoolBase(Modem* pModems, uint8_t capacity){
+    _pModems = pModems;
+    _capacity = capacity;
+}
+
+/**
+ * @brief Add modem to the pool.
+ * @param pGsm is pointer to GSM object, begin() should be already done.
+ * @param pAdeon is pointer to Adeon which processes messages of the modem (can be null).
+ * @return <code>true</code> if modem is added, <code>false</code> if pool is full or workers are running.
+ */
+bool GsmPoolBase::add(GSMBase* pGsm, AdeonBase* pAdeon){
+    #ifdef GSM_POOL_THREADS
+    if(_running){
+        return false;
+    }
+    #endif
+    if(pGsm == nullptr || _numOfModems >= _capacity){
+        return false;
+    }
+    _pModems[_numOfModems].pGsm = pGsm;
+    _pModems[_numOfModems].pAdeon = pAdeon;
+    _numOfModems++;
+    return true;
+}
+
+/**
+ * @brief Get number of modems in the pool.
+ * @return _numOfModems
+ */
+uint8_t GsmPoolBase::getNumOfModems(){
+    return _numOfModems;
+}
+
+/**
+ * @brief Set function which is called for every new message.
+ * @param handler is pointer to function (null disables it).
+ * @param pContext is pointer passed to the function.
+ */
+void GsmPoolBase::setMsgHandler(MsgHandler handler, void* pContext){
+    _handler = handler;
+    _pContext = pContext;
+}
+
+/**
+ * @brief Make one non-blocking step of every modem.
+ * @return <code>true</code> if any modem waits for answer, <code>false</code> if all are idle.
+ * 
+ * Call it from the loop when workers are not running.
+ */
+bool GsmPoolBase::poll(){
+    bool busy = false;
+    for(uint8_t i = 0; i < _numOfModems; i++){
+        busy |= serve(i);
+    }
+    return busy;
+}
+
+/**
+ * @brief Get number of messages received by all modems.
+ * @return _msgCount
+ */
+uint32_t GsmPoolBase::getNumOfMsgs(){
+    return _msgCount;
+}
+
+/**
+ * @brief Make one step of modem and pass new message.
+ * @param index is index of modem in the pool.
+ * @return <code>true</code> if modem waits for answer, <code>false</code> otherwise.
+ */
+bool GsmPoolBase::serve(uint8_t index){
+    bool busy = _pModems[index].pGsm->poll();
+    if(_pModems[index].pGsm->isNewMsgAvailable()){
+        #ifdef GSM_POOL_THREADS
+        std::lock_guard<std::mutex> guard(_dispatchLock);
+        #endif
+        dispatch(index);
+    }
+    return busy;
+}
+
+/**
+ * @brief Pass new message of modem to its Adeon and message handler.
+ * @param index is index of modem in the pool.
+ */
+void GsmPoolBase::dispatch(uint8_t index){
+    GSMBase* pGsm = _pModems[index].pGsm;
+    AdeonBase* pAdeon = _pModems[index].pAdeon;
+    char* pPhoneNum = pGsm->getPhoneNum();
+    char* pMsg = pGsm->getMsg();
+    _msgCount++;
+
+    if(pAdeon != nullptr && pAdeon->isUserInAdeon(pPhoneNum)){
+        pAdeon->parseBuf(pMsg, pAdeon->getUserRightsLevel(pPhoneNum), pPhoneNum);
+    }
+    if(_handler != nullptr){
+        _handler(index, pPhoneNum, pMsg, _pContext);
+    }
+}
+
+#ifdef GSM_POOL_THREADS
+/**
+ * @brief Serve modems by worker threads.
+ * @param numOfWorkers is number of threads (1 to GSM_POOL_MAX_WORKERS), modems are split among them.
+ * @return <code>true</code> if workers are started, <code>false</code> otherwise (also for pool without modems).
+ * 
+ * poll() must not be called while workers are running. Values of Adeon read by the sketch
+ * outside the message handler need ADEON_CONCURRENT in build flags.
+ */
+bool GsmPoolBase::start(uint8_t numOfWorkers){
+    if(_running || _numOfModems == 0 || numOfWorkers == 0 || numOfWorkers > GSM_POOL_MAX_WORKERS){
+        return false;
+    }
+    if(numOfWorkers > _numOfModems){
+        numOfWorkers = _numOfModems;
+    }
+    _running = true;
+    _numOfWorkers = numOfWorkers;
+    for(uint8_t w = 0; w < _numOfWorkers; w++){
+        _workers[w] = std::thread(&GsmPoolBase::work, this, w);
+    }
+    return true;
+}
+
+/**
+ * @brief Stop worker threads and wait for them.
+ * 
+ * Pool which is not running is left as it is, destructor of the pool calls it.
+ */
+void GsmPoolBase::stop(){
+    if(!_running.exchange(false)){
+        return;
+    }
+    for(uint8_t w = 0; w < _numOfWorkers; w++){
+        if(_workers[w].joinable()){
+            _workers[w].join();
+        }
+    }
+    _numOfWorkers = 0;
+}
+
+/**
+ * @brief Loop of worker thread.
+ * @param worker is index of worker, it serves every modem with index worker + k * numOfWorkers.
+ */
+void GsmPoolBase::work(uint8_t worker){
+    while(_running){
+        for(uint8_t i = worker; i < _numOfModems; i += _numOfWorkers){
+            serve(i);
+        }
+        delay(1);
+    }
+}
+#endif
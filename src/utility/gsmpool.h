@@ -0,0 +1,117 @@
+/**
+ *  @file       gsmpool.h
+ *  Project     AdeonGSM
+ *  @brief      Scheduler of many GSM modems
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_GSM_POOL_H
+#define ADEON_GSM_POOL_H
+
+#include <Arduino.h>
+#include "AdeonGSM.h"
+#include "utility/SIMlib.h"
+
+#if defined(ESP32) || defined(POSIX_SERIAL)
+    #define GSM_POOL_THREADS
+    #include <mutex>
+    #include <thread>
+    #include <atomic>
+#endif
+
+constexpr static auto GSM_POOL_MAX_WORKERS = 8;
+
+/**
+ * @brief Pool logic shared by all pool sizes.
+ * 
+ * Every modem is served by GSMBase::poll(), so a slow modem does not stall the others.
+ * New message is passed to Adeon of the modem (one shared Adeon or one per modem)
+ * if sender is a known user, then message handler is called.
+ * On ESP32 and Linux modems can be served by worker threads, then Adeon and
+ * message handler are called by one thread at a time. Metrics are updated atomically there,
+ * but the sketch may read Adeon outside the message handler while workers run only
+ * with ADEON_CONCURRENT defined in build flags.
+ */
+class GsmPoolBase {
+    public:
+        typedef void (*MsgHandler)(uint8_t modem, const char* pPhoneNum, const char* pMsg, void* pContext);
+
+        bool add(GSMBase* pGsm, AdeonBase* pAdeon = nullptr);
+        uint8_t getNumOfModems();
+        void setMsgHandler(MsgHandler handler, void* pContext = nullptr);
+        bool poll();
+        uint32_t getNumOfMsgs();
+
+        #ifdef GSM_POOL_THREADS
+        bool start(uint8_t numOfWorkers);
+        void stop();
+
+        ~GsmPoolBase(){ stop(); }
+        #endif
+
+    protected:
+        struct Modem {
+            GSMBase* pGsm = nullptr;
+            AdeonBase* pAdeon = nullptr;
+        };
+
+        GsmPoolBase(Modem* pModems, uint8_t capacity);
+
+    private:
+        bool serve(uint8_t index);
+        void dispatch(uint8_t index);
+
+        Modem* _pModems;
+        uint8_t _capacity;
+        uint8_t _numOfModems = 0;
+        MsgHandler _handler = nullptr;
+        void* _pContext = nullptr;
+        uint32_t _msgCount = 0;
+
+        #ifdef GSM_POOL_THREADS
+        void work(uint8_t worker);
+
+        std::mutex _dispatchLock;
+        std::atomic<bool> _running{false};
+        std::thread _workers[GSM_POOL_MAX_WORKERS];
+        uint8_t _numOfWorkers = 0;
+        #endif
+};
+
+/**
+ * @brief Pool with compile-time number of modems.
+ * @tparam MODEMS is maximum number of GSM objects in the pool.
+ * 
+ * Use the GsmPool alias for default size.
+ */
+template<uint8_t MODEMS = 4>
+class BasicGsmPool : public GsmPoolBase {
+    static_assert(MODEMS > 0, "MODEMS must be at least 1");
+
+    public:
+        BasicGsmPool() : GsmPoolBase(_modems, MODEMS){}
+
+    private:
+        Modem _modems[MODEMS];
+};
+
+using GsmPool = BasicGsmPool<>;
+
+#endif // ADEON_GSM_POOL_H
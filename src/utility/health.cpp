@@ -0,0 +1,262 @@
+/**
+ *  @file       health.cpp
+ *  Project     AdeonGSM
+ *  @brief      Latency of AT commands and health of the modem
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/health.h"
+
+/**
+ * @brief Count finished command and update state.
+ * @param type is type of the command, see classify().
+ * @param latency is time in ms from writing the command until its answer has been taken.
+ * @param result is outcome of the command.
+ */
+void ModemHealth::record(AtType type, unsigned long latency, CommandResult result){
+    CommandStats* pStats = &_stats[(uint8_t)type];
+    if(result == CommandResult::TIMEOUT){
+        if(pStats->timeouts != 0xFFFF){
+            pStats->timeouts++;
+        }
+        if(_timeoutsInRow != 0xFF){
+            _timeoutsInRow++;
+        }
+    }
+    else{
+        uint8_t bucket = 0;
+        while(bucket < HEALTH_BUCKETS - 1 && latency > getBucketLimit(bucket)){
+            bucket++;
+        }
+        if(pStats->buckets[bucket] != 0xFFFF){
+            pStats->buckets[bucket]++;
+            pStats->totalMs += latency;
+        }
+        _timeoutsInRow = 0;
+        if(result == CommandResult::FAILED && pStats->failures != 0xFFFF){
+            pStats->failures++;
+        }
+    }
+    if(result == CommandResult::OK){
+        _failuresInRow = 0;
+    }
+    else if(_failuresInRow != 0xFF){
+        _failuresInRow++;
+    }
+
+    HealthState state = HealthState::OK;
+    if(_timeoutsInRow >= _unresponsiveAfter){
+        state = HealthState::UNRESPONSIVE;
+    }
+    else if(_failuresInRow >= _degradedAfter){
+        state = HealthState::DEGRADED;
+    }
+    if(state != _state){
+        _state = state;
+        if(_handler != nullptr){
+            _handler(state, _pContext);
+        }
+    }
+}
+
+/**
+ * @brief Get state of the modem.
+ */
+HealthState ModemHealth::getState(){
+    return _state;
+}
+
+/**
+ * @brief Get number of the last commands which failed or were not answered.
+ */
+uint8_t ModemHealth::getFailuresInRow(){
+    return _failuresInRow;
+}
+
+/**
+ * @brief Get number of the last commands which were not answered.
+ */
+uint8_t ModemHealth::getTimeoutsInRow(){
+    return _timeoutsInRow;
+}
+
+/**
+ * @brief Get counters of command type.
+ * @param type is type of commands.
+ * @return Copy of counters.
+ */
+CommandStats ModemHealth::getStats(AtType type){
+    return _stats[(uint8_t)type];
+}
+
+/**
+ * @brief Set number of commands in a row which change the state.
+ * @param degradedAfter is number of failed or not answered commands for HealthState::DEGRADED.
+ * @param unresponsiveAfter is number of not answered commands for HealthState::UNRESPONSIVE.
+ */
+void ModemHealth::setThresholds(uint8_t degradedAfter, uint8_t unresponsiveAfter){
+    _degradedAfter = (degradedAfter != 0) ? degradedAfter : 1;
+    _unresponsiveAfter = (unresponsiveAfter != 0) ? unresponsiveAfter : 1;
+}
+
+/**
+ * @brief Set function called when the state changes.
+ * @param handler is pointer to function (null disables it).
+ * @param pContext is a pointer passed to the handler, e.g. the GSM.
+ */
+void ModemHealth::setHealthHandler(HealthHandler handler, void* pContext){
+    _handler = handler;
+    _pContext = pContext;
+}
+
+/**
+ * @brief Print latency histograms, failures, timeouts and state in Prometheus text exposition format.
+ * @param out is reference to output, e.g. the one given to AdeonMetrics::dumpMetrics().
+ *
+ * Histogram has label cmd with the command type and cumulative buckets in ms.
+ */
+void ModemHealth::dumpMetrics(Print& out){
+    out.print(F("# HELP adeon_at_latency_ms Time from AT command until its answer is taken.\n"
+                "# TYPE adeon_at_latency_ms histogram\n"));
+    for(uint8_t t = 0; t < AT_TYPE_COUNT; t++){
+        uint32_t count = 0;
+        for(uint8_t i = 0; i < HEALTH_BUCKETS; i++){
+            count += _stats[t].buckets[i];
+            out.print(F("adeon_at_latency_ms_bucket"));
+            printLabel(out, (AtType)t);
+            out.print(F(",le=\""));
+            if(i < HEALTH_BUCKETS - 1){
+                out.print(getBucketLimit(i));
+            }
+            else{
+                out.print(F("+Inf"));
+            }
+            out.print(F("\"} "));
+            out.print((unsigned long)count);
+            out.print('\n');
+        }
+        out.print(F("adeon_at_latency_ms_sum"));
+        printLabel(out, (AtType)t);
+        out.print(F("} "));
+        out.print((unsigned long)_stats[t].totalMs);
+        out.print(F("\nadeon_at_latency_ms_count"));
+        printLabel(out, (AtType)t);
+        out.print(F("} "));
+        out.print((unsigned long)count);
+        out.print('\n');
+    }
+    out.print(F("# HELP adeon_at_failures_total AT commands answered by other than the expected answer.\n"
+                "# TYPE adeon_at_failures_total counter\n"));
+    for(uint8_t t = 0; t < AT_TYPE_COUNT; t++){
+        out.print(F("adeon_at_failures_total"));
+        printLabel(out, (AtType)t);
+        out.print(F("} "));
+        out.print((unsigned long)_stats[t].failures);
+        out.print('\n');
+    }
+    out.print(F("# HELP adeon_at_timeouts_total AT commands without answer.\n"
+                "# TYPE adeon_at_timeouts_total counter\n"));
+    for(uint8_t t = 0; t < AT_TYPE_COUNT; t++){
+        out.print(F("adeon_at_timeouts_total"));
+        printLabel(out, (AtType)t);
+        out.print(F("} "));
+        out.print((unsigned long)_stats[t].timeouts);
+        out.print('\n');
+    }
+    out.print(F("# HELP adeon_modem_health State of the modem, 0 ok, 1 degraded, 2 unresponsive.\n"
+                "# TYPE adeon_modem_health gauge\n"
+                "adeon_modem_health "));
+    out.print((uint8_t)_state);
+    out.print('\n');
+}
+
+/**
+ * @brief Set state to OK after the modem has been reset. Counters are kept.
+ *
+ * Handler is not called.
+ */
+void ModemHealth::reset(){
+    _state = HealthState::OK;
+    _failuresInRow = 0;
+    _timeoutsInRow = 0;
+}
+
+/**
+ * @brief Get type of command.
+ * @param cmd is pointer to command string, e.g. "AT+CMGR=1".
+ */
+AtType ModemHealth::classify(const char* cmd){
+    if(strncmp(cmd, "AT+CMG", 6) == 0){
+        switch(cmd[6]){
+        case 'R':
+            return AtType::CMGR;
+        case 'D':
+            return AtType::CMGD;
+        case 'L':
+            return AtType::CMGL;
+        case 'S':
+            return AtType::CMGS;
+        default:
+            break;
+        }
+    }
+    return AtType::AT;
+}
+
+/**
+ * @brief Get latency limit of bucket.
+ * @param bucket is index of bucket.
+ * @return Time in ms, bucket counts latency up to it and above the limit of the previous bucket
+ * (like le bound of Prometheus histogram).
+ * The last bucket has no limit, its lower limit is returned.
+ */
+unsigned long ModemHealth::getBucketLimit(uint8_t bucket){
+    if(bucket >= HEALTH_BUCKETS - 1){
+        bucket = HEALTH_BUCKETS - 2;
+    }
+    return (unsigned long)HEALTH_BUCKET_BASE << bucket;
+}
+
+/**
+ * @brief Get name of command type.
+ */
+const __FlashStringHelper* ModemHealth::typeName(AtType type){
+    switch(type){
+    case AtType::CMGR:
+        return F("CMGR");
+    case AtType::CMGD:
+        return F("CMGD");
+    case AtType::CMGL:
+        return F("CMGL");
+    case AtType::CMGS:
+        return F("CMGS");
+    default:
+        return F("AT");
+    }
+}
+
+/**
+ * @brief Print "{cmd="TYPE"" without the closing brace.
+ */
+void ModemHealth::printLabel(Print& out, AtType type){
+    out.print(F("{cmd=\""));
+    out.print(typeName(type));
+    out.print('"');
+}
@@ -0,0 +1,118 @@
+/**
+ *  @file       health.h
+ *  Project     AdeonGSM
+ *  @brief      Latency of AT commands and health of the modem
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_HEALTH_H
+#define ADEON_HEALTH_H
+
+#include <Arduino.h>
+
+constexpr static auto HEALTH_BUCKETS = 8;
+constexpr static auto HEALTH_BUCKET_BASE = 250;     //ms, limit of the first bucket, each next one doubles it
+constexpr static auto HEALTH_DEGRADED_AFTER = 2;    // failed commands in a row
+constexpr static auto HEALTH_UNRESPONSIVE_AFTER = 3; // commands without answer in a row
+constexpr static auto HEALTH_PROBE_TIME = 60000;    //ms, AT sent by idle GSM
+
+/**
+ * @brief Type of AT command, commands other than the SMS ones are AT.
+ */
+enum class AtType : uint8_t {
+    AT,
+    CMGR,
+    CMGD,
+    CMGL,
+    CMGS, // prompt and network confirmation of the text are counted separately
+    COUNT
+};
+
+constexpr static auto AT_TYPE_COUNT = (uint8_t)AtType::COUNT;
+
+/**
+ * @brief Outcome of AT command.
+ */
+enum class CommandResult : uint8_t {
+    OK,     // expected answer
+    FAILED, // other answer, e.g. ERROR
+    TIMEOUT // no answer
+};
+
+/**
+ * @brief State of the modem given by the last commands.
+ */
+enum class HealthState : uint8_t {
+    OK,
+    DEGRADED,    // commands fail in a row
+    UNRESPONSIVE // commands are not answered in a row
+};
+
+/**
+ * @brief Counters of one command type.
+ */
+struct CommandStats {
+    uint16_t buckets[HEALTH_BUCKETS] = {}; // answered commands by latency, see getBucketLimit()
+    uint32_t totalMs = 0;                  // sum of latency of answered commands
+    uint16_t failures = 0;
+    uint16_t timeouts = 0;
+};
+
+/**
+ * @brief Monitor of AT commands of one GSM, see GSM::setHealthMonitor().
+ *
+ * Latency is time from writing a command until GSM takes its answer, so it includes
+ * COMMAND_DELAY and settling of the answer. Buckets are log-scale and saturate at 65535,
+ * answers which do not come are counted as timeouts only.
+ * Health handler is called when the state changes, e.g. to reset the modem when it becomes
+ * UNRESPONSIVE. It runs inside GSM::poll(), so it should only set a flag for loop().
+ */
+class ModemHealth {
+    public:
+        typedef void (*HealthHandler)(HealthState state, void* pContext);
+
+        void record(AtType type, unsigned long latency, CommandResult result);
+        HealthState getState();
+        uint8_t getFailuresInRow();
+        uint8_t getTimeoutsInRow();
+        CommandStats getStats(AtType type);
+        void setThresholds(uint8_t degradedAfter, uint8_t unresponsiveAfter);
+        void setHealthHandler(HealthHandler handler, void* pContext = nullptr);
+        void dumpMetrics(Print& out);
+        void reset();
+
+        static AtType classify(const char* cmd);
+        static unsigned long getBucketLimit(uint8_t bucket);
+        static const __FlashStringHelper* typeName(AtType type);
+
+    private:
+        void printLabel(Print& out, AtType type);
+
+        CommandStats _stats[AT_TYPE_COUNT];
+        HealthState _state = HealthState::OK;
+        uint8_t _failuresInRow = 0; // failed or not answered
+        uint8_t _timeoutsInRow = 0;
+        uint8_t _degradedAfter = HEALTH_DEGRADED_AFTER;
+        uint8_t _unresponsiveAfter = HEALTH_UNRESPONSIVE_AFTER;
+        HealthHandler _handler = nullptr;
+        void* _pContext = nullptr;
+};
+
+#endif // ADEON_HEALTH_H
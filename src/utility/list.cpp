@@ -25,24 +25,40 @@
 #include "utility/list.h"
 
 /**
- * @brief Empty constructor for the class ItemList.
+ * @brief Constructor for the class ItemListBase.
+ * @param pMemory is pointer to account which counts memory of items.
+ * @param idLength is size of id buffer including terminating null character.
+ * @param capacity is maximum number of items in the list.
  */
-ItemList::ItemList(){
-
+ItemListBase::ItemListBase(MemoryAccount* pMemory, uint8_t idLength, uint8_t capacity){
+    _pMemory = pMemory;
+    _idLength = idLength;
+    _capacity = capacity;
 }
 
 /**
  * @brief Add item into a list.
  * @param pId is pointer to costant id string.
  * @param val is value of item.
- * @return pItem is pointer to new created object
+ * @return pItem is pointer to new created object (null if item can't be added)
  * 
  * At the beginning is checked validity of id. 
  * Than is called Item class constructor which create new item in list.
  */
-ItemList::Item* ItemList::addItem(const char* pId, uint16_t val){
-    if(isIdLenValid(pId) && !isInList(findItem(pId)) && *pId != 0){
-        Item* pItem = new Item(pId, val);
+ItemListBase::Item* ItemListBase::addItem(const char* pId, uint16_t val){
+    if(isIdLenValid(pId) && !isListFull() && !isInList(findItem(pId)) && *pId != 0){
+        Item* pItem = new (_pMemory) Item(pId, val, _pMemory);
+        if(pItem == nullptr){
+            return nullptr;
+        }
+        if(pItem->id == nullptr){
+            releaseItem(pItem);
+            return nullptr;
+        }
+        pItem->serial = _nextSerial++;
+        if(_nextSerial == 0){
+            _nextSerial = 1;
+        }
         if(_pHead == nullptr){
             _pHead = pItem;
             _pLast = pItem;
@@ -56,6 +72,7 @@ ItemList::Item* ItemList::addItem(const char* pId, uint16_t val){
             _pLast = pItem;
         }
         _numOfItems++;
+        _revision++;
         return pItem;
     }
     return nullptr;
@@ -66,53 +83,65 @@ ItemList::Item* ItemList::addItem(const char* pId, uint16_t val){
  * @param pItem is pointer to object Item.
  * 
  * At the beginning is checked if pointer to object is not null. 
- * If item is not pHead (pointer to first item in list) than the pNext
- * pointer of deleted object is saved into pNext pointer of previous object in list.
+ * Neighbours of deleted object are linked together (head and last pointers
+ * are moved if needed) and memory of the object and its id is released.
  */
-void ItemList::deleteItem(Item* pItem){
+void ItemListBase::deleteItem(Item* pItem){
     if(pItem != nullptr){
-        if(pItem != _pHead){
-            Item* pPrev = pItem->getPointToPrevItem();
-            pPrev->setPointToNextItem(pItem->getPointToNextItem());
-            Item* pNext = pItem->getPointToNextItem();
-            if(pNext == nullptr){
-                _pLast = pPrev;
-            }
-            else{
-                pNext->setPointToPrevItem(pItem->getPointToPrevItem());
-            }
+        Item* pPrev = pItem->getPointToPrevItem();
+        Item* pNext = pItem->getPointToNextItem();
+        if(pPrev == nullptr){
+            _pHead = pNext;
+        }
+        else{
+            pPrev->setPointToNextItem(pNext);
         }
-        else if(pItem != _pLast){
-            _pHead = pItem->getPointToNextItem();
-            _pHead->setPointToPrevItem(nullptr);
+        if(pNext == nullptr){
+            _pLast = pPrev;
         }
         else{
-            deleteHead();
+            pNext->setPointToPrevItem(pPrev);
         }
-        delete[]pItem;
+        unlinkChanged(pItem);
+        releaseItem(pItem);
         _numOfItems--;
+        _revision++;
+        ADEON_STORE(_epoch, _epoch + 1);
     }
 }
 
 /**
- * @brief Delete head of list.
+ * @brief Delete all items of list.
  * 
- * If head of list is null the linking to list is lost – list deleted.
+ * Memory of all objects is released and list is empty afterwards.
  */
-void ItemList::deleteHead(){
+void ItemListBase::deleteHead(){
+    Item* pItem = _pHead;
+    while(pItem != nullptr){
+        Item* pNext = pItem->getPointToNextItem();
+        releaseItem(pItem);
+        pItem = pNext;
+    }
     _pHead = nullptr;
     _pLast = nullptr;
+    _pChangedHead = nullptr;
+    _pChangedLast = nullptr;
+    _numOfItems = 0;
+    _revision++;
+    ADEON_STORE(_epoch, _epoch + 1);
 }
 
 /**
  * @brief Edit item id in a list.
  * @param pItem is pointer to object Item.
  * @param pNewId is pointer to new item id.
- * @return pItem->id which is pointer to new id string
+ * @return pItem->id which is pointer to new id string (null if id can't be saved)
+ * 
+ * Memory of previous id is released.
  */
-char* ItemList::editItemId(Item* pItem, const char* pNewId){
-    if(pItem != nullptr){
-        pItem->saveId(pNewId);
+char* ItemListBase::editItemId(Item* pItem, const char* pNewId){
+    if(pItem != nullptr && pItem->saveId(pNewId, _pMemory)){
+        _revision++;
         return pItem->id;
     }
     return nullptr;
@@ -123,11 +152,25 @@ char* ItemList::editItemId(Item* pItem, const char* pNewId){
  * @param pItem is pointer to object Item.
  * @param val is new value of the item.
  * 
+ * Version of the item and revision of the list are incremented. If changes are tracked, item is marked as changed.
  * If pointer to callback function is not null, than call callback.
  */
-void ItemList::editItemVal(Item* pItem, uint16_t val){
+void ItemListBase::editItemVal(Item* pItem, uint16_t val){
     if(pItem != nullptr){
-        pItem->value = val;
+        ADEON_STORE(pItem->value, val);
+        pItem->version++;
+        _revision++;
+        if(_trackChanges && !pItem->changed){
+            pItem->changed = true;
+            pItem->pNextChanged = nullptr;
+            if(_pChangedLast == nullptr){
+                _pChangedHead = pItem;
+            }
+            else{
+                _pChangedLast->pNextChanged = pItem;
+            }
+            _pChangedLast = pItem;
+        }
         if(pItem->_pCallback != nullptr){
             pItem->_pCallback(pItem->value);
         }
@@ -137,29 +180,51 @@ void ItemList::editItemVal(Item* pItem, uint16_t val){
 /**
  * @brief Find item in a list.
  * @param pId is pointer to item id.
+ * @param pIndex is pointer where position of the item is saved (can be null), it is not changed if item is not found.
  * @return pItem which is a pointer to object item (null if id is not valid).
  */
-ItemList::Item* ItemList::findItem(const char* pId){
+ItemListBase::Item* ItemListBase::findItem(const char* pId, uint8_t* pIndex){
     if(isIdLenValid(pId) && !isListEmpty()){
         Item* pItem = _pHead;
+        uint8_t index = 0;
         while(strcmp(pId, pItem->id) != 0){
             pItem = pItem->getPointToNextItem();
+            index++;
             if(pItem == nullptr){
                 return nullptr;
             }
         }
+        if(pIndex != nullptr){
+            *pIndex = index;
+        }
         return pItem;
     }
     return nullptr;
 }
 
+/**
+ * @brief Get position of item in a list, items are kept in order of adding.
+ * @param pItem is pointer to object Item.
+ * @return Position from 0, 0xFF if item is null.
+ */
+uint8_t ItemListBase::getItemIndex(Item* pItem){
+    uint8_t index = 0;
+    for(Item* pTmp = _pHead; pTmp != nullptr; pTmp = pTmp->getPointToNextItem()){
+        if(pTmp == pItem){
+            return index;
+        }
+        index++;
+    }
+    return 0xFF;
+}
+
 /**
  * @brief Check if item is in a list.
  * @param pItem is pointer to object Item.
  * @param val is new value of the item. * 
  * @return <code>true</code> if item is in the list, <code>false</code> otherwise.
  */
-bool ItemList::isInList(Item* pItem){
+bool ItemListBase::isInList(Item* pItem){
     return pItem != nullptr;
 }
 
@@ -168,27 +233,233 @@ bool ItemList::isInList(Item* pItem){
  * @param pId is pointer to item id. 
  * @return <code>true</code> if lingth of id is valid, <code>false</code> otherwise.
  */
-bool ItemList::isIdLenValid(const char* pId){
-    return strlen(pId) < LIST_ITEM_LENGTH;
+bool ItemListBase::isIdLenValid(const char* pId){
+    return strlen(pId) < _idLength;
 }
 
-bool ItemList::isListEmpty(){
+bool ItemListBase::isListEmpty(){
     return _pHead == nullptr;
 }
 
+/**
+ * @brief Check if list reached its capacity.
+ * @return <code>true</code> if no more items can be added, <code>false</code> otherwise.
+ */
+bool ItemListBase::isListFull(){
+    return _numOfItems >= _capacity;
+}
+
 /**
  * @brief Get number of item in a list.
  * @return _numOfItems
  */
-uint8_t ItemList::getNumOfItems(){
+uint8_t ItemListBase::getNumOfItems(){
     return _numOfItems;
 }
 
+/**
+ * @brief Get size of id buffer including terminating null character.
+ * @return _idLength
+ */
+uint8_t ItemListBase::getIdLength(){
+    return _idLength;
+}
+
+/**
+ * @brief Get maximum number of items in a list.
+ * @return _capacity
+ */
+uint8_t ItemListBase::getCapacity(){
+    return _capacity;
+}
+
+/**
+ * @brief Make handle to an item.
+ * @param pItem is pointer to object Item.
+ * @return Handle bound to the item (unbound if pointer is null).
+ */
+ItemHandle ItemListBase::makeHandle(Item* pItem){
+    ItemHandle handle;
+    if(pItem != nullptr){
+        handle._pItem = pItem;
+        handle._serial = pItem->serial;
+        handle._epoch = _epoch;
+    }
+    return handle;
+}
+
+/**
+ * @brief Get item referenced by handle.
+ * @param handle is reference to handle made by makeHandle().
+ * @return Pointer to object Item (null if handle is unbound or item has been deleted).
+ * 
+ * If any item has been deleted since the handle was checked last time, the list is searched
+ * for the item. Serial number makes sure that a new item on the address of a deleted one
+ * is not taken. Stale handle is unbound.
+ */
+ItemListBase::Item* ItemListBase::getItem(ItemHandle& handle){
+    if(handle._pItem == nullptr){
+        return nullptr;
+    }
+    if(handle._epoch != _epoch){
+        Item* pItem = _pHead;
+        while(pItem != nullptr && !(pItem == handle._pItem && pItem->serial == handle._serial)){
+            pItem = pItem->getPointToNextItem();
+        }
+        if(pItem == nullptr){
+            handle._pItem = nullptr;
+            return nullptr;
+        }
+        handle._epoch = _epoch;
+    }
+    return (Item*)handle._pItem;
+}
+
+/**
+ * @brief Read value of item by handle without searching the list.
+ * @param handle is reference to handle made by makeHandle().
+ * @param pVal is pointer where value is saved (0 for unbound handle).
+ * @return <code>true</code> if value is read, <code>false</code> if handle must be resolved by getItem().
+ * 
+ * List is not walked, so it can be called concurrently with writers guarded by a sequence counter.
+ * Caller must keep the item from being released meanwhile, see AdeonBase::waitForReaders().
+ */
+bool ItemListBase::peekItemVal(ItemHandle& handle, uint16_t* pVal){
+    if(handle._pItem == nullptr){
+        *pVal = 0;
+        return true;
+    }
+    if(handle._epoch != ADEON_LOAD(_epoch)){
+        return false;
+    }
+    *pVal = ADEON_LOAD(((Item*)handle._pItem)->value);
+    return true;
+}
+
+/**
+ * @brief Call function for every item changed since last clearChanged().
+ * @param fn is pointer to function which gets id, value and version of the item.
+ * 
+ * Only changed items are visited, in order of their first change. Function may edit values,
+ * but it must not delete items.
+ */
+void ItemListBase::forEachChanged(void (*fn)(const char* pId, uint16_t val, uint16_t version)){
+    for(Item* pItem = _pChangedHead; pItem != nullptr; pItem = pItem->pNextChanged){
+        fn(pItem->id, pItem->value, pItem->version);
+    }
+}
+
+/**
+ * @brief Forget all changes.
+ * 
+ * Only changed items are visited.
+ */
+void ItemListBase::clearChanged(){
+    Item* pItem = _pChangedHead;
+    while(pItem != nullptr){
+        Item* pNext = pItem->pNextChanged;
+        pItem->changed = false;
+        pItem->pNextChanged = nullptr;
+        pItem = pNext;
+    }
+    _pChangedHead = nullptr;
+    _pChangedLast = nullptr;
+}
+
+/**
+ * @brief Check if item has been changed since last clearChanged().
+ * @param pItem is pointer to object Item.
+ * @return <code>true</code> if item is changed, <code>false</code> otherwise.
+ */
+bool ItemListBase::isChanged(Item* pItem){
+    return pItem != nullptr && pItem->changed;
+}
+
+/**
+ * @brief Get number of edits of item value.
+ * @param pItem is pointer to object Item.
+ * @return pItem->version (0 if item object is null)
+ */
+uint16_t ItemListBase::getItemVersion(Item* pItem){
+    if(pItem != nullptr){
+        return pItem->version;
+    }
+    return 0;
+}
+
+/**
+ * @brief Set bit mask of groups of item.
+ * @param pItem is pointer to object Item.
+ * @param groups is bit mask, one bit for each group.
+ */
+void ItemListBase::setItemGroups(Item* pItem, uint16_t groups){
+    if(pItem != nullptr){
+        pItem->groups = groups;
+        _revision++;
+    }
+}
+
+/**
+ * @brief Get bit mask of groups of item.
+ * @param pItem is pointer to object Item.
+ * @return pItem->groups (0 if item object is null)
+ */
+uint16_t ItemListBase::getItemGroups(Item* pItem){
+    if(pItem != nullptr){
+        return pItem->groups;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get revision of the list.
+ * @return Number of additions, deletions and edits of items, e.g. to invalidate data derived from the list.
+ */
+uint32_t ItemListBase::getRevision(){
+    return _revision;
+}
+
+/**
+ * @brief Remove item from list of changed items.
+ * @param pItem is pointer to object Item.
+ */
+void ItemListBase::unlinkChanged(Item* pItem){
+    if(!pItem->changed){
+        return;
+    }
+    Item* pPrev = nullptr;
+    Item* pChanged = _pChangedHead;
+    while(pChanged != pItem){
+        pPrev = pChanged;
+        pChanged = pChanged->pNextChanged;
+    }
+    if(pPrev == nullptr){
+        _pChangedHead = pItem->pNextChanged;
+    }
+    else{
+        pPrev->pNextChanged = pItem->pNextChanged;
+    }
+    if(_pChangedLast == pItem){
+        _pChangedLast = pPrev;
+    }
+    pItem->changed = false;
+}
+
+/**
+ * @brief Release memory of item and its id.
+ * @param pItem is pointer to object Item, it must be unlinked from the list.
+ */
+void ItemListBase::releaseItem(Item* pItem){
+    pItem->releaseId(_pMemory);
+    pItem->~Item();
+    _pMemory->release(pItem, sizeof(Item));
+}
+
 /**
  * @brief Get item value.
  * @return pItem->value (0 if item object is null)
  */
-uint16_t ItemList::getItemVal(Item* pItem){
+uint16_t ItemListBase::getItemVal(Item* pItem){
     if(pItem != nullptr){
         return pItem->value;
     }
@@ -200,7 +471,7 @@ uint16_t ItemList::getItemVal(Item* pItem){
  * 
  * It is functional only if user calls Serial.begin(baudrate) in a setup.
  */
-void ItemList::printData(){
+void ItemListBase::printData(){
     if(Serial && !isListEmpty()){
         Item* pItem = _pHead;
         Serial.println(F("*********************"));
@@ -218,11 +489,12 @@ void ItemList::printData(){
 
 /**
  * @brief Constructor for nested class Item.
+ * @param pMemory is pointer to account which counts memory of id.
  * 
- * It saves id and value to the object item.
+ * It saves id and value to the object item. Id stays null if heap is exhausted.
  */
-ItemList::Item::Item(const char* pId, uint16_t val){
-    saveId(pId);
+ItemListBase::Item::Item(const char* pId, uint16_t val, MemoryAccount* pMemory){
+    saveId(pId, pMemory);
     value = val;
 }
 
@@ -230,7 +502,7 @@ ItemList::Item::Item(const char* pId, uint16_t val){
  * @brief Set pointer to next object.
  * @param pItem is pointer to object Item.
  */
-void ItemList::Item::setPointToNextItem(Item* pItem){
+void ItemListBase::Item::setPointToNextItem(Item* pItem){
     _pNext = pItem;
 }
 
@@ -238,7 +510,7 @@ void ItemList::Item::setPointToNextItem(Item* pItem){
  * @brief Get pointer to next object.
  * @return _pNext which is pointer to following object in list.
  */
-ItemList::Item* ItemList::Item::getPointToNextItem(){
+ItemListBase::Item* ItemListBase::Item::getPointToNextItem(){
     return _pNext;
 }
 
@@ -246,7 +518,7 @@ ItemList::Item* ItemList::Item::getPointToNextItem(){
  * @brief Set pointer to previous object.
  * @param pItem is pointer to object Item.
  */
-void ItemList::Item::setPointToPrevItem(Item* pItem){
+void ItemListBase::Item::setPointToPrevItem(Item* pItem){
     _pPrev = pItem;
 }
 
@@ -254,16 +526,56 @@ void ItemList::Item::setPointToPrevItem(Item* pItem){
  * @brief Get pointer to next object.
  * @return _pPrev which is pointer to previous object in list.
  */
-ItemList::Item* ItemList::Item::getPointToPrevItem(){
+ItemListBase::Item* ItemListBase::Item::getPointToPrevItem(){
     return _pPrev;
 }
 
 /**
  * @brief Save id of an object.
  * @param pSrc which is a pointer to source string
+ * @param pMemory is pointer to account which counts memory of id.
+ * @return <code>true</code> if id is saved, <code>false</code> if heap is exhausted (previous id is kept).
  */
-void ItemList::Item::saveId(const char* pSrc){
-    id = (char*) malloc (sizeof(char) * (strlen(pSrc) + 1));
-    strncpy(id, pSrc, strlen(pSrc));
-    id[strlen(pSrc)] = '\0';
-}
\ No newline at end of file
+bool ItemListBase::Item::saveId(const char* pSrc, MemoryAccount* pMemory){
+    size_t idLen = strlen(pSrc);
+    char* pNewId = (char*)pMemory->allocate(sizeof(char) * (idLen + 1));
+    if(pNewId == nullptr){
+        return false;
+    }
+    memcpy(pNewId, pSrc, idLen);
+    pNewId[idLen] = '\0';
+    releaseId(pMemory);
+    id = pNewId;
+    return true;
+}
+
+/**
+ * @brief Release id of an object.
+ * @param pMemory is pointer to account which counts memory of id.
+ */
+void ItemListBase::Item::releaseId(MemoryAccount* pMemory){
+    if(id != nullptr){
+        pMemory->release(id, strlen(id) + 1);
+        id = nullptr;
+    }
+}
+
+/**
+ * @brief Check if handle references an item.
+ * @return <code>true</code> if handle is bound, <code>false</code> otherwise.
+ * 
+ * Deletion of the item is detected by the list, so the handle should be checked
+ * by the list (e.g. Adeon::isHandleValid) first.
+ */
+bool ItemHandle::isBound(){
+    return _pItem != nullptr;
+}
+
+/**
+ * @brief Check if two handles were made for the same item.
+ * @param other is reference to other handle.
+ * @return <code>true</code> if both handles are bound to the same item, <code>false</code> otherwise.
+ */
+bool ItemHandle::isSame(const ItemHandle& other){
+    return _pItem != nullptr && _pItem == other._pItem && _serial == other._serial;
+}
@@ -26,13 +26,58 @@
 #define ADEON_LIST_H
 
 #include <Arduino.h>
+#include "utility/memstats.h"
+
+/*
+ * Boards with threads (ESP32, Linux) can read values of items concurrently with writers.
+ * Define ADEON_CONCURRENT in build flags to add the locking, single-threaded sketches do not need it.
+ */
+#ifdef ADEON_CONCURRENT
+    #if !defined(ESP32) && !(defined(__linux__) && !defined(__AVR__))
+        #error "ADEON_CONCURRENT needs ESP32 or Linux"
+    #endif
+    #define ADEON_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+    #define ADEON_STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELAXED)
+#else
+    #define ADEON_LOAD(var) (var)
+    #define ADEON_STORE(var, val) ((var) = (val))
+#endif
 
 constexpr static auto LIST_ITEM_LENGTH = 16;
+constexpr static auto LIST_CAPACITY = 255;
+
+class ItemListBase;
+
+/**
+ * @brief Reference to an item which is resolved once by id.
+ * 
+ * Handle stays valid when id of the item is edited. After the item is deleted,
+ * handle is detected as stale and becomes unbound. Access is O(1) until any item
+ * of the list is deleted, then the handle is checked against the list once.
+ */
+class ItemHandle {
+    public:
+      bool isBound();
+      bool isSame(const ItemHandle& other);
 
-class ItemList {
+    private:
+      friend class ItemListBase;
+
+      void* _pItem = nullptr;
+      uint16_t _serial = 0;
+      uint32_t _epoch = 0;
+};
+
+/**
+ * @brief Linked list logic shared by all list configurations.
+ * 
+ * Limits are held at runtime so that the code is emitted only once
+ * no matter how many configurations of BasicItemList are used.
+ */
+class ItemListBase {
     protected:
       class Item;
-      ItemList();
+      ItemListBase(MemoryAccount* pMemory, uint8_t idLength = LIST_ITEM_LENGTH, uint8_t capacity = LIST_CAPACITY);
        
     public:      
       Item* addItem(const char* pId, uint16_t val);
@@ -40,31 +85,65 @@ class ItemList {
       void deleteHead();
       char* editItemId(Item* pItem, const char* pNewId);
 	    void editItemVal(Item* pItem, uint16_t val);
-      Item* findItem(const char* pId);
+      Item* findItem(const char* pId, uint8_t* pIndex = nullptr);
+      uint8_t getItemIndex(Item* pItem);
       bool isInList(Item* pItem);
       bool isIdLenValid(const char* pId);
       bool isListEmpty();
+      bool isListFull();
       uint8_t getNumOfItems();
+      uint8_t getIdLength();
+      uint8_t getCapacity();
       uint16_t getItemVal(Item* pItem);
+      void setItemGroups(Item* pItem, uint16_t groups);
+      uint16_t getItemGroups(Item* pItem);
       void printData();
 
+      ItemHandle makeHandle(Item* pItem);
+      Item* getItem(ItemHandle& handle);
+      bool peekItemVal(ItemHandle& handle, uint16_t* pVal);
+
+      void forEachChanged(void (*fn)(const char* pId, uint16_t val, uint16_t version));
+      void clearChanged();
+      bool isChanged(Item* pItem);
+      uint16_t getItemVersion(Item* pItem);
+      uint32_t getRevision();
+
     protected:
       Item* _pHead = nullptr;
       Item* _pLast = nullptr; 
       uint8_t _numOfItems = 0;
+      uint8_t _idLength;
+      uint8_t _capacity;
+      MemoryAccount* _pMemory;
+      uint16_t _nextSerial = 1;
+      uint32_t _epoch = 0; // incremented by every delete
+      uint32_t _revision = 0; // incremented by every change of the list
+      bool _trackChanges = false;
+      Item* _pChangedHead = nullptr; // items edited since last clearChanged(), in order of first edit
+      Item* _pChangedLast = nullptr;
+
+      void releaseItem(Item* pItem);
+      void unlinkChanged(Item* pItem);
 
-      class Item {
+      class Item : public MemoryAccounted<Item> {
         public:
-          Item(const char* pId, uint16_t val);
+          Item(const char* pId, uint16_t val, MemoryAccount* pMemory);
           void setPointToNextItem(Item* pItem);
           Item* getPointToNextItem();
           void setPointToPrevItem(Item* pItem);
           Item* getPointToPrevItem();
-          void saveId(const char* pSrc);
+          bool saveId(const char* pSrc, MemoryAccount* pMemory);
+          void releaseId(MemoryAccount* pMemory);
 
-          char* id;
+          char* id = nullptr;
           uint16_t value = 0;
           uint8_t accessRights = 1;
+          uint16_t groups = 0xFFFF; // bit mask of groups, all by default
+          uint16_t serial = 0;
+          uint16_t version = 0; // incremented by every edit of value
+          bool changed = false;
+          Item* pNextChanged = nullptr;
           void (*_pCallback)(uint16_t) = nullptr;
 
         private:
@@ -73,4 +152,26 @@ class ItemList {
     };  
 };
 
+/**
+ * @brief Linked list with compile-time limits.
+ * @tparam ID_LENGTH is size of id buffer including terminating null character.
+ * @tparam CAPACITY is maximum number of items in the list.
+ */
+template<uint8_t ID_LENGTH = LIST_ITEM_LENGTH, uint8_t CAPACITY = LIST_CAPACITY>
+class BasicItemList : public ItemListBase {
+    static_assert(ID_LENGTH > 1, "ID_LENGTH must leave room for at least one character");
+    static_assert(CAPACITY > 0, "CAPACITY must be at least one item");
+
+    public:
+      MemoryStats memoryStats(){ return _memory.getStats(); }
+
+    protected:
+      BasicItemList() : ItemListBase(&_memory, ID_LENGTH, CAPACITY){}
+
+    private:
+      MemoryAccount _memory;
+};
+
+using ItemList = BasicItemList<>;
+
 #endif // ADEON_LIST_H
\ No newline at end of file
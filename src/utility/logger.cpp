@@ -0,0 +1,190 @@
+/**
+ *  @file       logger.cpp
+ *  Project     AdeonGSM
+ *  @brief      Log messages of the library
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/logger.h"
+#include "utility/list.h" // ADEON_CONCURRENT
+
+#ifdef ADEON_CONCURRENT
+    #include <mutex>
+    static std::mutex logLock; // lines of GSM threads are not mixed
+    #define ADEON_LOG_SECTION() std::lock_guard<std::mutex> section(logLock)
+#else
+    #define ADEON_LOG_SECTION()
+#endif
+
+Print* AdeonLog::_pSink = &Serial;
+
+/**
+ * @brief Set destination of messages.
+ * @param pSink is pointer to output (null discards messages).
+ */
+void AdeonLog::setSink(Print* pSink){
+    ADEON_LOG_SECTION();
+    _pSink = pSink;
+}
+
+/**
+ * @brief Get destination of messages.
+ * @return Pointer to output, null if messages are discarded.
+ */
+Print* AdeonLog::getSink(){
+    return _pSink;
+}
+
+/**
+ * @brief Write line.
+ * @param pMsg is pointer to message in flash.
+ */
+void AdeonLog::write(const __FlashStringHelper* pMsg){
+    ADEON_LOG_SECTION();
+    if(_pSink != nullptr){
+        _pSink->println(pMsg);
+    }
+}
+
+/**
+ * @brief Write line with text argument.
+ * @param pMsg is pointer to message in flash.
+ * @param pArg is pointer to string printed after the message.
+ */
+void AdeonLog::write(const __FlashStringHelper* pMsg, const char* pArg){
+    ADEON_LOG_SECTION();
+    if(_pSink != nullptr){
+        _pSink->print(pMsg);
+        _pSink->println(pArg);
+    }
+}
+
+/**
+ * @brief Write line with number argument.
+ * @param pMsg is pointer to message in flash.
+ * @param arg is number printed after the message.
+ */
+void AdeonLog::write(const __FlashStringHelper* pMsg, long arg){
+    ADEON_LOG_SECTION();
+    if(_pSink != nullptr){
+        _pSink->print(pMsg);
+        _pSink->println(arg);
+    }
+}
+
+/**
+ * @brief Constructor for the class LogBufferBase.
+ * @param pBuf is pointer to buffer.
+ * @param size is size of the buffer.
+ */
+LogBufferBase::LogBufferBase(char* pBuf, uint16_t size){
+    _pBuf = pBuf;
+    _size = size;
+}
+
+/**
+ * @brief Add character to the actual line.
+ * @param c is character, line is finished by '\n'.
+ * @return Always 1, character of a dropped line is skipped.
+ */
+size_t LogBufferBase::write(uint8_t c){
+    if(_dropping){
+        _dropping = c != '\n';
+        return 1;
+    }
+    uint16_t next = (_head + 1 < _size) ? _head + 1 : 0;
+    if(next == _tail){
+        //line does not fit, its beginning is removed as well
+        _head = _lineStart;
+        _dropping = c != '\n';
+        _stats.dropped++;
+        return 1;
+    }
+    _pBuf[_head] = c;
+    _head = next;
+    if(c == '\n'){
+        _lineStart = _head;
+        _stats.lines++;
+    }
+    return 1;
+}
+
+/**
+ * @brief Get number of characters of finished lines.
+ */
+int LogBufferBase::available(){
+    return (_lineStart + _size - _tail) % _size;
+}
+
+/**
+ * @brief Take character of finished line.
+ * @return Character, -1 if no line is finished.
+ */
+int LogBufferBase::read(){
+    if(available() == 0){
+        return -1;
+    }
+    char c = _pBuf[_tail];
+    _tail = (_tail + 1 < _size) ? _tail + 1 : 0;
+    return (uint8_t)c;
+}
+
+/**
+ * @brief Look at character of finished line.
+ * @return Character, -1 if no line is finished.
+ */
+int LogBufferBase::peek(){
+    return (available() == 0) ? -1 : (uint8_t)_pBuf[_tail];
+}
+
+/**
+ * @brief Move finished lines to output without waiting, call it from loop().
+ * @param out is reference to output, e.g. Serial.
+ * @param maxBytes is maximum number of written characters, 0 for free space
+ * reported by availableForWrite() of the output.
+ * @return Number of written characters.
+ */
+uint16_t LogBufferBase::pump(Print& out, uint16_t maxBytes){
+    int room = (maxBytes != 0) ? maxBytes : out.availableForWrite();
+    uint16_t count = 0;
+    while(room-- > 0 && available() > 0){
+        out.write((uint8_t)read());
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Drop all characters. Counters are kept.
+ */
+void LogBufferBase::clear(){
+    _head = 0;
+    _tail = 0;
+    _lineStart = 0;
+    _dropping = false;
+}
+
+/**
+ * @brief Get counters of the buffer.
+ * @return Copy of counters.
+ */
+LogStats LogBufferBase::getStats(){
+    return _stats;
+}
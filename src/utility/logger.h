@@ -0,0 +1,147 @@
+/**
+ *  @file       logger.h
+ *  Project     AdeonGSM
+ *  @brief      Log messages of the library
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_LOGGER_H
+#define ADEON_LOGGER_H
+
+#include <Arduino.h>
+
+#define ADEON_LOG_LEVEL_NONE 0
+#define ADEON_LOG_LEVEL_ERROR 1
+#define ADEON_LOG_LEVEL_WARN 2
+#define ADEON_LOG_LEVEL_INFO 3
+#define ADEON_LOG_LEVEL_DEBUG 4
+
+/*
+ * Messages above ADEON_LOG_LEVEL are removed at compile time, arguments are not evaluated.
+ * Define e.g. ADEON_LOG_LEVEL=ADEON_LOG_LEVEL_ERROR in build flags to save flash.
+ */
+#ifndef ADEON_LOG_LEVEL
+    #define ADEON_LOG_LEVEL ADEON_LOG_LEVEL_INFO
+#endif
+
+#if ADEON_LOG_LEVEL >= ADEON_LOG_LEVEL_ERROR
+    #define ADEON_LOG_ERROR(...) AdeonLog::write(__VA_ARGS__)
+#else
+    #define ADEON_LOG_ERROR(...) do{}while(0)
+#endif
+
+#if ADEON_LOG_LEVEL >= ADEON_LOG_LEVEL_WARN
+    #define ADEON_LOG_WARN(...) AdeonLog::write(__VA_ARGS__)
+#else
+    #define ADEON_LOG_WARN(...) do{}while(0)
+#endif
+
+#if ADEON_LOG_LEVEL >= ADEON_LOG_LEVEL_INFO
+    #define ADEON_LOG_INFO(...) AdeonLog::write(__VA_ARGS__)
+#else
+    #define ADEON_LOG_INFO(...) do{}while(0)
+#endif
+
+#if ADEON_LOG_LEVEL >= ADEON_LOG_LEVEL_DEBUG
+    #define ADEON_LOG_DEBUG(...) AdeonLog::write(__VA_ARGS__)
+#else
+    #define ADEON_LOG_DEBUG(...) do{}while(0)
+#endif
+
+/**
+ * @brief Destination of library messages, one line per message.
+ *
+ * Messages are written to Serial unless another sink is set, null sink discards them.
+ * Sink can be any Print, e.g. Serial (writing blocks when its buffer is full) or LogBuffer,
+ * which only copies the line and is drained by the sketch.
+ */
+class AdeonLog {
+    public:
+        static void setSink(Print* pSink);
+        static Print* getSink();
+
+        static void write(const __FlashStringHelper* pMsg);
+        static void write(const __FlashStringHelper* pMsg, const char* pArg);
+        static void write(const __FlashStringHelper* pMsg, long arg);
+
+    private:
+        static Print* _pSink;
+};
+
+/**
+ * @brief Counters of log buffer.
+ */
+struct LogStats {
+    uint32_t lines = 0;   // lines kept in buffer
+    uint32_t dropped = 0; // lines which did not fit
+};
+
+/**
+ * @brief Ring buffer of whole lines shared by all sizes.
+ *
+ * Line which does not fit is dropped, so the writer never waits. Only finished lines
+ * can be read, by Stream functions or by pump() which writes them out without blocking.
+ */
+class LogBufferBase : public Stream {
+    public:
+        size_t write(uint8_t c) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+
+        uint16_t pump(Print& out, uint16_t maxBytes = 0);
+        void clear();
+        LogStats getStats();
+
+    protected:
+        LogBufferBase(char* pBuf, uint16_t size);
+
+    private:
+        char* _pBuf;
+        uint16_t _size;
+        uint16_t _head = 0;      // position of the next written character
+        uint16_t _tail = 0;      // position of the next read character
+        uint16_t _lineStart = 0; // start of unfinished line, characters before it can be read
+        bool _dropping = false;  // rest of the line is skipped
+
+        LogStats _stats;
+};
+
+/**
+ * @brief Log buffer with compile-time size.
+ * @tparam SIZE is size of the buffer, one character is kept free.
+ *
+ * Use the LogBuffer alias for default size.
+ */
+template<uint16_t SIZE = 128>
+class BasicLogBuffer : public LogBufferBase {
+    static_assert(SIZE > 1, "SIZE must be at least 2");
+
+    public:
+        BasicLogBuffer() : LogBufferBase(_buf, SIZE){}
+
+    private:
+        char _buf[SIZE];
+};
+
+using LogBuffer = BasicLogBuffer<>;
+
+#endif // ADEON_LOGGER_H
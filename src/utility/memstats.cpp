@@ -0,0 +1,96 @@
+/**
+ *  @file       memstats.cpp
+ *  Project     AdeonGSM
+ *  @brief      Counting wrappers for heap allocations
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/memstats.h"
+#include "utility/list.h" // ADEON_CONCURRENT
+
+//hash of a message being parsed and items of a writer can be counted at once
+#ifdef ADEON_CONCURRENT
+    #define ADEON_ADD(var, n) __atomic_add_fetch(&(var), (n), __ATOMIC_RELAXED)
+    #define ADEON_SUB(var, n) __atomic_sub_fetch(&(var), (n), __ATOMIC_RELAXED)
+#else
+    #define ADEON_ADD(var, n) ((var) += (n))
+    #define ADEON_SUB(var, n) ((var) -= (n))
+#endif
+
+MemoryAccount::AllocFn MemoryAccount::_allocFn = malloc;
+MemoryAccount::FreeFn MemoryAccount::_freeFn = free;
+
+/**
+ * @brief Allocate memory block and count it.
+ * @param size is number of requested bytes.
+ * @return Pointer to allocated block (null if heap is exhausted).
+ */
+void* MemoryAccount::allocate(size_t size){
+    void* ptr = _allocFn(size);
+    if(ptr == nullptr){
+        ADEON_ADD(_stats.failCount, 1);
+        return nullptr;
+    }
+    size_t inUse = ADEON_ADD(_stats.bytesInUse, size);
+    ADEON_ADD(_stats.allocCount, 1);
+    ADEON_ADD(_stats.liveObjects, 1);
+    #ifdef ADEON_CONCURRENT
+    size_t peak = ADEON_LOAD(_stats.peakBytes);
+    while(inUse > peak && !__atomic_compare_exchange_n(&_stats.peakBytes, &peak, inUse, true,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+    }
+    #else
+    if(inUse > _stats.peakBytes){
+        _stats.peakBytes = inUse;
+    }
+    #endif
+    return ptr;
+}
+
+/**
+ * @brief Free memory block and uncount it.
+ * @param ptr is pointer to block returned by allocate() (null is ignored).
+ * @param size is number of bytes requested by allocate().
+ */
+void MemoryAccount::release(void* ptr, size_t size){
+    if(ptr != nullptr){
+        _freeFn(ptr);
+        ADEON_SUB(_stats.bytesInUse, size);
+        ADEON_SUB(_stats.liveObjects, 1);
+    }
+}
+
+/**
+ * @brief Get heap usage of the account.
+ * @return _stats is a copy of actual counters.
+ */
+MemoryStats MemoryAccount::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Replace heap functions used by all accounts.
+ * @param allocFn is malloc compatible function (null restores malloc).
+ * @param freeFn is free compatible function (null restores free).
+ */
+void MemoryAccount::setAllocator(AllocFn allocFn, FreeFn freeFn){
+    _allocFn = (allocFn != nullptr) ? allocFn : malloc;
+    _freeFn = (freeFn != nullptr) ? freeFn : free;
+}
@@ -0,0 +1,97 @@
+/**
+ *  @file       memstats.h
+ *  Project     AdeonGSM
+ *  @brief      Counting wrappers for heap allocations
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_MEMSTATS_H
+#define ADEON_MEMSTATS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Snapshot of heap usage of one account.
+ */
+struct MemoryStats {
+    size_t bytesInUse = 0;
+    size_t peakBytes = 0;
+    uint32_t allocCount = 0; // successful allocations since start
+    uint32_t failCount = 0;  // allocations refused by heap
+    uint16_t liveObjects = 0;
+};
+
+/**
+ * @brief Counting wrapper around malloc and free.
+ * 
+ * Size of released block must be the same as the allocated one,
+ * so the wrapper does not need to store any header in front of the block.
+ * Heap functions can be replaced by setAllocator(), e.g. to run the library
+ * on a simulated small heap. It must be done before any account allocates.
+ */
+class MemoryAccount {
+    public:
+        typedef void* (*AllocFn)(size_t size);
+        typedef void (*FreeFn)(void* ptr);
+
+        void* allocate(size_t size);
+        void release(void* ptr, size_t size);
+        MemoryStats getStats();
+
+        static void setAllocator(AllocFn allocFn, FreeFn freeFn);
+
+    private:
+        MemoryStats _stats;
+
+        static AllocFn _allocFn;
+        static FreeFn _freeFn;
+};
+
+/**
+ * @brief Base for objects created with <code>new (pMemory) T(...)</code>.
+ * @tparam T is the derived class, its size is released if the constructor does not finish.
+ * 
+ * Object must be destroyed by explicit destructor call followed by
+ * MemoryAccount::release with sizeof(T).
+ */
+template<typename T>
+class MemoryAccounted {
+    public:
+        /**
+         * @brief Allocate object from the account.
+         * @param size is size of the object.
+         * @param pMemory is pointer to account.
+         * @return Pointer to memory for the object (null if heap is exhausted, constructor is not called then).
+         */
+        static void* operator new(size_t size, MemoryAccount* pMemory) noexcept{
+            return pMemory->allocate(size);
+        }
+
+        /**
+         * @brief Release object memory if its constructor does not finish.
+         * @param ptr is pointer to object memory.
+         * @param pMemory is pointer to account.
+         */
+        static void operator delete(void* ptr, MemoryAccount* pMemory) noexcept{
+            pMemory->release(ptr, sizeof(T));
+        }
+};
+
+#endif // ADEON_MEMSTATS_H
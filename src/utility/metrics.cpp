@@ -0,0 +1,210 @@
+/**
+ *  @file       metrics.cpp
+ *  Project     AdeonGSM
+ *  @brief      Counters and gauges of GSM and Adeon
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/metrics.h"
+
+uint32_t AdeonMetrics::_values[METRIC_COUNT] = {};
+
+/**
+ * @brief Output which fills a string, text over its size is cut off.
+ */
+class StringPrint : public Print {
+    public:
+        StringPrint(char* pBuf, uint8_t size) : _pBuf(pBuf), _size(size){
+            _pBuf[0] = '\0';
+        }
+        size_t write(uint8_t c) override {
+            if(_length + 1 >= _size){
+                return 0;
+            }
+            _pBuf[_length++] = c;
+            _pBuf[_length] = '\0';
+            return 1;
+        }
+        using Print::write;
+        uint8_t getLength(){
+            return _length;
+        }
+
+    private:
+        char* _pBuf;
+        uint8_t _size;
+        uint8_t _length = 0;
+};
+
+/**
+ * @brief Get value of metric.
+ * @param metric is counter or gauge.
+ */
+uint32_t AdeonMetrics::get(Metric metric){
+    return ADEON_METRIC_LOAD(_values[(uint8_t)metric]);
+}
+
+/**
+ * @brief Set all counters to zero.
+ * 
+ * QUEUE_DEPTH keeps the current depth, GSM objects only add its changes.
+ */
+void AdeonMetrics::reset(){
+    for(uint8_t i = 0; i < METRIC_COUNT; i++){
+        if((Metric)i != Metric::QUEUE_DEPTH){
+            ADEON_METRIC_STORE(_values[i], 0);
+        }
+    }
+}
+
+/**
+ * @brief Print all metrics.
+ * @param out is reference to output, e.g. Serial or a client of HTTP server.
+ * @param format is MetricsFormat::PROMETHEUS for HELP, TYPE and value lines of each metric,
+ * MetricsFormat::COMPACT for the line of getSummary().
+ *
+ * Lines end by '\n' only, as the exposition format requires.
+ */
+void AdeonMetrics::dumpMetrics(Print& out, MetricsFormat format){
+    for(uint8_t i = 0; i < METRIC_COUNT; i++){
+        Metric metric = (Metric)i;
+        if(format == MetricsFormat::COMPACT){
+            if(i != 0){
+                out.print(' ');
+            }
+            out.print(getShortName(metric));
+            out.print('=');
+            out.print((unsigned long)get(metric));
+            continue;
+        }
+        out.print(F("# HELP "));
+        out.print(getName(metric));
+        out.print(' ');
+        out.print(getHelp(metric));
+        out.print(F("\n# TYPE "));
+        out.print(getName(metric));
+        out.print((metric == Metric::QUEUE_DEPTH) ? F(" gauge\n") : F(" counter\n"));
+        out.print(getName(metric));
+        out.print(' ');
+        out.print((unsigned long)get(metric));
+        out.print('\n');
+    }
+    if(format == MetricsFormat::COMPACT){
+        out.print('\n');
+    }
+}
+
+/**
+ * @brief Write all metrics in compact format into string, e.g. to answer by GSM::sendSms().
+ * @param pBuf is pointer to buffer.
+ * @param size is size of the buffer, 64 bytes hold all metrics below one million.
+ * @return Length of the string, text which does not fit is cut off.
+ */
+uint8_t AdeonMetrics::getSummary(char* pBuf, uint8_t size){
+    if(size == 0){
+        return 0;
+    }
+    StringPrint out(pBuf, size);
+    dumpMetrics(out, MetricsFormat::COMPACT);
+    //line end of the dump is not part of the summary
+    uint8_t length = out.getLength();
+    if(length != 0 && pBuf[length - 1] == '\n'){
+        pBuf[--length] = '\0';
+    }
+    return length;
+}
+
+/**
+ * @brief Get name of metric in exposition format.
+ */
+const __FlashStringHelper* AdeonMetrics::getName(Metric metric){
+    switch(metric){
+    case Metric::SMS_RECEIVED:
+        return F("adeon_sms_received_total");
+    case Metric::HASH_FAILURES:
+        return F("adeon_hash_failures_total");
+    case Metric::UNAUTHORIZED:
+        return F("adeon_unauthorized_total");
+    case Metric::PARSE_ERRORS:
+        return F("adeon_parse_errors_total");
+    case Metric::PARAMS_APPLIED:
+        return F("adeon_params_applied_total");
+    case Metric::CMD_TIMEOUTS:
+        return F("adeon_command_timeouts_total");
+    case Metric::SMS_DELETED:
+        return F("adeon_sms_deleted_total");
+    case Metric::QUEUE_DEPTH:
+        return F("adeon_queue_depth");
+    default:
+        return F("adeon_unknown");
+    }
+}
+
+/**
+ * @brief Get description of metric in exposition format.
+ */
+const __FlashStringHelper* AdeonMetrics::getHelp(Metric metric){
+    switch(metric){
+    case Metric::SMS_RECEIVED:
+        return F("SMS read from the modem.");
+    case Metric::HASH_FAILURES:
+        return F("Messages with wrong hash.");
+    case Metric::UNAUTHORIZED:
+        return F("Commands refused for rights or groups of the sender.");
+    case Metric::PARSE_ERRORS:
+        return F("SMS and messages with wrong format or length.");
+    case Metric::PARAMS_APPLIED:
+        return F("Parameter values set by messages and timed edits.");
+    case Metric::CMD_TIMEOUTS:
+        return F("AT commands without answer.");
+    case Metric::SMS_DELETED:
+        return F("SMS deleted from the modem.");
+    case Metric::QUEUE_DEPTH:
+        return F("SMS waiting for reading or sending.");
+    default:
+        return F("");
+    }
+}
+
+/**
+ * @brief Get name of metric in compact format.
+ */
+const __FlashStringHelper* AdeonMetrics::getShortName(Metric metric){
+    switch(metric){
+    case Metric::SMS_RECEIVED:
+        return F("rx");
+    case Metric::HASH_FAILURES:
+        return F("hash");
+    case Metric::UNAUTHORIZED:
+        return F("auth");
+    case Metric::PARSE_ERRORS:
+        return F("perr");
+    case Metric::PARAMS_APPLIED:
+        return F("app");
+    case Metric::CMD_TIMEOUTS:
+        return F("tmo");
+    case Metric::SMS_DELETED:
+        return F("del");
+    case Metric::QUEUE_DEPTH:
+        return F("q");
+    default:
+        return F("?");
+    }
+}
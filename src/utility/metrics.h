@@ -0,0 +1,107 @@
+/**
+ *  @file       metrics.h
+ *  Project     AdeonGSM
+ *  @brief      Counters and gauges of GSM and Adeon
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_METRICS_H
+#define ADEON_METRICS_H
+
+#include <Arduino.h>
+
+//GsmPool workers on ESP32 and Linux update metrics from several threads, even without ADEON_CONCURRENT
+#if defined(ESP32) || (defined(__linux__) && !defined(__AVR__))
+    #define ADEON_METRIC_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+    #define ADEON_METRIC_STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELAXED)
+    #define ADEON_METRIC_ADD(var, n) __atomic_fetch_add(&(var), (n), __ATOMIC_RELAXED)
+#else
+    #define ADEON_METRIC_LOAD(var) (var)
+    #define ADEON_METRIC_STORE(var, val) ((var) = (val))
+    #define ADEON_METRIC_ADD(var, n) ((var) += (n))
+#endif
+
+/**
+ * @brief Value kept by the registry, all are counters except QUEUE_DEPTH.
+ */
+enum class Metric : uint8_t {
+    SMS_RECEIVED,   // SMS read from the modem
+    HASH_FAILURES,  // messages whose hash does not match
+    UNAUTHORIZED,   // commands refused for rights or groups of the sender
+    PARSE_ERRORS,   // SMS or messages with wrong format or length
+    PARAMS_APPLIED, // parameter values set by messages and by the timer wheel
+    CMD_TIMEOUTS,   // AT commands without answer
+    SMS_DELETED,    // SMS deleted from the modem
+    QUEUE_DEPTH,    // gauge, announced SMS waiting for reading and queued outgoing SMS of all GSM objects
+    COUNT
+};
+
+constexpr static auto METRIC_COUNT = (uint8_t)Metric::COUNT;
+
+/**
+ * @brief Format of dumpMetrics().
+ */
+enum class MetricsFormat : uint8_t {
+    PROMETHEUS, // text exposition format, e.g. for a gateway which pushes it to Pushgateway
+    COMPACT     // one line "rx=12 hash=0 ...", fits into one SMS
+};
+
+/**
+ * @brief Registry of metrics shared by all GSM and Adeon objects.
+ *
+ * Values are a static array, so no memory is allocated and updating is a plain increment
+ * (atomic on ESP32 and Linux). Counters only grow until reset(), they wrap at 2^32.
+ * Each GSM::poll() adds change of its own depth to QUEUE_DEPTH, so the gauge is the sum
+ * over all GSM objects, e.g. of a GsmPool.
+ */
+class AdeonMetrics {
+    public:
+        /**
+         * @brief Increase counter.
+         * @param metric is the counter.
+         * @param count is added number.
+         */
+        static void add(Metric metric, uint32_t count = 1){
+            ADEON_METRIC_ADD(_values[(uint8_t)metric], count);
+        }
+
+        /**
+         * @brief Set gauge.
+         * @param metric is the gauge.
+         * @param val is new value.
+         */
+        static void set(Metric metric, uint32_t val){
+            ADEON_METRIC_STORE(_values[(uint8_t)metric], val);
+        }
+
+        static uint32_t get(Metric metric);
+        static void reset();
+        static void dumpMetrics(Print& out, MetricsFormat format = MetricsFormat::PROMETHEUS);
+        static uint8_t getSummary(char* pBuf, uint8_t size);
+
+    private:
+        static const __FlashStringHelper* getName(Metric metric);
+        static const __FlashStringHelper* getHelp(Metric metric);
+        static const __FlashStringHelper* getShortName(Metric metric);
+
+        static uint32_t _values[METRIC_COUNT];
+};
+
+#endif // ADEON_METRICS_H
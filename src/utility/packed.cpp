@@ -0,0 +1,208 @@
+/**
+ *  @file       packed.cpp
+ *  Project     AdeonGSM
+ *  @brief      Compact encoding of parameter edits
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/packed.h"
+
+/**
+ * @brief Constructor for the class PackedWriter.
+ * @param pBuf is pointer to output buffer.
+ * @param size is size of output buffer including terminating null character.
+ */
+PackedWriter::PackedWriter(char* pBuf, uint16_t size){
+    _pBuf = pBuf;
+    _size = size;
+    clear();
+}
+
+/**
+ * @brief Start a new message.
+ */
+void PackedWriter::clear(){
+    _length = 0;
+    _bytes = 0;
+    _bits = 0;
+    _bitCount = 0;
+    _lastIndex = 0;
+    _count = 0;
+    if(_size >= 3){
+        _pBuf[_length++] = PACKED_PREFIX;
+        _pBuf[_length++] = PACKED_VERSION;
+    }
+}
+
+/**
+ * @brief Add edit of parameter.
+ * @param index is position of the parameter in order of addParam().
+ * @param val is new value.
+ * @return <code>true</code> if edit fits, <code>false</code> if buffer is full or index does not ascend.
+ */
+bool PackedWriter::add(uint8_t index, uint16_t val){
+    if(_count > 0 && index <= _lastIndex){
+        return false;
+    }
+    uint8_t step = (_count > 0) ? index - _lastIndex : index;
+    uint16_t bytes = _bytes + varintLength(step) + varintLength(val);
+    //prefix, characters of all bytes, end symbol and null character
+    if(2 + (bytes * 8 + 5) / 6 + 2 > _size){
+        return false;
+    }
+    putVarint(step);
+    putVarint(val);
+    _lastIndex = index;
+    _count++;
+    return true;
+}
+
+/**
+ * @brief Get packed payload, it is put after "hash: " like a list of names.
+ * @return Pointer to text in the buffer, empty string if the buffer is too small.
+ */
+const char* PackedWriter::get(){
+    if(_size < 3){
+        return "";
+    }
+    uint16_t length = _length;
+    if(_bitCount > 0){
+        _pBuf[length++] = encodeChar((_bits << (6 - _bitCount)) & 0x3F);
+    }
+    _pBuf[length++] = PACKED_END;
+    _pBuf[length] = '\0';
+    return _pBuf;
+}
+
+/**
+ * @brief Get number of added edits.
+ */
+uint8_t PackedWriter::getCount(){
+    return _count;
+}
+
+uint8_t PackedWriter::varintLength(uint16_t val){
+    return (val < 0x80) ? 1 : (val < 0x4000) ? 2 : 3;
+}
+
+char PackedWriter::encodeChar(uint8_t val){
+    if(val < 26){
+        return 'A' + val;
+    }
+    if(val < 52){
+        return 'a' + val - 26;
+    }
+    if(val < 62){
+        return '0' + val - 52;
+    }
+    return (val == 62) ? '+' : '/';
+}
+
+void PackedWriter::putVarint(uint16_t val){
+    while(val >= 0x80){
+        putByte((val & 0x7F) | 0x80);
+        val >>= 7;
+    }
+    putByte(val);
+}
+
+void PackedWriter::putByte(uint8_t val){
+    _bits = (_bits << 8) | val;
+    _bitCount += 8;
+    _bytes++;
+    while(_bitCount >= 6){
+        _bitCount -= 6;
+        _pBuf[_length++] = encodeChar((_bits >> _bitCount) & 0x3F);
+    }
+}
+
+/**
+ * @brief Check prefix of payload and decode it.
+ * @param pText is pointer to text after "hash: ".
+ * @return <code>true</code> if payload is packed, <code>false</code> if it is a list of names.
+ * 
+ * Malformed packed payload gives no edits.
+ */
+bool PackedReader::begin(char* pText){
+    _length = 0;
+    _pos = 0;
+    if(pText == nullptr || pText[0] != PACKED_PREFIX || pText[1] != PACKED_VERSION){
+        return false;
+    }
+    _pData = (uint8_t*)pText;
+    uint16_t bits = 0;
+    uint8_t bitCount = 0;
+    for(char* p = pText + 2; *p != PACKED_END; p++){
+        int8_t val = decodeChar(*p);
+        if(val < 0){
+            _length = 0;
+            return true;
+        }
+        bits = (bits << 6) | val;
+        bitCount += 6;
+        if(bitCount >= 8){
+            bitCount -= 8;
+            _pData[_length++] = (bits >> bitCount) & 0xFF;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Get next edit.
+ * @param pStep is pointer to distance of parameter from the previous edit (index for the first one).
+ * @param pVal is pointer to new value.
+ * @return <code>true</code> if edit is read, <code>false</code> at the end or on malformed data.
+ */
+bool PackedReader::next(uint16_t* pStep, uint16_t* pVal){
+    return getVarint(pStep) && getVarint(pVal);
+}
+
+int8_t PackedReader::decodeChar(char c){
+    if(c >= 'A' && c <= 'Z'){
+        return c - 'A';
+    }
+    if(c >= 'a' && c <= 'z'){
+        return c - 'a' + 26;
+    }
+    if(c >= '0' && c <= '9'){
+        return c - '0' + 52;
+    }
+    if(c == '+'){
+        return 62;
+    }
+    if(c == '/'){
+        return 63;
+    }
+    return -1;
+}
+
+bool PackedReader::getVarint(uint16_t* pVal){
+    uint32_t val = 0;
+    for(uint8_t shift = 0; shift < 21 && _pos < _length; shift += 7){
+        uint8_t byte = _pData[_pos++];
+        val |= (uint32_t)(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0){
+            *pVal = (val > 0xFFFF) ? 0xFFFF : val;
+            return val <= 0xFFFF;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,89 @@
+/**
+ *  @file       packed.h
+ *  Project     AdeonGSM
+ *  @brief      Compact encoding of parameter edits
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_PACKED_H
+#define ADEON_PACKED_H
+
+#include <Arduino.h>
+
+constexpr static auto PACKED_PREFIX = '#';
+constexpr static auto PACKED_VERSION = '1';
+constexpr static auto PACKED_END = ';';
+
+/*
+ * Packed message carries edits as "#1" + base64 + ";" after "hash: ".
+ * Every edit is two varints (7 bits per byte, lowest first): index step and value.
+ * Index is position of the parameter in order of addParam(), step of the first edit
+ * is its index, step of the next ones is distance from the previous edit.
+ * Base64 without padding uses only characters of GSM 7-bit default alphabet.
+ */
+
+/**
+ * @brief Encoder of packed message, e.g. for a device or a tool which sends commands.
+ * 
+ * Edits have to be added in ascending order of index.
+ */
+class PackedWriter {
+    public:
+        PackedWriter(char* pBuf, uint16_t size);
+
+        void clear();
+        bool add(uint8_t index, uint16_t val);
+        const char* get();
+        uint8_t getCount();
+
+    private:
+        static uint8_t varintLength(uint16_t val);
+        static char encodeChar(uint8_t val);
+        void putVarint(uint16_t val);
+        void putByte(uint8_t val);
+
+        char* _pBuf;
+        uint16_t _size;
+        uint16_t _length = 0; // complete base64 characters including prefix
+        uint16_t _bytes = 0;
+        uint16_t _bits = 0;   // bits waiting for next character
+        uint8_t _bitCount = 0;
+        uint8_t _lastIndex = 0;
+        uint8_t _count = 0;
+};
+
+/**
+ * @brief Decoder of packed message, base64 is converted in place.
+ */
+class PackedReader {
+    public:
+        bool begin(char* pText);
+        bool next(uint16_t* pStep, uint16_t* pVal);
+
+    private:
+        static int8_t decodeChar(char c);
+        bool getVarint(uint16_t* pVal);
+
+        uint8_t* _pData = nullptr;
+        uint16_t _length = 0;
+        uint16_t _pos = 0;
+};
+
+#endif // ADEON_PACKED_H
@@ -0,0 +1,311 @@
+/**
+ *  @file       posixserial.cpp
+ *  Project     AdeonGSM
+ *  @brief      Serial port Stream for Linux (termios, epoll)
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/SIMlib.h"
+
+#ifdef POSIX_SERIAL
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/epoll.h>
+
+/**
+ * @brief Constructor for the class PosixSerial. Device is opened by begin().
+ */
+PosixSerial::PosixSerial(){
+}
+
+/**
+ * @brief Destructor closes the device.
+ */
+PosixSerial::~PosixSerial(){
+    end();
+}
+
+/**
+ * @brief Open serial device.
+ * @param pDevice is pointer to path of the device, e.g. "/dev/ttyUSB0".
+ * @param baud is baud rate.
+ * @return <code>true</code> if device is opened and configured, <code>false</code> otherwise.
+ */
+bool PosixSerial::begin(const char* pDevice, long baud){
+    end();
+    int fd = open(pDevice, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if(fd < 0){
+        return false;
+    }
+    _fd = fd;
+    _ownsFd = true;
+    if(!setup(baud)){
+        end();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Use already opened descriptor, e.g. slave side of a pseudo-terminal.
+ * @param fd is descriptor of the device, it is not closed by end().
+ * @param baud is baud rate (0 keeps current speed).
+ * @return <code>true</code> if device is configured, <code>false</code> otherwise.
+ */
+bool PosixSerial::begin(int fd, long baud){
+    end();
+    _fd = fd;
+    _ownsFd = false;
+    if(!setup(baud)){
+        end();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the device and drop received bytes.
+ */
+void PosixSerial::end(){
+    if(_epollFd >= 0){
+        close(_epollFd);
+        _epollFd = -1;
+    }
+    if(_fd >= 0 && _ownsFd){
+        close(_fd);
+    }
+    _fd = -1;
+    _ownsFd = false;
+    _rxHead = 0;
+    _rxCount = 0;
+}
+
+/**
+ * @brief Change baud rate of opened device.
+ * @param baud is baud rate (standard rates from 1200 to 460800).
+ * @return <code>true</code> if baud rate is set, <code>false</code> otherwise.
+ */
+bool PosixSerial::setBaud(long baud){
+    speed_t speed;
+    switch(baud){
+        case 1200:   speed = B1200;   break;
+        case 2400:   speed = B2400;   break;
+        case 4800:   speed = B4800;   break;
+        case 9600:   speed = B9600;   break;
+        case 19200:  speed = B19200;  break;
+        case 38400:  speed = B38400;  break;
+        case 57600:  speed = B57600;  break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        case 460800: speed = B460800; break;
+        default: return false;
+    }
+    struct termios tty;
+    if(_fd < 0 || tcgetattr(_fd, &tty) != 0){
+        return false;
+    }
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    return tcsetattr(_fd, TCSANOW, &tty) == 0;
+}
+
+/**
+ * @brief Wait until modem sends data.
+ * @param timeoutMs is maximum time of waiting in ms (-1 waits forever).
+ * @return <code>true</code> if data are available, <code>false</code> after timeout.
+ */
+bool PosixSerial::waitForData(int timeoutMs){
+    if(_rxCount > 0){
+        return true;
+    }
+    if(_epollFd < 0){
+        return false;
+    }
+    struct epoll_event event;
+    int n;
+    do{
+        n = epoll_wait(_epollFd, &event, 1, timeoutMs);
+    }while(n < 0 && errno == EINTR);
+    if(n > 0){
+        fill();
+    }
+    return _rxCount > 0;
+}
+
+/**
+ * @brief Get descriptor of the device, e.g. to wait for more devices in one epoll.
+ * @return Descriptor (-1 if device is not opened).
+ */
+int PosixSerial::getFd(){
+    return _fd;
+}
+
+int PosixSerial::available(){
+    fill();
+    return _rxCount;
+}
+
+int PosixSerial::read(){
+    if(_rxCount == 0){
+        fill();
+        if(_rxCount == 0){
+            return -1;
+        }
+    }
+    uint8_t c = _rxBuffer[_rxHead];
+    _rxHead = (_rxHead + 1) % POSIX_SERIAL_RX_BUFFER;
+    _rxCount--;
+    return c;
+}
+
+int PosixSerial::peek(){
+    if(_rxCount == 0){
+        fill();
+        if(_rxCount == 0){
+            return -1;
+        }
+    }
+    return _rxBuffer[_rxHead];
+}
+
+size_t PosixSerial::write(uint8_t c){
+    return write(&c, 1);
+}
+
+/**
+ * @brief Write bytes to the device.
+ * @param buffer is pointer to data.
+ * @param size is number of bytes.
+ * @return Number of written bytes (less than size if device stays busy for one second).
+ */
+size_t PosixSerial::write(const uint8_t* buffer, size_t size){
+    size_t written = 0;
+    while(_fd >= 0 && written < size){
+        ssize_t n = ::write(_fd, buffer + written, size - written);
+        if(n > 0){
+            written += n;
+        }
+        else if(n < 0 && errno == EINTR){
+            continue;
+        }
+        else if(n < 0 && errno == EAGAIN){
+            if(!waitForWrite(1000)){
+                break;
+            }
+        }
+        else{
+            break;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief Wait until all written bytes are transmitted.
+ */
+void PosixSerial::flush(){
+    if(_fd >= 0){
+        tcdrain(_fd);
+    }
+}
+
+/**
+ * @brief Switch device to raw mode and register it in epoll.
+ * @param baud is baud rate (0 keeps current speed).
+ * @return <code>true</code> if device is configured, <code>false</code> otherwise.
+ */
+bool PosixSerial::setup(long baud){
+    int flags = fcntl(_fd, F_GETFL);
+    if(flags < 0 || fcntl(_fd, F_SETFL, flags | O_NONBLOCK) != 0){
+        return false;
+    }
+
+    struct termios tty;
+    if(tcgetattr(_fd, &tty) != 0){
+        return false;
+    }
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~CRTSCTS;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    if(tcsetattr(_fd, TCSANOW, &tty) != 0){
+        return false;
+    }
+    if(baud != 0 && !setBaud(baud)){
+        return false;
+    }
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(_epollFd < 0){
+        return false;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = _fd;
+    return epoll_ctl(_epollFd, EPOLL_CTL_ADD, _fd, &event) == 0;
+}
+
+/**
+ * @brief Take bytes waiting in the descriptor into internal buffer without blocking.
+ */
+void PosixSerial::fill(){
+    while(_fd >= 0 && _rxCount < POSIX_SERIAL_RX_BUFFER){
+        uint16_t tail = (_rxHead + _rxCount) % POSIX_SERIAL_RX_BUFFER;
+        uint16_t space = POSIX_SERIAL_RX_BUFFER - _rxCount;
+        if(space > POSIX_SERIAL_RX_BUFFER - tail){
+            space = POSIX_SERIAL_RX_BUFFER - tail;
+        }
+        ssize_t n = ::read(_fd, &_rxBuffer[tail], space);
+        if(n > 0){
+            _rxCount += n;
+        }
+        else if(n < 0 && errno == EINTR){
+            continue;
+        }
+        else{
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Wait until device accepts more bytes.
+ * @param timeoutMs is maximum time of waiting in ms.
+ * @return <code>true</code> if device is writable, <code>false</code> after timeout.
+ * 
+ * Descriptor is polled on its own, epoll of waitForData() may be used by a reader thread meanwhile.
+ */
+bool PosixSerial::waitForWrite(int timeoutMs){
+    struct pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = POLLOUT;
+    int n;
+    do{
+        n = ::poll(&pfd, 1, timeoutMs);
+    }while(n < 0 && errno == EINTR);
+    return n > 0 && (pfd.revents & POLLOUT) != 0;
+}
+
+#endif // POSIX_SERIAL
@@ -0,0 +1,77 @@
+/**
+ *  @file       posixserial.h
+ *  Project     AdeonGSM
+ *  @brief      Serial port Stream for Linux (termios, epoll)
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_POSIX_SERIAL_H
+#define ADEON_POSIX_SERIAL_H
+
+#include <Arduino.h>
+
+constexpr static auto POSIX_SERIAL_RX_BUFFER = 512;
+
+/**
+ * @brief Stream over a serial device of Linux.
+ * 
+ * Device is switched to raw mode and read without blocking, so GSM(Stream*) works
+ * the same way as with a hardware serial. Incoming bytes are taken from the descriptor
+ * into internal buffer when available() or waitForData() is called.
+ * waitForData() sleeps in epoll until modem sends something.
+ */
+class PosixSerial : public Stream {
+    public:
+        PosixSerial();
+        ~PosixSerial();
+
+        bool begin(const char* pDevice, long baud = 9600);
+        bool begin(int fd, long baud = 0);
+        void end();
+        bool setBaud(long baud);
+        bool waitForData(int timeoutMs);
+        int getFd();
+
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+        void flush() override;
+
+    private:
+        PosixSerial(const PosixSerial&) = delete;
+        PosixSerial& operator=(const PosixSerial&) = delete;
+
+        bool setup(long baud);
+        void fill();
+        bool waitForWrite(int timeoutMs);
+
+        int _fd = -1;
+        int _epollFd = -1;
+        bool _ownsFd = false;
+
+        uint8_t _rxBuffer[POSIX_SERIAL_RX_BUFFER];
+        uint16_t _rxHead = 0;
+        uint16_t _rxCount = 0;
+};
+
+#endif // ADEON_POSIX_SERIAL_H
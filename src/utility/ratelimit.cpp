@@ -0,0 +1,185 @@
+/**
+ *  @file       ratelimit.cpp
+ *  Project     AdeonGSM
+ *  @brief      Token-bucket rate limiting of SMS senders
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/ratelimit.h"
+
+/**
+ * @brief Constructor for the class RateLimiterBase.
+ * @param pSlots is pointer to sender table.
+ * @param numOfSlots is number of entries in sender table.
+ */
+RateLimiterBase::RateLimiterBase(RateLimitSlot* pSlots, uint8_t numOfSlots){
+    _pSlots = pSlots;
+    _numOfSlots = numOfSlots;
+    _globalTokens = _globalBurst;
+    _globalLastRefill = 0;
+}
+
+/**
+ * @brief Decide if message of sender can be processed.
+ * @param pPhoneNum is pointer to phone number string of sender.
+ * @return <code>true</code> if message is within limits, <code>false</code> if it should be dropped.
+ * 
+ * Call it before the message is parsed, so dropped messages cost no hashing.
+ */
+bool RateLimiterBase::allow(const char* pPhoneNum){
+    unsigned long now = _clockFn();
+    RateLimitSlot* pSlot = findSlot(makeStrKey(pPhoneNum), now);
+
+    refill(&pSlot->tokens, &pSlot->lastRefill, now, _senderBurst, _senderRefillMs);
+    refill(&_globalTokens, &_globalLastRefill, now, _globalBurst, _globalRefillMs);
+    pSlot->lastSeen = now;
+
+    if(pSlot->tokens == 0){
+        _stats.droppedSender++;
+        return false;
+    }
+    if(_globalTokens == 0){
+        _stats.droppedGlobal++;
+        return false;
+    }
+    pSlot->tokens--;
+    _globalTokens--;
+    _stats.allowed++;
+    return true;
+}
+
+/**
+ * @brief Set limit of one sender.
+ * @param burst is number of messages which can be sent at once (at least 1).
+ * @param refillMs is time in ms after which one more message is allowed.
+ */
+void RateLimiterBase::setSenderLimit(uint8_t burst, unsigned long refillMs){
+    _senderBurst = (burst == 0) ? 1 : burst;
+    _senderRefillMs = (refillMs == 0) ? 1 : refillMs;
+}
+
+/**
+ * @brief Set limit of all senders together.
+ * @param burst is number of messages which can be received at once (at least 1).
+ * @param refillMs is time in ms after which one more message is allowed.
+ */
+void RateLimiterBase::setGlobalLimit(uint8_t burst, unsigned long refillMs){
+    _globalBurst = (burst == 0) ? 1 : burst;
+    _globalRefillMs = (refillMs == 0) ? 1 : refillMs;
+    if(_globalTokens > _globalBurst){
+        _globalTokens = _globalBurst;
+    }
+}
+
+/**
+ * @brief Replace time source.
+ * @param clockFn is pointer to function returning time in ms (millis by default).
+ */
+void RateLimiterBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+    _globalLastRefill = _clockFn();
+}
+
+/**
+ * @brief Forget all senders and fill global bucket. Counters are kept.
+ */
+void RateLimiterBase::reset(){
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        _pSlots[i].used = false;
+    }
+    _globalTokens = _globalBurst;
+    _globalLastRefill = _clockFn();
+}
+
+/**
+ * @brief Get counters of allowed and dropped messages.
+ * @return Copy of counters.
+ */
+RateLimitStats RateLimiterBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Add tokens for time elapsed from last refill.
+ * @param pTokens is pointer to token count of the bucket.
+ * @param pLastRefill is pointer to time of last refill of the bucket.
+ * @param now is current time in ms.
+ * @param burst is size of the bucket.
+ * @param refillMs is time in ms after which one token is added.
+ */
+void RateLimiterBase::refill(uint8_t* pTokens, unsigned long* pLastRefill, unsigned long now,
+                             uint8_t burst, unsigned long refillMs){
+    //burst may have been lowered below the tokens of the bucket
+    if(*pTokens >= burst){
+        *pTokens = burst;
+        *pLastRefill = now;
+        return;
+    }
+    unsigned long periods = (now - *pLastRefill) / refillMs;
+    if(periods == 0){
+        return;
+    }
+    if(periods >= (unsigned long)(burst - *pTokens)){
+        *pTokens = burst;
+        *pLastRefill = now;
+    }
+    else{
+        *pTokens += periods;
+        *pLastRefill += periods * refillMs;
+    }
+}
+
+/**
+ * @brief Find bucket of sender or take a new one.
+ * @param key is hash of phone number.
+ * @param now is current time in ms.
+ * @return Pointer to slot of sender.
+ * 
+ * If table is full, sender seen longest ago is replaced.
+ */
+RateLimitSlot* RateLimiterBase::findSlot(uint32_t key, unsigned long now){
+    RateLimitSlot* pFree = nullptr;
+    RateLimitSlot* pOldest = &_pSlots[0];
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        RateLimitSlot* pSlot = &_pSlots[i];
+        if(!pSlot->used){
+            if(pFree == nullptr){
+                pFree = pSlot;
+            }
+            continue;
+        }
+        if(pSlot->key == key){
+            return pSlot;
+        }
+        if((now - pSlot->lastSeen) > (now - pOldest->lastSeen)){
+            pOldest = pSlot;
+        }
+    }
+    if(pFree == nullptr){
+        pFree = pOldest;
+        _stats.evictions++;
+    }
+    pFree->used = true;
+    pFree->key = key;
+    pFree->tokens = _senderBurst;
+    pFree->lastRefill = now;
+    pFree->lastSeen = now;
+    return pFree;
+}
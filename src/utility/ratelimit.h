@@ -0,0 +1,116 @@
+/**
+ *  @file       ratelimit.h
+ *  Project     AdeonGSM
+ *  @brief      Token-bucket rate limiting of SMS senders
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_RATE_LIMIT_H
+#define ADEON_RATE_LIMIT_H
+
+#include <Arduino.h>
+#include "utility/strkey.h"
+
+/**
+ * @brief Counters of rate limiter decisions.
+ */
+struct RateLimitStats {
+    uint32_t allowed = 0;
+    uint32_t droppedSender = 0; // sender bucket was empty
+    uint32_t droppedGlobal = 0; // sender was within limit, global bucket was empty
+    uint32_t evictions = 0;     // senders replaced in full table
+};
+
+/**
+ * @brief Token bucket state of one sender.
+ * 
+ * Phone number is stored as 32-bit hash to keep the table small.
+ * Senders with colliding hashes share one bucket.
+ */
+struct RateLimitSlot {
+    uint32_t key = 0;
+    unsigned long lastRefill = 0;
+    unsigned long lastSeen = 0;
+    uint8_t tokens = 0;
+    bool used = false;
+};
+
+/**
+ * @brief Rate limiter logic shared by all table sizes.
+ * 
+ * Every sender owns a bucket of burst tokens, one token is added every refill period.
+ * Global bucket limits all senders together. Message is allowed only if both buckets
+ * have a token, then one token is taken from each of them.
+ */
+class RateLimiterBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        bool allow(const char* pPhoneNum);
+        void setSenderLimit(uint8_t burst, unsigned long refillMs);
+        void setGlobalLimit(uint8_t burst, unsigned long refillMs);
+        void setClock(ClockFn clockFn);
+        void reset();
+        RateLimitStats getStats();
+
+    protected:
+        RateLimiterBase(RateLimitSlot* pSlots, uint8_t numOfSlots);
+
+    private:
+        static void refill(uint8_t* pTokens, unsigned long* pLastRefill, unsigned long now,
+                           uint8_t burst, unsigned long refillMs);
+        RateLimitSlot* findSlot(uint32_t key, unsigned long now);
+
+        RateLimitSlot* _pSlots;
+        uint8_t _numOfSlots;
+
+        uint8_t _senderBurst = 3;
+        unsigned long _senderRefillMs = 60000;
+        uint8_t _globalBurst = 10;
+        unsigned long _globalRefillMs = 6000;
+        uint8_t _globalTokens;
+        unsigned long _globalLastRefill;
+
+        ClockFn _clockFn = millis;
+        RateLimitStats _stats;
+};
+
+/**
+ * @brief Rate limiter with compile-time size of sender table.
+ * @tparam SLOTS is number of senders tracked at the same time.
+ * 
+ * Use the RateLimiter alias for default size. Default limits are 3 messages
+ * per sender with one more every minute and 10 messages in total with one more
+ * every 6 seconds.
+ */
+template<uint8_t SLOTS = 4>
+class BasicRateLimiter : public RateLimiterBase {
+    static_assert(SLOTS > 0, "SLOTS must be at least 1");
+
+    public:
+        BasicRateLimiter() : RateLimiterBase(_slots, SLOTS){}
+
+    private:
+        RateLimitSlot _slots[SLOTS];
+};
+
+using RateLimiter = BasicRateLimiter<>;
+
+#endif // ADEON_RATE_LIMIT_H
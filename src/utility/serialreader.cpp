@@ -0,0 +1,275 @@
+/**
+ *  @file       serialreader.cpp
+ *  Project     AdeonGSM
+ *  @brief      Background reader of GSM serial
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/serialreader.h"
+
+#ifdef SERIAL_READER_THREAD
+
+#include <chrono>
+
+/**
+ * @brief Constructor for the class SerialReaderBase.
+ * @param pSource is a pointer to stream of the modem.
+ * @param pBuffer is a pointer to ring buffer.
+ * @param size is size of ring buffer.
+ */
+SerialReaderBase::SerialReaderBase(Stream* pSource, uint8_t* pBuffer, uint16_t size){
+    _pSource = pSource;
+    _pBuffer = pBuffer;
+    _size = size;
+}
+
+#ifdef POSIX_SERIAL
+/**
+ * @brief Constructor for the class SerialReaderBase, thread sleeps in epoll of the source.
+ * @param pSource is a pointer to serial device of the modem.
+ * @param pBuffer is a pointer to ring buffer.
+ * @param size is size of ring buffer.
+ */
+SerialReaderBase::SerialReaderBase(PosixSerial* pSource, uint8_t* pBuffer, uint16_t size)
+  : SerialReaderBase(static_cast<Stream*>(pSource), pBuffer, size){
+    _pPosixSource = pSource;
+}
+#endif
+
+#ifdef ESP32
+/**
+ * @brief Constructor for the class SerialReaderBase, thread sleeps until the UART driver receives bytes.
+ * @param pSource is a pointer to hardware serial of the modem, e.g. &Serial2.
+ * @param pBuffer is a pointer to ring buffer.
+ * @param size is size of ring buffer.
+ */
+SerialReaderBase::SerialReaderBase(HardwareSerial* pSource, uint8_t* pBuffer, uint16_t size)
+  : SerialReaderBase(static_cast<Stream*>(pSource), pBuffer, size){
+    _pUartSource = pSource;
+}
+
+/**
+ * @brief Wake the thread, called by the UART driver task when bytes are received.
+ */
+void SerialReaderBase::notifySource(){
+    {
+        std::lock_guard<std::mutex> guard(_sourceLock);
+        _sourceSignal = true;
+    }
+    _sourceReady.notify_one();
+}
+#endif
+
+/**
+ * @brief Destructor stops the thread.
+ */
+SerialReaderBase::~SerialReaderBase(){
+    stop();
+}
+
+/**
+ * @brief Start the background thread.
+ * @return <code>true</code> if thread is started, <code>false</code> if it is already running.
+ */
+bool SerialReaderBase::start(){
+    if(_running){
+        return false;
+    }
+    _running = true;
+    #ifdef ESP32
+    if(_pUartSource != nullptr){
+        _pUartSource->onReceive([this](){ notifySource(); });
+    }
+    #endif
+    _thread = std::thread(&SerialReaderBase::run, this);
+    return true;
+}
+
+/**
+ * @brief Stop the background thread and wait for it. Buffered bytes stay readable.
+ */
+void SerialReaderBase::stop(){
+    _running = false;
+    if(_thread.joinable()){
+        _thread.join();
+    }
+    #ifdef ESP32
+    if(_pUartSource != nullptr){
+        _pUartSource->onReceive(nullptr);
+    }
+    #endif
+}
+
+/**
+ * @brief State of the background thread.
+ * @return <code>true</code> if thread is running, <code>false</code> otherwise.
+ */
+bool SerialReaderBase::isRunning(){
+    return _running;
+}
+
+/**
+ * @brief Sleep until bytes are published or timeout expires.
+ * @param timeoutMs is maximum time of waiting in ms.
+ * @return <code>true</code> if bytes are available, <code>false</code> otherwise.
+ */
+bool SerialReaderBase::waitForData(unsigned long timeoutMs){
+    std::unique_lock<std::mutex> lock(_lock);
+    return _dataReady.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]{ return _ready > 0; });
+}
+
+/**
+ * @brief Set quiet time of the line after which received bytes are published.
+ * @param idleTime is time in ms (default SERIAL_READER_IDLE_TIME).
+ * 
+ * Time must be longer than pauses inside one answer of the modem.
+ */
+void SerialReaderBase::setIdleTime(uint16_t idleTime){
+    std::lock_guard<std::mutex> guard(_lock);
+    _idleTime = idleTime;
+}
+
+/**
+ * @brief Get number of bytes lost because the ring buffer was full.
+ * @return number of dropped bytes.
+ */
+uint32_t SerialReaderBase::getDroppedBytes(){
+    std::lock_guard<std::mutex> guard(_lock);
+    return _dropped;
+}
+
+int SerialReaderBase::available(){
+    std::lock_guard<std::mutex> guard(_lock);
+    return _ready;
+}
+
+int SerialReaderBase::read(){
+    std::lock_guard<std::mutex> guard(_lock);
+    if(_ready == 0){
+        return -1;
+    }
+    uint8_t c = _pBuffer[_head];
+    _head = (_head + 1) % _size;
+    _count--;
+    _ready--;
+    return c;
+}
+
+int SerialReaderBase::peek(){
+    std::lock_guard<std::mutex> guard(_lock);
+    return (_ready > 0) ? _pBuffer[_head] : -1;
+}
+
+size_t SerialReaderBase::write(uint8_t c){
+    return _pSource->write(c);
+}
+
+size_t SerialReaderBase::write(const uint8_t* buffer, size_t size){
+    return _pSource->write(buffer, size);
+}
+
+void SerialReaderBase::flush(){
+    _pSource->flush();
+}
+
+/**
+ * @brief Loop of the background thread.
+ * 
+ * Bytes are stored as they come and published together when the line is quiet
+ * for the idle time, so the application is woken once per answer of the modem.
+ */
+void SerialReaderBase::run(){
+    uint8_t chunk[64];
+    unsigned long lastByteTime = 0;
+    bool pending = false;
+    while(_running){
+        int timeout = 50; //ms, stop() is noticed within this time
+        if(pending){
+            unsigned long quiet = millis() - lastByteTime;
+            timeout = (quiet < _idleTime) ? (int)(_idleTime - quiet) : 0;
+        }
+        waitForSource(timeout);
+
+        uint16_t n = 0;
+        while(n < sizeof(chunk) && _pSource->available() > 0){
+            int c = _pSource->read();
+            if(c < 0){
+                break;
+            }
+            chunk[n++] = c;
+        }
+
+        unsigned long now = millis();
+        std::lock_guard<std::mutex> guard(_lock);
+        if(n > 0){
+            lastByteTime = now;
+            for(uint16_t i = 0; i < n; i++){
+                if(_count < _size){
+                    _pBuffer[(_head + _count) % _size] = chunk[i];
+                    _count++;
+                }
+                else{
+                    _dropped++;
+                }
+            }
+        }
+        pending = _count > _ready;
+        if(pending && (now - lastByteTime) >= _idleTime){
+            _ready = _count;
+            pending = false;
+            _dataReady.notify_all();
+        }
+    }
+}
+
+/**
+ * @brief Wait until source has bytes.
+ * @param timeoutMs is maximum time of waiting in ms.
+ * @return <code>true</code> if bytes are available, <code>false</code> otherwise.
+ * 
+ * PosixSerial is waited for in epoll, HardwareSerial of ESP32 wakes the thread by its
+ * receive callback. Other streams have no wake-up, they are checked every 1 ms.
+ */
+bool SerialReaderBase::waitForSource(int timeoutMs){
+    #ifdef POSIX_SERIAL
+    if(_pPosixSource != nullptr){
+        return _pPosixSource->waitForData(timeoutMs);
+    }
+    #endif
+    #ifdef ESP32
+    if(_pUartSource != nullptr){
+        std::unique_lock<std::mutex> lock(_sourceLock);
+        _sourceReady.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [this]{ return _sourceSignal || _pSource->available() > 0; });
+        _sourceSignal = false;
+        return _pSource->available() > 0;
+    }
+    #endif
+    unsigned long start = millis();
+    while(_pSource->available() <= 0){
+        if((long)(millis() - start) >= timeoutMs){
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+#endif // SERIAL_READER_THREAD
@@ -0,0 +1,141 @@
+/**
+ *  @file       serialreader.h
+ *  Project     AdeonGSM
+ *  @brief      Background reader of GSM serial
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_SERIAL_READER_H
+#define ADEON_SERIAL_READER_H
+
+#include <Arduino.h>
+#include "utility/SIMlib.h"
+
+#if defined(ESP32) || defined(POSIX_SERIAL)
+    #define SERIAL_READER_THREAD
+    #include <atomic>
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+#endif
+
+#ifdef SERIAL_READER_THREAD
+
+constexpr static auto SERIAL_READER_BUFFER = 512;
+constexpr static auto SERIAL_READER_IDLE_TIME = 20; //ms, line quiet time which ends an answer
+
+/**
+ * @brief Stream filled by a background thread.
+ * 
+ * Thread waits for bytes of the source stream (in epoll for PosixSerial, woken by
+ * HardwareSerial::onReceive() on ESP32) and stores them into the ring buffer. Bytes are published when the line has been quiet for the idle time,
+ * then waitForData() wakes up the application. GSM gets whole answers without settle
+ * time, so it is used with GSMBase::setImmediateRead(true).
+ * On ESP32 the thread is a FreeRTOS task created by std::thread.
+ */
+class SerialReaderBase : public Stream {
+    public:
+        ~SerialReaderBase();
+
+        bool start();
+        void stop();
+        bool isRunning();
+        bool waitForData(unsigned long timeoutMs);
+        void setIdleTime(uint16_t idleTime);
+        uint32_t getDroppedBytes();
+
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+        void flush() override;
+
+    protected:
+        SerialReaderBase(Stream* pSource, uint8_t* pBuffer, uint16_t size);
+        #ifdef POSIX_SERIAL
+        SerialReaderBase(PosixSerial* pSource, uint8_t* pBuffer, uint16_t size);
+        #endif
+        #ifdef ESP32
+        SerialReaderBase(HardwareSerial* pSource, uint8_t* pBuffer, uint16_t size);
+        #endif
+
+    private:
+        SerialReaderBase(const SerialReaderBase&) = delete;
+        SerialReaderBase& operator=(const SerialReaderBase&) = delete;
+
+        void run();
+        bool waitForSource(int timeoutMs);
+
+        Stream* _pSource;
+        #ifdef POSIX_SERIAL
+        PosixSerial* _pPosixSource = nullptr;
+        #endif
+        #ifdef ESP32
+        void notifySource();
+
+        HardwareSerial* _pUartSource = nullptr;
+        std::mutex _sourceLock;
+        std::condition_variable _sourceReady; // signalled by receive callback of the UART driver
+        bool _sourceSignal = false;
+        #endif
+        uint8_t* _pBuffer;
+        uint16_t _size;
+        uint16_t _head = 0;
+        uint16_t _count = 0; // bytes in buffer
+        uint16_t _ready = 0; // bytes published to the application
+        uint16_t _idleTime = SERIAL_READER_IDLE_TIME;
+        uint32_t _dropped = 0;
+
+        std::mutex _lock;
+        std::condition_variable _dataReady;
+        std::atomic<bool> _running{false};
+        std::thread _thread;
+};
+
+/**
+ * @brief Background reader with compile-time buffer size.
+ * @tparam SIZE is number of bytes buffered between the source stream and the application.
+ * 
+ * Use the SerialReader alias for default size.
+ */
+template<uint16_t SIZE = SERIAL_READER_BUFFER>
+class BasicSerialReader : public SerialReaderBase {
+    static_assert(SIZE > 0, "SIZE must be at least 1");
+
+    public:
+        BasicSerialReader(Stream* pSource) : SerialReaderBase(pSource, _buffer, SIZE){}
+        #ifdef POSIX_SERIAL
+        BasicSerialReader(PosixSerial* pSource) : SerialReaderBase(pSource, _buffer, SIZE){}
+        #endif
+        #ifdef ESP32
+        BasicSerialReader(HardwareSerial* pSource) : SerialReaderBase(pSource, _buffer, SIZE){}
+        #endif
+
+    private:
+        uint8_t _buffer[SIZE];
+};
+
+using SerialReader = BasicSerialReader<>;
+
+#endif // SERIAL_READER_THREAD
+
+#endif // ADEON_SERIAL_READER_H
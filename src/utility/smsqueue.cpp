@@ -0,0 +1,264 @@
+/**
+ *  @file       smsqueue.cpp
+ *  Project     AdeonGSM
+ *  @brief      Queue of outgoing SMS
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/smsqueue.h"
+
+/**
+ * @brief Constructor for the class SmsQueueBase.
+ * @param pSlots is pointer to SMS table.
+ * @param pTexts is pointer to text storage, textSize bytes for each slot.
+ * @param numOfSlots is number of entries in SMS table.
+ * @param textSize is size of text buffer of one slot including null terminator.
+ */
+SmsQueueBase::SmsQueueBase(SmsSlot* pSlots, char* pTexts, uint8_t numOfSlots, uint8_t textSize){
+    _pSlots = pSlots;
+    _pTexts = pTexts;
+    _numOfSlots = numOfSlots;
+    _textSize = textSize;
+}
+
+/**
+ * @brief Queue text for recipient.
+ * @param pPhoneNum is pointer to phone number string of recipient.
+ * @param pText is pointer to text string.
+ * @return <code>true</code> if text is queued, <code>false</code> if it is dropped.
+ * 
+ * Text is appended to SMS of the same recipient waiting in coalescing window, if it fits.
+ * Nothing is sent here, GSM sends the queue from poll().
+ */
+bool SmsQueueBase::send(const char* pPhoneNum, const char* pText){
+    if(pPhoneNum == nullptr || pText == nullptr){
+        _stats.dropped++;
+        return false;
+    }
+    size_t length = strlen(pText);
+    if(length == 0 || length >= _textSize || strlen(pPhoneNum) >= SMS_PHONE_LENGTH){
+        _stats.dropped++;
+        return false;
+    }
+
+    unsigned long now = _clockFn();
+    SmsSlot* pFree = nullptr;
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        SmsSlot* pSlot = &_pSlots[i];
+        if(!pSlot->used){
+            if(pFree == nullptr){
+                pFree = pSlot;
+            }
+            continue;
+        }
+        if(pSlot->sending || pSlot->attempts > 0 || (long)(now - pSlot->dueTime) >= 0
+           || strcmp(pSlot->phone, pPhoneNum) != 0){
+            continue;
+        }
+        if(pSlot->length + 1 + length < _textSize){
+            char* pSlotText = getText(i);
+            pSlotText[pSlot->length] = '\n';
+            memcpy(pSlotText + pSlot->length + 1, pText, length + 1);
+            pSlot->length += 1 + length;
+            _stats.queued++;
+            _stats.coalesced++;
+            return true;
+        }
+    }
+    if(pFree == nullptr){
+        _stats.dropped++;
+        return false;
+    }
+
+    strcpy(pFree->phone, pPhoneNum);
+    memcpy(getText(pFree - _pSlots), pText, length + 1);
+    pFree->length = length;
+    pFree->queuedTime = now;
+    pFree->dueTime = now + _window;
+    pFree->attempts = 0;
+    pFree->sending = false;
+    pFree->used = true;
+    _stats.queued++;
+    return true;
+}
+
+/**
+ * @brief Get number of SMS in queue.
+ * @return Number of SMS waiting or being sent.
+ */
+uint8_t SmsQueueBase::getDepth(){
+    uint8_t depth = 0;
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        if(_pSlots[i].used){
+            depth++;
+        }
+    }
+    return depth;
+}
+
+/**
+ * @brief Set time for which SMS waits for more texts to the same recipient.
+ * @param window is time in ms (0 sends every text as separate SMS).
+ */
+void SmsQueueBase::setCoalesceWindow(unsigned long window){
+    _window = window;
+}
+
+/**
+ * @brief Replace time source.
+ * @param clockFn is pointer to function returning time in ms (millis by default).
+ */
+void SmsQueueBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+}
+
+/**
+ * @brief Forget all queued SMS. Counters are kept.
+ * 
+ * SMS which is being sent is finished by GSM but not retried.
+ */
+void SmsQueueBase::reset(){
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        _pSlots[i].used = false;
+        _pSlots[i].sending = false;
+    }
+    _sending = -1;
+}
+
+/**
+ * @brief Get counters of outgoing SMS.
+ * @return Copy of counters.
+ */
+SmsQueueStats SmsQueueBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Take the oldest SMS which is due for sending.
+ * @return <code>true</code> if SMS is taken, <code>false</code> if nothing is due.
+ */
+bool SmsQueueBase::startNext(){
+    if(_sending >= 0){
+        return false;
+    }
+    unsigned long now = _clockFn();
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        SmsSlot* pSlot = &_pSlots[i];
+        if(!pSlot->used || (long)(now - pSlot->dueTime) < 0){
+            continue;
+        }
+        if(_sending < 0 || (now - pSlot->queuedTime) > (now - _pSlots[_sending].queuedTime)){
+            _sending = i;
+        }
+    }
+    if(_sending < 0){
+        return false;
+    }
+    _pSlots[_sending].sending = true;
+    return true;
+}
+
+/**
+ * @brief Get recipient of SMS being sent.
+ * @return Pointer to phone number string.
+ */
+const char* SmsQueueBase::getSendingPhoneNum(){
+    return (_sending < 0) ? "" : _pSlots[_sending].phone;
+}
+
+/**
+ * @brief Get text of SMS being sent.
+ * @return Pointer to text string.
+ */
+const char* SmsQueueBase::getSendingText(){
+    return (_sending < 0) ? "" : getText(_sending);
+}
+
+/**
+ * @brief Record result of sending.
+ * @param sent is <code>true</code> if modem confirmed the SMS.
+ * 
+ * Failed SMS is retried after SMS_RETRY_TIME until SMS_SEND_ATTEMPTS are used.
+ */
+void SmsQueueBase::finishSending(bool sent){
+    if(_sending < 0){
+        return;
+    }
+    uint8_t index = _sending;
+    SmsSlot* pSlot = &_pSlots[index];
+    unsigned long now = _clockFn();
+    _sending = -1;
+    pSlot->sending = false;
+
+    if(sent){
+        _stats.sent++;
+        _stats.lastLatency = now - pSlot->queuedTime;
+        if(_stats.lastLatency > _stats.maxLatency){
+            _stats.maxLatency = _stats.lastLatency;
+        }
+        freeSlot(index);
+        return;
+    }
+    pSlot->attempts++;
+    if(pSlot->attempts >= SMS_SEND_ATTEMPTS){
+        _stats.failed++;
+        freeSlot(index);
+        return;
+    }
+    pSlot->dueTime = now + SMS_RETRY_TIME;
+}
+
+/**
+ * @brief Get time when the next SMS is due.
+ * @param pTime is pointer where the time in ms is stored.
+ * @return <code>true</code> if some SMS waits, <code>false</code> if queue is idle.
+ */
+bool SmsQueueBase::getNextDueTime(unsigned long* pTime){
+    bool found = false;
+    for(uint8_t i = 0; i < _numOfSlots; i++){
+        SmsSlot* pSlot = &_pSlots[i];
+        if(!pSlot->used || pSlot->sending){
+            continue;
+        }
+        if(!found || (long)(pSlot->dueTime - *pTime) < 0){
+            *pTime = pSlot->dueTime;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Get text buffer of slot.
+ * @param index is slot index.
+ * @return Pointer to text buffer.
+ */
+char* SmsQueueBase::getText(uint8_t index){
+    return _pTexts + index * _textSize;
+}
+
+/**
+ * @brief Release slot.
+ * @param index is slot index.
+ */
+void SmsQueueBase::freeSlot(uint8_t index){
+    _pSlots[index].used = false;
+    _pSlots[index].length = 0;
+}
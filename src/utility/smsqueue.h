@@ -0,0 +1,127 @@
+/**
+ *  @file       smsqueue.h
+ *  Project     AdeonGSM
+ *  @brief      Queue of outgoing SMS
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_SMS_QUEUE_H
+#define ADEON_SMS_QUEUE_H
+
+#include <Arduino.h>
+
+constexpr static auto SMS_TEXT_LENGTH = 160;
+constexpr static auto SMS_PHONE_LENGTH = 17; // "+" and 15 digits of international number
+constexpr static auto SMS_SEND_ATTEMPTS = 3;
+constexpr static auto SMS_RETRY_TIME = 5000; //ms, pause after failed attempt
+
+/**
+ * @brief Counters of outgoing SMS.
+ */
+struct SmsQueueStats {
+    uint32_t queued = 0;        // texts accepted by send()
+    uint32_t coalesced = 0;     // texts appended to pending SMS of the same recipient
+    uint32_t sent = 0;          // SMS confirmed by modem
+    uint32_t failed = 0;        // SMS given up after SMS_SEND_ATTEMPTS
+    uint32_t dropped = 0;       // texts refused because queue was full or text too long
+    unsigned long lastLatency = 0; // ms from send() to confirmation of the last SMS
+    unsigned long maxLatency = 0;
+};
+
+/**
+ * @brief One outgoing SMS, its text is kept by the queue.
+ */
+struct SmsSlot {
+    char phone[SMS_PHONE_LENGTH] = {};
+    unsigned long queuedTime = 0;
+    unsigned long dueTime = 0;  // end of coalescing window or retry pause
+    uint8_t length = 0;
+    uint8_t attempts = 0;
+    bool used = false;
+    bool sending = false;
+};
+
+/**
+ * @brief Queue logic shared by all queue sizes.
+ * 
+ * SMS waits the coalescing window after its first text, texts for the same recipient
+ * which come meanwhile are joined by new line into one SMS. GSM sends the queue
+ * by AT+CMGS from poll(), oldest SMS first, failed SMS is retried.
+ */
+class SmsQueueBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        bool send(const char* pPhoneNum, const char* pText);
+        uint8_t getDepth();
+        void setCoalesceWindow(unsigned long window);
+        void setClock(ClockFn clockFn);
+        void reset();
+        SmsQueueStats getStats();
+
+    protected:
+        SmsQueueBase(SmsSlot* pSlots, char* pTexts, uint8_t numOfSlots, uint8_t textSize);
+
+    private:
+        friend class GSMBase;
+
+        bool startNext();
+        const char* getSendingPhoneNum();
+        const char* getSendingText();
+        void finishSending(bool sent);
+        bool getNextDueTime(unsigned long* pTime);
+
+        char* getText(uint8_t index);
+        void freeSlot(uint8_t index);
+
+        SmsSlot* _pSlots;
+        char* _pTexts;
+        uint8_t _numOfSlots;
+        uint8_t _textSize;
+        int8_t _sending = -1;
+        unsigned long _window = 1000; //ms
+
+        ClockFn _clockFn = millis;
+        SmsQueueStats _stats;
+};
+
+/**
+ * @brief SMS queue with compile-time size.
+ * @tparam SLOTS is number of SMS waiting at the same time.
+ * @tparam TEXT_LENGTH is maximum length of one SMS.
+ * 
+ * Use the SmsQueue alias for default size.
+ */
+template<uint8_t SLOTS = 2, uint8_t TEXT_LENGTH = SMS_TEXT_LENGTH>
+class BasicSmsQueue : public SmsQueueBase {
+    static_assert(SLOTS > 0 && SLOTS <= 127, "SLOTS must be 1 to 127");
+    static_assert(TEXT_LENGTH > 0 && TEXT_LENGTH < 255, "TEXT_LENGTH must be 1 to 254");
+
+    public:
+        BasicSmsQueue() : SmsQueueBase(_slots, _texts, SLOTS, TEXT_LENGTH + 1){}
+
+    private:
+        SmsSlot _slots[SLOTS];
+        char _texts[SLOTS * (TEXT_LENGTH + 1)];
+};
+
+using SmsQueue = BasicSmsQueue<>;
+
+#endif // ADEON_SMS_QUEUE_H
@@ -0,0 +1,48 @@
+/**
+ *  @file       strkey.h
+ *  Project     AdeonGSM
+ *  @brief      Compact keys of strings
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_STR_KEY_H
+#define ADEON_STR_KEY_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Make 32-bit key of string (FNV-1a hash).
+ * @param pStr is pointer to string (null gives key of empty string).
+ * @return Hash of the string.
+ * 
+ * Used by tables which store keys instead of whole phone numbers or hashes.
+ */
+inline uint32_t makeStrKey(const char* pStr){
+    uint32_t key = 2166136261UL;
+    if(pStr != nullptr){
+        while(*pStr != '\0'){
+            key ^= (uint8_t)*pStr++;
+            key *= 16777619UL;
+        }
+    }
+    return key;
+}
+
+#endif // ADEON_STR_KEY_H
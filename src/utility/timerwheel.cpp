@@ -0,0 +1,292 @@
+/**
+ *  @file       timerwheel.cpp
+ *  Project     AdeonGSM
+ *  @brief      Scheduled parameter edits
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utility/timerwheel.h"
+
+constexpr static uint8_t TIMER_EXPIRED = 0xFE; // slot of timers in the list of due timers
+constexpr static auto TIMER_SLOT_BITS = 4;    // log2 of TIMER_WHEEL_SLOTS
+
+static_assert((1 << TIMER_SLOT_BITS) == TIMER_WHEEL_SLOTS, "TIMER_SLOT_BITS must match TIMER_WHEEL_SLOTS");
+static_assert(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS < TIMER_EXPIRED, "slot index must fit into uint8_t");
+
+/**
+ * @brief Constructor for the class TimerWheelBase.
+ * @param pEntries is pointer to timers.
+ * @param numOfEntries is number of timers.
+ */
+TimerWheelBase::TimerWheelBase(TimerEntry* pEntries, uint8_t numOfEntries){
+    _pEntries = pEntries;
+    _numOfEntries = numOfEntries;
+    reset();
+}
+
+/**
+ * @brief Schedule edit of parameter.
+ * @param handle is reference to handle of parameter.
+ * @param val is value which is set when the delay elapses.
+ * @param delayMs is delay in ms, it is rounded up to whole ticks.
+ * @return <code>true</code> if edit is scheduled, <code>false</code> if all timers are pending.
+ *
+ * Edit already pending for the parameter is replaced.
+ */
+bool TimerWheelBase::schedule(ItemHandle& handle, uint16_t val, unsigned long delayMs){
+    unsigned long now = _clockFn();
+    if(_pending == 0){
+        _lastTick = now;
+    }
+    uint8_t index = findEntry(handle);
+    if(index != TIMER_NONE){
+        unlink(index);
+    }
+    else{
+        index = findFree();
+        if(index == TIMER_NONE){
+            _stats.rejected++;
+            return false;
+        }
+        _pending++;
+    }
+
+    //count from the last tick, so the edit never comes early
+    unsigned long ticks = (now - _lastTick + delayMs + _tickMs - 1) / _tickMs;
+    TimerEntry* pEntry = &_pEntries[index];
+    pEntry->handle = handle;
+    pEntry->val = val;
+    pEntry->expiry = _now + (ticks > 0 ? ticks : 1);
+    insert(index);
+    _stats.scheduled++;
+    return true;
+}
+
+/**
+ * @brief Remove edit pending for parameter.
+ * @param handle is reference to handle of parameter.
+ * @param pVal is pointer where value of removed edit is saved (can be null).
+ * @return <code>true</code> if edit has been pending, <code>false</code> otherwise.
+ */
+bool TimerWheelBase::cancel(ItemHandle& handle, uint16_t* pVal){
+    uint8_t index = findEntry(handle);
+    if(index == TIMER_NONE){
+        return false;
+    }
+    if(pVal != nullptr){
+        *pVal = _pEntries[index].val;
+    }
+    unlink(index);
+    _pending--;
+    _stats.cancelled++;
+    return true;
+}
+
+/**
+ * @brief Take the next due edit, the wheel is turned to the actual time.
+ * @param pHandle is pointer where handle of parameter is saved.
+ * @param pVal is pointer where value is saved.
+ * @return <code>true</code> if an edit is due, <code>false</code> otherwise.
+ *
+ * Call it until it returns <code>false</code>. Each tick handles one slot of level 0 and,
+ * when the level turns over, one slot of a higher level. Nothing is done if no edit is pending.
+ */
+bool TimerWheelBase::poll(ItemHandle* pHandle, uint16_t* pVal){
+    while(_expired == TIMER_NONE){
+        if(_pending == 0 || (_clockFn() - _lastTick) < _tickMs){
+            return false;
+        }
+        _lastTick += _tickMs;
+        advance();
+    }
+    uint8_t index = _expired;
+    unlink(index);
+    *pHandle = _pEntries[index].handle;
+    *pVal = _pEntries[index].val;
+    _pending--;
+    _stats.fired++;
+    return true;
+}
+
+/**
+ * @brief Get number of pending edits.
+ */
+uint8_t TimerWheelBase::getPending(){
+    return _pending;
+}
+
+/**
+ * @brief Set resolution of the wheel, it should be changed while no edit is pending.
+ * @param tickMs is length of one tick in ms (TIMER_WHEEL_TICK by default).
+ *
+ * Longest delay handled without waiting in the top level is
+ * tickMs * TIMER_WHEEL_SLOTS ^ TIMER_WHEEL_LEVELS.
+ */
+void TimerWheelBase::setTickLength(unsigned long tickMs){
+    _tickMs = (tickMs > 0) ? tickMs : 1;
+}
+
+/**
+ * @brief Replace time source.
+ * @param clockFn is pointer to function returning time in ms (millis by default).
+ */
+void TimerWheelBase::setClock(ClockFn clockFn){
+    _clockFn = clockFn;
+    _lastTick = _clockFn();
+}
+
+/**
+ * @brief Drop all pending edits. Counters are kept.
+ */
+void TimerWheelBase::reset(){
+    for(uint8_t i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++){
+        _slots[i] = TIMER_NONE;
+    }
+    for(uint8_t i = 0; i < _numOfEntries; i++){
+        _pEntries[i].slot = TIMER_NONE;
+    }
+    _expired = TIMER_NONE;
+    _pending = 0;
+    _now = 0;
+    _lastTick = _clockFn();
+}
+
+/**
+ * @brief Get counters of scheduled edits.
+ * @return Copy of counters.
+ */
+TimerStats TimerWheelBase::getStats(){
+    return _stats;
+}
+
+/**
+ * @brief Turn the wheel by one tick and move due timers to the list of due timers.
+ */
+void TimerWheelBase::advance(){
+    _now++;
+    uint8_t level = 0;
+    while(level + 1 < TIMER_WHEEL_LEVELS && (_now & ((1UL << (TIMER_SLOT_BITS * (level + 1))) - 1)) == 0){
+        level++;
+    }
+    //higher level first, its timers can fall into slot of a lower level turned over in this tick
+    for(; level > 0; level--){
+        cascade(level);
+    }
+
+    uint8_t* pSlot = &_slots[_now & (TIMER_WHEEL_SLOTS - 1)];
+    while(*pSlot != TIMER_NONE){
+        uint8_t index = *pSlot;
+        unlink(index);
+        TimerEntry* pEntry = &_pEntries[index];
+        pEntry->prev = TIMER_NONE;
+        pEntry->next = _expired;
+        if(_expired != TIMER_NONE){
+            _pEntries[_expired].prev = index;
+        }
+        _expired = index;
+        pEntry->slot = TIMER_EXPIRED;
+    }
+}
+
+/**
+ * @brief Move timers of the actual slot of level to lower levels.
+ * @param level is level of the wheel (1 or higher).
+ */
+void TimerWheelBase::cascade(uint8_t level){
+    uint8_t* pSlot = &_slots[level * TIMER_WHEEL_SLOTS + ((_now >> (TIMER_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1))];
+    while(*pSlot != TIMER_NONE){
+        uint8_t index = *pSlot;
+        unlink(index);
+        insert(index);
+        _stats.cascaded++;
+    }
+}
+
+/**
+ * @brief Put timer into the lowest level which covers its delay.
+ * @param index is index of timer with expiry set.
+ */
+void TimerWheelBase::insert(uint8_t index){
+    TimerEntry* pEntry = &_pEntries[index];
+    uint32_t delta = pEntry->expiry - _now;
+    uint8_t level = 0;
+    uint32_t span = TIMER_WHEEL_SLOTS; // ticks covered by levels up to this one
+    while(level + 1 < TIMER_WHEEL_LEVELS && delta >= span){
+        level++;
+        span <<= TIMER_SLOT_BITS;
+    }
+    //longer delay waits in the furthest slot of the top level and is inserted again from there
+    uint32_t at = (delta < span) ? pEntry->expiry : _now + span - (span >> TIMER_SLOT_BITS);
+    uint8_t slot = level * TIMER_WHEEL_SLOTS + ((at >> (TIMER_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1));
+
+    pEntry->slot = slot;
+    pEntry->prev = TIMER_NONE;
+    pEntry->next = _slots[slot];
+    if(_slots[slot] != TIMER_NONE){
+        _pEntries[_slots[slot]].prev = index;
+    }
+    _slots[slot] = index;
+}
+
+/**
+ * @brief Remove timer from its slot or from the list of due timers.
+ * @param index is index of linked timer.
+ */
+void TimerWheelBase::unlink(uint8_t index){
+    TimerEntry* pEntry = &_pEntries[index];
+    uint8_t* pHead = (pEntry->slot == TIMER_EXPIRED) ? &_expired : &_slots[pEntry->slot];
+    if(pEntry->prev == TIMER_NONE){
+        *pHead = pEntry->next;
+    }
+    else{
+        _pEntries[pEntry->prev].next = pEntry->next;
+    }
+    if(pEntry->next != TIMER_NONE){
+        _pEntries[pEntry->next].prev = pEntry->prev;
+    }
+    pEntry->slot = TIMER_NONE;
+}
+
+/**
+ * @brief Find timer pending for parameter.
+ * @param handle is reference to handle of parameter.
+ * @return Index of timer, TIMER_NONE if no edit is pending.
+ */
+uint8_t TimerWheelBase::findEntry(ItemHandle& handle){
+    for(uint8_t i = 0; i < _numOfEntries; i++){
+        if(_pEntries[i].slot != TIMER_NONE && _pEntries[i].handle.isSame(handle)){
+            return i;
+        }
+    }
+    return TIMER_NONE;
+}
+
+/**
+ * @brief Find timer which is not used.
+ * @return Index of timer, TIMER_NONE if all timers are pending.
+ */
+uint8_t TimerWheelBase::findFree(){
+    for(uint8_t i = 0; i < _numOfEntries; i++){
+        if(_pEntries[i].slot == TIMER_NONE){
+            return i;
+        }
+    }
+    return TIMER_NONE;
+}
@@ -0,0 +1,125 @@
+/**
+ *  @file       timerwheel.h
+ *  Project     AdeonGSM
+ *  @brief      Scheduled parameter edits
+ *  @author     JSC electronics
+ *  License     Apache-2.0 - Copyright (c) 2019 JSC electronics
+ *
+ *  @section License
+ *
+ *  Copyright (c) 2019 JSC electronics
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADEON_TIMERWHEEL_H
+#define ADEON_TIMERWHEEL_H
+
+#include <Arduino.h>
+#include "utility/list.h"
+
+constexpr static auto TIMER_WHEEL_LEVELS = 4;
+constexpr static auto TIMER_WHEEL_SLOTS = 16; // power of two
+constexpr static auto TIMER_WHEEL_TICK = 100; //ms, default resolution
+constexpr static uint8_t TIMER_NONE = 0xFF;
+
+/**
+ * @brief Counters of scheduled edits.
+ */
+struct TimerStats {
+    uint32_t scheduled = 0; // edits accepted by schedule()
+    uint32_t fired = 0;     // edits returned by poll()
+    uint32_t cancelled = 0; // edits removed by cancel()
+    uint32_t rejected = 0;  // edits refused because all timers were pending
+    uint32_t cascaded = 0;  // timers moved to a lower level of the wheel
+};
+
+/**
+ * @brief Pending edit, timers are linked in slots by index. Timer is free while its slot is TIMER_NONE.
+ */
+struct TimerEntry {
+    ItemHandle handle;
+    uint32_t expiry = 0; // tick in which the edit is due
+    uint16_t val = 0;
+    uint8_t next = TIMER_NONE;
+    uint8_t prev = TIMER_NONE;
+    uint8_t slot = TIMER_NONE; // index into slot heads, TIMER_NONE if free or expired
+};
+
+/**
+ * @brief Hierarchical timer wheel shared by all capacities.
+ *
+ * Level 0 has a slot for each of the next TIMER_WHEEL_SLOTS ticks, each higher level
+ * a slot for TIMER_WHEEL_SLOTS times longer period. Timer is put into the lowest level
+ * which covers its delay and moved down when the wheel turns over its slot, so one tick
+ * handles only a single slot no matter how many timers are pending. Delay longer than
+ * the top level is waited out in its furthest slot.
+ * At most one timer is pending per parameter, see cancel().
+ */
+class TimerWheelBase {
+    public:
+        typedef unsigned long (*ClockFn)();
+
+        bool schedule(ItemHandle& handle, uint16_t val, unsigned long delayMs);
+        bool cancel(ItemHandle& handle, uint16_t* pVal = nullptr);
+        bool poll(ItemHandle* pHandle, uint16_t* pVal);
+        uint8_t getPending();
+        void setTickLength(unsigned long tickMs);
+        void setClock(ClockFn clockFn);
+        void reset();
+        TimerStats getStats();
+
+    protected:
+        TimerWheelBase(TimerEntry* pEntries, uint8_t numOfEntries);
+
+    private:
+        void advance();
+        void cascade(uint8_t level);
+        void insert(uint8_t index);
+        void unlink(uint8_t index);
+        uint8_t findEntry(ItemHandle& handle);
+        uint8_t findFree();
+
+        TimerEntry* _pEntries;
+        uint8_t _numOfEntries;
+        uint8_t _slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+        uint8_t _expired = TIMER_NONE; // due timers, returned by poll() one by one
+        uint8_t _pending = 0;
+        uint32_t _now = 0; // ticks since start
+        unsigned long _lastTick = 0;
+        unsigned long _tickMs = TIMER_WHEEL_TICK;
+
+        ClockFn _clockFn = millis;
+        TimerStats _stats;
+};
+
+/**
+ * @brief Timer wheel with compile-time capacity.
+ * @tparam TIMERS is maximum number of pending edits.
+ *
+ * Use the TimerWheel alias for default capacity.
+ */
+template<uint8_t TIMERS = 8>
+class BasicTimerWheel : public TimerWheelBase {
+    static_assert(TIMERS > 0 && TIMERS < TIMER_NONE, "TIMERS must be 1 to 254");
+
+    public:
+        BasicTimerWheel() : TimerWheelBase(_entries, TIMERS){}
+
+    private:
+        TimerEntry _entries[TIMERS];
+};
+
+using TimerWheel = BasicTimerWheel<>;
+
+#endif // ADEON_TIMERWHEEL_H